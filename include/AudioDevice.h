@@ -93,6 +93,14 @@ class AudioDevice
     {
     }
 
+    // called by processNextBuffer(), file devices queue the buffer for
+    // their encoder thread instead of writing it at once
+    virtual void deliverBuffer(const surroundSampleFrame* _buf,
+                               const fpp_t                _frames)
+    {
+        writeBuffer(_buf, _frames);
+    }
+
     // called by according driver for fetching new sound-data
     fpp_t getNextBuffer(surroundSampleFrame* _ab);
 
@@ -0,0 +1,84 @@
+/*
+ * AudioEncoderThread.h - encodes the periods of a file device in the
+ *                        background
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef AUDIO_ENCODER_THREAD_H
+#define AUDIO_ENCODER_THREAD_H
+
+#include "lmms_basics.h"
+
+#include <QSemaphore>
+#include <QThread>
+
+#include <atomic>
+
+class AudioFileDevice;
+
+// The render thread copies each period into a ring and the encoder thread
+// passes it to the writeBuffer() of the device. Only one thread pushes.
+// The read and write counters are atomics, the semaphores are only there
+// to sleep: the encoder when the ring is empty, the render thread when
+// the ring is full (back-pressure).
+class AudioEncoderThread : public QThread
+{
+  public:
+    AudioEncoderThread(AudioFileDevice* _device,
+                       const fpp_t      _frames,
+                       const int        _periods);
+    virtual ~AudioEncoderThread();
+
+    // called by the render thread, waits while the ring is full
+    void push(const surroundSampleFrame* _buf, const fpp_t _frames);
+
+    // encodes the periods left in the ring and ends the thread
+    void finish();
+
+    int stalls() const
+    {
+        return m_stalls;
+    }
+
+  protected:
+    virtual void run();
+
+  private:
+    struct Period
+    {
+        surroundSampleFrame* buffer;
+        fpp_t                frames;
+    };
+
+    AudioFileDevice* m_device;
+    const fpp_t      m_frames;
+    const int        m_size;
+    Period*          m_ring;
+
+    std::atomic<int> m_write;
+    std::atomic<int> m_read;
+    QSemaphore       m_free;
+    QSemaphore       m_used;
+
+    int m_pushed;
+    int m_stalls;
+};
+
+#endif
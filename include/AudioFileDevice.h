@@ -29,15 +29,30 @@
 #include "AudioDevice.h"
 
 #include <QFile>
+#include <QVector>
 
 #include "OutputSettings.h"
 
+class AudioEncoderThread;
+class ValueBuffer;
+
 
 class AudioFileDevice : public AudioDevice
 {
 public:
 	virtual ~AudioFileDevice();
 
+	// write a buffer captured outside of the mixer output (a stem from an
+	// audio port or an fx channel), NULL writes silence. Does nothing
+	// until the device is capturing.
+	void writeCaptured( const sampleFrame* _buf, const fpp_t _frames,
+			    const real_t _gain = 1.,
+			    const ValueBuffer* _gains = NULL );
+
+	// the capture buffers are allocated here, for the current period
+	// size, not by the threads writing the stems
+	void setCapturing( bool _on );
+
 	QString outputFile() const
 	{
 		return m_outputFile ? m_outputFile->fileName() : "-";
@@ -45,6 +60,25 @@ public:
 
 	OutputSettings const & getOutputSettings() const { return m_outputSettings; }
 
+	// encode in a background thread: the render thread only copies the
+	// periods into a ring, and waits when the encoder falls behind.
+	// Does nothing if disabled in the settings (mixer/backgroundencoding).
+	void startEncoder();
+	// waits until every queued period is written
+	void stopEncoder();
+
+	// another device (another format) receiving the same periods, not
+	// owned. Its encoder is started and stopped with this one.
+	void addMirror( AudioFileDevice* _dev )
+	{
+		m_mirrors.append( _dev );
+	}
+
+	void clearMirrors()
+	{
+		m_mirrors.clear();
+	}
+
 protected:
 	AudioFileDevice(OutputSettings const & outputSettings,
 			const ch_cnt_t _channels, const QString & _file,
@@ -58,11 +92,25 @@ protected:
 
 	virtual int  writeData( const void* data, int len );
 
+	virtual void deliverBuffer( const surroundSampleFrame* _buf,
+				    const fpp_t _frames );
+
 	const QString& m_outputFileName;
 	QFile*   m_outputFile;
 	bool     m_useTmpFile;
 	bool     m_useStdout;
 	OutputSettings m_outputSettings;
+
+private:
+	friend class AudioEncoderThread;
+
+	AudioEncoderThread* m_encoder;
+	QVector<AudioFileDevice*> m_mirrors;
+
+	volatile bool m_capturing;
+	fpp_t m_captureFrames;
+	surroundSampleFrame* m_captureBuffer;
+	surroundSampleFrame* m_resampleBuffer;
 } ;
 
 
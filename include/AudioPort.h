@@ -31,11 +31,14 @@
 //#include <QMutexLocker>
 
 #include "AutomatableModel.h"
+#include "CompensationDelay.h"
 #include "MemoryManager.h"
 #include "PlayHandle.h"
+#include "PlayHandleRegistry.h"
 #include "SafeList.h"
 #include "ThreadableJob.h"
 
+class AudioFileDevice;
 class AudioPort;
 class EffectChain;
 class SampleBuffer;
@@ -113,6 +116,27 @@ class AudioPort : public ThreadableJob
 
     bool processEffects();
 
+    // latency of what plays into the port, ie. the instrument
+    INLINE void setSourceLatency(f_cnt_t _latency)
+    {
+        m_sourceLatency = _latency;
+    }
+
+    // source latency plus the latency of the effects, as computed by
+    // updateLatency() for the current period
+    INLINE f_cnt_t latency() const
+    {
+        return m_latency;
+    }
+
+    void updateLatency();
+
+    // delay aligning the output with the other inputs of the fx channel
+    INLINE void setCompensation(f_cnt_t _delay)
+    {
+        m_compensation.setDelay(_delay);
+    }
+
     virtual bool requiresProcessing() const final
     {
         // return !m_playHandles.isEmpty();
@@ -142,6 +166,12 @@ class AudioPort : public ThreadableJob
     void readFrozenBuffer(QString _uuid);
     void writeFrozenBuffer(QString _uuid);
 
+    // receives a copy of the output while rendering stems
+    void setStemDevice(AudioFileDevice* _dev)
+    {
+        m_stemDevice = _dev;
+    }
+
     virtual AudioPortPointer& pointer()
     {
         return *m_pointer;
@@ -156,6 +186,8 @@ class AudioPort : public ThreadableJob
     virtual void doProcessing() final;
 
   private:
+    void writeStem(bool _hasOutput);
+
     volatile bool m_bufferUsage;
     sampleFrame*  m_portBuffer;
     // QMutex                      m_portBufferLock;
@@ -164,7 +196,7 @@ class AudioPort : public ThreadableJob
     fx_ch_t                     m_nextFxChannel;
     QString                     m_name;
     EffectChain*                m_effects;
-    SafeList<PlayHandlePointer> m_playHandles;
+    PlayHandleRegistry          m_playHandles;
     BoolModel*                  m_volumeEnabledModel;
     RealModel*                  m_volumeModel;
     BoolModel*                  m_panningEnabledModel;
@@ -175,7 +207,11 @@ class AudioPort : public ThreadableJob
     BoolModel*                  m_frozenModel;
     BoolModel*                  m_clippingModel;
     SampleBuffer*               m_frozenBuf;
+    AudioFileDevice*            m_stemDevice;
     AudioPortPointer*           m_pointer;
+    volatile f_cnt_t            m_sourceLatency;
+    f_cnt_t                     m_latency;
+    CompensationDelay           m_compensation;
 
     friend class Mixer;
     friend class MixerWorkerThread;
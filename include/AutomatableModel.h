@@ -37,6 +37,8 @@
 #include <QMutex>
 #include <QString>
 
+#include <atomic>
+
 // simple way to map a property of a view to a model
 #define mapPropertyFromModelPtr(type, getfunc, setfunc, modelname) \
   public:                                                          \
@@ -63,12 +65,22 @@
     }
 
 class AutomatableModel;
+class AutomationPattern;
 class ControllerConnection;
 class WaveFormStandard;
 
 typedef QVector<AutomatableModel*>      AutomatableModels;
 typedef QMap<AutomatableModel*, real_t> AutomatedValueMap;
 
+// the pattern driving an automated model and the position in it, the
+// values themselves are rendered later for a whole period
+struct AutomatedSource
+{
+    AutomationPattern* pattern;
+    tick_t             time;  // relative to the start of the pattern
+};
+typedef QMap<AutomatableModel*, AutomatedSource> AutomatedSourceMap;
+
 class EXPORT AutomatableModel : public Model, public JournallingObject
 {
     Q_OBJECT
@@ -358,6 +370,10 @@ class EXPORT AutomatableModel : public Model, public JournallingObject
     static void resetPeriodCounter();
     static void postponeUpdate(AutomatableModel* _m, const ValueBuffer* _vb);
 
+    // emits dataChanged() for the models changed by the audio threads
+    // since the last call. Called by a timer of the GUI thread.
+    static void flushDirtyModels();
+
     // tmp
     AutomatableModels m_linkedModels;
 
@@ -418,6 +434,9 @@ class EXPORT AutomatableModel : public Model, public JournallingObject
     void linkModel(AutomatableModel* model, bool propagate);
     void unlinkModel(AutomatableModel* model);
 
+    // the automated value changed, the views are told later
+    void markDirty();
+
     //! @brief Scales @value from linear to logarithmic.
     //! Value should be within [0,1]
     // template <typename T>
@@ -457,8 +476,11 @@ class EXPORT AutomatableModel : public Model, public JournallingObject
     long        m_lastUpdatedPeriod;
     static long s_periodCounter;
 
-    bool   m_hasSampleExactData;
-    QMutex m_valueBufferMutex;
+    std::atomic<bool> m_hasSampleExactData;
+    QMutex            m_valueBufferMutex;
+
+    // set by markDirty(), cleared by flushDirtyModels()
+    std::atomic<bool> m_dirty;
 
     static QHash<AutomatableModel*, const ValueBuffer*> s_postponedUpdates;
 };
@@ -193,6 +193,17 @@ class EXPORT AutomationPattern : public Tile
     // insert the values from the models into the map
     virtual void automatedValuesAt(const MidiTime&    _time,
                                    AutomatedValueMap& _map);
+    // insert this pattern as the source of the models into the map
+    virtual void automatedSourcesAt(const MidiTime&     _time,
+                                    AutomatedSourceMap& _map);
+
+    // render _frames values from _time by steps of _step (both in ticks).
+    // Only for the audio thread: consecutive calls walk the segments with
+    // a cursor instead of searching the map for every value.
+    void renderValues(real_t  _time,
+                      real_t  _step,
+                      real_t* _values,
+                      fpp_t   _frames) const;
 
     virtual QString name() const;
 
@@ -279,6 +290,12 @@ class EXPORT AutomationPattern : public Tile
     real_t valueAt(timeMap::const_iterator v,
                    int                     offset,
                    bool                    xruns = false) const;
+    real_t valueAt(const timeMap&          _map,
+                   const timeMap&          _tangents,
+                   timeMap::const_iterator v,
+                   real_t                  offset,
+                   bool                    xruns) const;
+    real_t cursorValueAt(real_t _time, bool _xruns) const;
 
     AutomationTrack* m_automationTrack;
     QVector<jo_id_t> m_idsToResolve;
@@ -289,6 +306,12 @@ class EXPORT AutomationPattern : public Tile
                                  // setDragValue() is called.
     timeMap m_tangents;          // slope at each point for calculating spline
 
+    // renderValues() works on shared copies of the maps, so an edit from
+    // the GUI detaches m_timeMap and never invalidates the cursor
+    mutable timeMap                 m_cursorMap;
+    mutable timeMap                 m_cursorTangents;
+    mutable timeMap::const_iterator m_cursor;
+
     real_t m_tension;
     int    m_waveBank;
     int    m_waveIndex;
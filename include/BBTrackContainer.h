@@ -85,6 +85,9 @@ class EXPORT BBTrackContainer : public TrackContainer
     void automatedValuesAt(MidiTime           time,
                            int                tcoNum,
                            AutomatedValueMap& _map) const override;
+    void automatedSourcesAt(MidiTime            time,
+                            int                 tcoNum,
+                            AutomatedSourceMap& _map) const override;
 
     // BBTracks bbTracks();
     BBTracks bbTracks() const;
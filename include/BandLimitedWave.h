@@ -36,6 +36,7 @@ class QString;
 #include "lmms_basics.h"
 #include "lmms_math.h"
 
+#include <atomic>
 #include <cmath>
 
 #define MAXLEN 11
@@ -136,6 +137,8 @@ class EXPORT BandLimitedWave
                                      real_t    _wavelen,
                                      Waveforms _wave)
     {
+        WaveMipMap* const w = waveform(_wave);
+
         // high wavelen/ low freq
         if(_wavelen > TLENS[MAXTBL])
         {
@@ -146,13 +149,13 @@ class EXPORT BandLimitedWave
             const int    lookup  = lookupf;
             const real_t ip      = fraction(lookupf);
 
-            const sample_t s1 = s_waveforms[_wave].sampleAt(t, lookup);
+            const sample_t s1 = w->sampleAt(t, lookup);
             const sample_t s2
-                    = s_waveforms[_wave].sampleAt(t, (lookup + 1) % tlen);
+                    = w->sampleAt(t, (lookup + 1) % tlen);
             const int      lm = lookup == 0 ? tlen - 1 : lookup - 1;
-            const sample_t s0 = s_waveforms[_wave].sampleAt(t, lm);
+            const sample_t s0 = w->sampleAt(t, lm);
             const sample_t s3
-                    = s_waveforms[_wave].sampleAt(t, (lookup + 2) % tlen);
+                    = w->sampleAt(t, (lookup + 2) % tlen);
             const sample_t sr = optimal4pInterpolate(s0, s1, s2, s3, ip);
 
             return sr;
@@ -167,13 +170,13 @@ class EXPORT BandLimitedWave
             const int    lookup  = lookupf;
             const real_t ip      = fraction(lookupf);
 
-            const sample_t s1 = s_waveforms[_wave].sampleAt(t, lookup);
+            const sample_t s1 = w->sampleAt(t, lookup);
             const sample_t s2
-                    = s_waveforms[_wave].sampleAt(t, (lookup + 1) % tlen);
+                    = w->sampleAt(t, (lookup + 1) % tlen);
             const int      lm = lookup == 0 ? tlen - 1 : lookup - 1;
-            const sample_t s0 = s_waveforms[_wave].sampleAt(t, lm);
+            const sample_t s0 = w->sampleAt(t, lm);
             const sample_t s3
-                    = s_waveforms[_wave].sampleAt(t, (lookup + 2) % tlen);
+                    = w->sampleAt(t, (lookup + 2) % tlen);
             const sample_t sr = optimal4pInterpolate(s0, s1, s2, s3, ip);
 
             return sr;
@@ -190,14 +193,14 @@ class EXPORT BandLimitedWave
         const int    lookup  = lookupf;
         const real_t ip      = fraction(lookupf);
 
-        const sample_t s1 = s_waveforms[_wave].sampleAt(t, lookup);
+        const sample_t s1 = w->sampleAt(t, lookup);
         const sample_t s2
-                = s_waveforms[_wave].sampleAt(t, (lookup + 1) % tlen);
+                = w->sampleAt(t, (lookup + 1) % tlen);
 
         const int      lm = lookup == 0 ? tlen - 1 : lookup - 1;
-        const sample_t s0 = s_waveforms[_wave].sampleAt(t, lm);
+        const sample_t s0 = w->sampleAt(t, lm);
         const sample_t s3
-                = s_waveforms[_wave].sampleAt(t, (lookup + 2) % tlen);
+                = w->sampleAt(t, (lookup + 2) % tlen);
         const sample_t sr = optimal4pInterpolate(s0, s1, s2, s3, ip);
 
         return sr;
@@ -216,13 +219,28 @@ class EXPORT BandLimitedWave
         */
     }
 
+    /*! \brief The mipmaps of the waveform, mapped from the user cache
+     * directory the first time, or generated and stored there if the
+     * cache does not have them yet. The instruments call it from their
+     * constructor, so the audio threads only read the pointer.
+     */
+    static INLINE WaveMipMap* waveform(Waveforms _wave)
+    {
+        WaveMipMap* r = s_waveforms[_wave].load(std::memory_order_acquire);
+        return r != nullptr ? r : loadWaveform(_wave);
+    }
+
+    // the tables are mapped on demand, this only sets the directories
     static void generateWaves();
 
     static bool s_wavesGenerated;
 
-    static WaveMipMap s_waveforms[NumBLWaveforms];
+    static std::atomic<WaveMipMap*> s_waveforms[NumBLWaveforms];
 
     static QString s_wavetableDir;
+
+  private:
+    static WaveMipMap* loadWaveform(Waveforms _wave);
 };
 
 #endif
@@ -39,6 +39,13 @@
 #include "interpolation.h"
 #include "lmms_constants.h"
 
+// Coefficients of a BasicFilters, as computed by calcFilterCoeffs().
+// Their meaning depends on the filter type.
+struct FilterCoeffs
+{
+    real_t c[8];
+};
+
 template <ch_cnt_t CHANNELS = DEFAULT_CHANNELS>
 class BasicFilters;
 
@@ -457,6 +464,129 @@ class BasicFilters final : public LsmmFilter<CHANNELS>
         m_subFilter->setFilterType(m_type);
     }
 
+    // the type actually computed, DoubleLowPass and DoubleMoog are
+    // LowPass and Moog with an extra pass
+    INLINE int type() const
+    {
+        return m_type;
+    }
+
+    virtual void getCoeffs(FilterCoeffs& _c) const
+    {
+        real_t* c = _c.c;
+        switch(m_type)
+        {
+            case Lowpass_RC12:
+            case Bandpass_RC12:
+            case Highpass_RC12:
+            case Lowpass_RC24:
+            case Bandpass_RC24:
+            case Highpass_RC24:
+                c[0] = m_rca;
+                c[1] = m_rcb;
+                c[2] = m_rcc;
+                c[3] = m_rcq;
+                break;
+            case Formantfilter:
+            case FastFormant:
+                c[0] = m_vfa[0];
+                c[1] = m_vfb[0];
+                c[2] = m_vfc[0];
+                c[3] = m_vfa[1];
+                c[4] = m_vfb[1];
+                c[5] = m_vfc[1];
+                c[6] = m_vfq;
+                break;
+            case Moog:
+            case Tripole:
+                c[0] = m_p;
+                c[1] = m_k;
+                c[2] = m_r;
+                break;
+            case Lowpass_SV:
+            case Bandpass_SV:
+            case Highpass_SV:
+            case Notch_SV:
+                c[0] = m_svf1;
+                c[1] = m_svf2;
+                c[2] = m_svq;
+                break;
+            case Brown:
+                c[0] = m_brownf;
+                c[1] = m_brownq;
+                break;
+            case Pink:
+                c[0] = m_pinkf;
+                c[1] = m_pinkq;
+                break;
+            default:
+                c[0] = m_biQuad.m_a1;
+                c[1] = m_biQuad.m_a2;
+                c[2] = m_biQuad.m_b0;
+                c[3] = m_biQuad.m_b1;
+                c[4] = m_biQuad.m_b2;
+                break;
+        }
+    }
+
+    // same as calcFilterCoeffs() with coefficients from getCoeffs()
+    virtual void setCoeffs(const FilterCoeffs& _c)
+    {
+        if(m_subFilter != nullptr)
+            m_subFilter->setCoeffs(_c);
+
+        const real_t* c = _c.c;
+        switch(m_type)
+        {
+            case Lowpass_RC12:
+            case Bandpass_RC12:
+            case Highpass_RC12:
+            case Lowpass_RC24:
+            case Bandpass_RC24:
+            case Highpass_RC24:
+                m_rca = c[0];
+                m_rcb = c[1];
+                m_rcc = c[2];
+                m_rcq = c[3];
+                break;
+            case Formantfilter:
+            case FastFormant:
+                m_vfa[0] = c[0];
+                m_vfb[0] = c[1];
+                m_vfc[0] = c[2];
+                m_vfa[1] = c[3];
+                m_vfb[1] = c[4];
+                m_vfc[1] = c[5];
+                m_vfq    = c[6];
+                break;
+            case Moog:
+            case Tripole:
+                m_p = c[0];
+                m_k = c[1];
+                m_r = c[2];
+                break;
+            case Lowpass_SV:
+            case Bandpass_SV:
+            case Highpass_SV:
+            case Notch_SV:
+                m_svf1 = c[0];
+                m_svf2 = c[1];
+                m_svq  = c[2];
+                break;
+            case Brown:
+                m_brownf = c[0];
+                m_brownq = c[1];
+                break;
+            case Pink:
+                m_pinkf = c[0];
+                m_pinkq = c[1];
+                break;
+            default:
+                m_biQuad.setCoeffs(c[0], c[1], c[2], c[3], c[4]);
+                break;
+        }
+    }
+
     virtual void setFeedbackAmount(real_t _amount)
     {
         m_feedbackAmount = bound(-10., _amount, 10.);
@@ -0,0 +1,116 @@
+/*
+ * BatchRenderer.h - renders the jobs of a manifest in parallel
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BATCH_RENDERER_H
+#define BATCH_RENDERER_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+#include <QVector>
+
+// The engine is a singleton, so every job is rendered by a child process
+// running `lmms --render`. At most `jobs` children run at the same time.
+//
+// The manifest is either a JSON array of objects or a CSV file with a
+// header line. The fields are: project, output, format, samplerate,
+// interpolation, oversampling, bitrate, mode (song, tracks, channels or
+// stems) and range (song or loop). Only project and output are required,
+// the manifest is rejected if a mode or a range is unknown.
+//
+// When a job ends, a JSON object is written as one line to the report
+// (stdout when no report file is given).
+class BatchRenderer : public QObject
+{
+    Q_OBJECT
+
+  public:
+    BatchRenderer(const QString& _manifest,
+                  int            _jobs,
+                  const QString& _report,
+                  QObject*       _parent = nullptr);
+    virtual ~BatchRenderer();
+
+    // returns false if the manifest can not be read
+    bool load();
+
+    int numJobs() const
+    {
+        return m_jobs.size();
+    }
+
+    int numFailed() const
+    {
+        return m_failed;
+    }
+
+  public slots:
+    void start();
+
+  signals:
+    void finished();
+
+  private slots:
+    void startNextJobs();
+    void onJobFinished(int _exitCode, QProcess::ExitStatus _status);
+    void onJobError(QProcess::ProcessError _error);
+
+  private:
+    struct Job
+    {
+        QString project;
+        QString output;
+        QString format;
+        QString samplerate;
+        QString interpolation;
+        QString oversampling;
+        QString bitrate;
+        QString mode;
+        QString range;
+
+        QProcess*     process;
+        QElapsedTimer timer;
+    };
+
+    bool loadJson(const QByteArray& _data);
+    bool loadCsv(const QByteArray& _data);
+    bool addJob(const Job& _job);
+
+    QStringList arguments(const Job& _job) const;
+    void        report(const Job& _job, int _exitCode);
+
+    QString m_manifest;
+    int     m_maxRunning;
+    QString m_reportFile;
+    QFile   m_report;
+
+    QVector<Job*> m_jobs;
+    int           m_next;
+    int           m_running;
+    int           m_failed;
+
+    QElapsedTimer m_timer;
+};
+
+#endif
@@ -33,7 +33,17 @@
 class EXPORT BufferManager
 {
 public:
+	struct Stats
+	{
+		int hits;	// served by the pool
+		int misses;	// pool empty, served by the allocator
+		int inUse;
+		int highWater;	// maximum of buffers in use at once
+		int capacity;	// buffers owned by the pool
+	};
+
 	static void init( fpp_t framesPerPeriod );
+	static void cleanup();
 	static sampleFrame * acquire();
 	// audio-buffer-mgm
 	static void clear( sampleFrame * ab );
@@ -46,6 +56,9 @@ public:
 	static void release( sampleFrame * buf );
 	static void refresh();
 
+	static Stats stats();
+	static void printStats();
+
 private:
 	static fpp_t s_framesPerPeriod;
 };
@@ -0,0 +1,84 @@
+/*
+ * CompensationDelay.h - delay line aligning the paths of the mixer
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMPENSATION_DELAY_H
+#define COMPENSATION_DELAY_H
+
+#include "MemoryManager.h"
+#include "lmms_basics.h"
+
+// Integer delay added to the inputs of a fx channel which have less
+// latency than the others, so they all arrive aligned. A delay of 0 is a
+// passthrough.
+//
+// The line is allocated once, for the longest delay, so nothing is
+// allocated on the render thread.
+class EXPORT CompensationDelay
+{
+    MM_OPERATORS
+
+  public:
+    // size of the line, a power of 2
+    static const f_cnt_t SIZE = 16384;
+    // longer delays are clamped
+    static const f_cnt_t MAX_DELAY = SIZE - 1;
+    // length of the crossfade when the delay changes
+    static const f_cnt_t FADE_FRAMES = 64;
+
+    CompensationDelay();
+    virtual ~CompensationDelay();
+
+    INLINE f_cnt_t delay() const
+    {
+        return m_delay;
+    }
+
+    // the content of the line is kept and the change is crossfaded
+    void setDelay(f_cnt_t _delay);
+
+    // true while some input has not come out yet
+    INLINE bool isPending() const
+    {
+        return m_tail > 0;
+    }
+
+    void clear();
+
+    // in place
+    void process(sampleFrame* _buf, fpp_t _frames, bool _hasInput);
+
+    // returns _src itself when there is no delay
+    const sampleFrame*
+            process(const sampleFrame* _src, fpp_t _frames, bool _hasInput);
+
+  private:
+    f_cnt_t      m_delay;
+    f_cnt_t      m_fadeDelay;  // delay faded out
+    f_cnt_t      m_fade;       // frames before the end of the crossfade
+    f_cnt_t      m_valid;      // frames of the line holding its history
+    f_cnt_t      m_pos;
+    f_cnt_t      m_tail;  // frames before the line is silent
+    sampleFrame* m_ring;
+    sampleFrame* m_out;  // from the buffer manager, taken on first use
+};
+
+#endif
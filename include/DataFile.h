@@ -71,6 +71,13 @@ class EXPORT DataFile : public QDomDocument
     void write(QTextStream& strm);
     bool writeFile(const QString& fn);
 
+    // The binary projects (.lsmmb) are the same document split in chunks:
+    // the skeleton, then each track and each other section of the content,
+    // compressed separately and indexed, so the sections are unpacked and
+    // parsed in parallel when loading.
+    static bool isBinary(const QByteArray& data);
+    QByteArray  toBinary();
+
     QDomElement& content()
     {
         return m_content;
@@ -131,6 +138,7 @@ class EXPORT DataFile : public QDomDocument
     void upgrade();
 
     void loadData(const QByteArray& _data, const QString& _sourceFile);
+    bool loadBinary(const QByteArray& _data, const QString& _sourceFile);
 
     struct EXPORT typeDescStruct
     {
@@ -68,6 +68,13 @@ class EXPORT Effect : public Plugin, public MidiEventProcessor
     virtual bool processAudioBuffer(sampleFrame* _buf, const fpp_t _frames)
             = 0;
 
+    // delay added to the signal, in frames at the processing sample rate.
+    // The mixer delays the parallel paths by the same amount.
+    virtual f_cnt_t latency() const
+    {
+        return 0;
+    }
+
     virtual bool hasMidiIn()
     {
         return false;
@@ -61,6 +61,9 @@ class EXPORT EffectChain : public Model, public SerializingObject
                             bool         hasInputNoise);
     void startRunning();
 
+    // sum of the latencies of the enabled effects
+    f_cnt_t latency() const;
+
     void clear();
 
     bool isEnabled()
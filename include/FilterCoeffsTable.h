@@ -0,0 +1,75 @@
+/*
+ * FilterCoeffsTable.h - precomputed coefficients of the basic filters
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef FILTER_COEFFS_TABLE_H
+#define FILTER_COEFFS_TABLE_H
+
+#include "BasicFilters.h"
+
+// Coefficients of one filter type at one sample rate, on a grid of
+// cutoff frequencies (FREQ_STEPS per octave) and resonances (Q_STEPS
+// per octave). lookup() interpolates between the four nearest cells.
+//
+// The tables are shared by all the instruments and kept until exit.
+// Peak depends on the gain and is not tabulated.
+class FilterCoeffsTable final
+{
+  public:
+    static const int FREQ_STEPS = 24;
+    static const int Q_STEPS    = 8;
+
+    // builds the table when missing, not on the audio thread.
+    // nullptr when the type can not be tabulated
+    static const FilterCoeffsTable* get(int _type, sample_rate_t _sampleRate);
+
+    // never locks nor allocates, for the audio thread.
+    // nullptr when get() has not built the table yet
+    static const FilterCoeffsTable* find(int           _type,
+                                         sample_rate_t _sampleRate);
+
+    INLINE int type() const
+    {
+        return m_type;
+    }
+
+    INLINE sample_rate_t sampleRate() const
+    {
+        return m_sampleRate;
+    }
+
+    void lookup(frequency_t _freq, real_t _q, FilterCoeffs& _c) const;
+
+  private:
+    static int tableType(int _type);
+
+    FilterCoeffsTable(int _type, sample_rate_t _sampleRate);
+
+    const int           m_type;
+    const sample_rate_t m_sampleRate;
+    int                 m_freqSize;
+    int                 m_qSize;
+    frequency_t*        m_freqs;
+    real_t*             m_qs;
+    FilterCoeffs*       m_cells;
+};
+
+#endif
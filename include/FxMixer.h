@@ -25,6 +25,7 @@
 #ifndef FX_MIXER_H
 #define FX_MIXER_H
 
+#include "CompensationDelay.h"
 #include "Effect.h"
 #include "EffectChain.h"
 #include "JournallingObject.h"
@@ -32,6 +33,7 @@
 #include "ThreadableJob.h"
 #include "debug.h"
 
+class AudioFileDevice;
 class FxChannel;
 class FxRoute;
 class SampleBuffer;
@@ -137,6 +139,18 @@ class FxChannel :
 
     virtual bool hasCableFrom(Model* _m) const;
 
+    // latency of the slowest input, the other ones being delayed to match
+    INLINE f_cnt_t inputLatency() const
+    {
+        return m_inputLatency;
+    }
+
+    // input latency plus the latency of the effects
+    INLINE f_cnt_t outputLatency() const
+    {
+        return m_outputLatency;
+    }
+
     INLINE const BoolModel& clippingModel() const
     {
         return m_clippingModel;
@@ -222,6 +236,13 @@ class FxChannel :
     virtual void readFrozenBuffer();
     virtual void writeFrozenBuffer();
 
+    // receives a copy of the output (after the fader) while rendering
+    // stems
+    void setStemDevice(AudioFileDevice* _dev)
+    {
+        m_stemDevice = _dev;
+    }
+
     virtual bool requiresProcessing() const final
     {
         return true;
@@ -251,6 +272,7 @@ class FxChannel :
   protected:
     virtual void doProcessing() final;
     virtual void incrementDeps();
+    void         writeStem();
 
     virtual void saveSettings(QDomDocument& doc, QDomElement& element);
     virtual void loadSettings(const QDomElement& element);
@@ -262,8 +284,9 @@ class FxChannel :
     // set to true if any effect in the channel is enabled and running
     bool m_stillRunning;
 
-    SampleBuffer* m_frozenBuf;
-    BoolModel     m_frozenModel;
+    SampleBuffer*    m_frozenBuf;
+    AudioFileDevice* m_stemDevice;
+    BoolModel        m_frozenModel;
     BoolModel     m_clippingModel;
 
   public:  // TMP
@@ -275,6 +298,8 @@ class FxChannel :
   private:
     real_t       m_peakLeft;
     real_t       m_peakRight;
+    f_cnt_t      m_inputLatency;
+    f_cnt_t      m_outputLatency;
     sampleFrame* m_buffer;
     bool         m_mutedBeforeSolo;
     BoolModel    m_mutedModel;
@@ -294,7 +319,7 @@ class FxChannel :
     // pointers to other channels that send to this one
     FxRoutes m_receives;
 
-    QAtomicInt m_dependenciesMet;
+    friend class FxMixer;
 };
 
 class FxRoute : public QObject, public SerializingObject
@@ -335,6 +360,13 @@ class FxRoute : public QObject, public SerializingObject
         return m_to;
     }
 
+    // delays the output of the sender to align it with the other inputs
+    // of the receiver
+    CompensationDelay& compensation()
+    {
+        return m_compensation;
+    }
+
     void updateName();
 
   protected:
@@ -345,6 +377,7 @@ class FxRoute : public QObject, public SerializingObject
     QPointer<FxChannel> m_from;
     QPointer<FxChannel> m_to;
     RealModel           m_amount;
+    CompensationDelay   m_compensation;
 };
 
 class EXPORT FxMixer : public Model, public JournallingObject
@@ -360,6 +393,35 @@ class EXPORT FxMixer : public Model, public JournallingObject
     void prepareMasterMix();
     void masterMix(sampleFrame* _buf);
 
+    // per-period job graph, built by Mixer::renderNextBuffer()
+    // each channel waits for the channels sending to it and for the
+    // inputs added with addGraphInput()
+    // the channels are visited in a precomputed topological order, which
+    // is rebuilt only after the routes or the channels have changed
+    void prepareGraph();
+    void addGraphInput(ThreadableJob* _input,
+                       fx_ch_t        _ch,
+                       f_cnt_t        _latency = 0);
+    void releaseGraph();
+
+    // plugin delay compensation: computes the latency of every channel
+    // from the latencies of the inputs and the effects, and the delays of
+    // the sends. Called once all the inputs are added to the graph.
+    void updateLatencies();
+
+    // total latency, at the output of the master channel
+    INLINE f_cnt_t latency() const
+    {
+        return m_latency;
+    }
+
+    // latency at the input of the channel, 0 for an invalid channel
+    f_cnt_t inputLatency(fx_ch_t _ch) const;
+
+    // fx channel processing the model, if any, for the automation which
+    // has to follow the audio (same delay)
+    FxChannel* channelOf(Model* _m) const;
+
     virtual void saveSettings(QDomDocument& _doc, QDomElement& _parent);
     virtual void loadSettings(const QDomElement& _this);
 
@@ -431,11 +493,23 @@ class EXPORT FxMixer : public Model, public JournallingObject
     // make sure we have at least num channels
     void allocateChannelsTo(int num);
 
+    INLINE void invalidateGraphOrder()
+    {
+        m_graphOrderDirty.storeRelease(1);
+    }
+
+    void computeGraphOrder();
+
     FxRoutes m_fxRoutes;
 
     // the fx channels in the mixer. index 0 is always master.
     FxChannels m_fxChannels;
 
+    // senders before receivers, longest chain of sends first
+    QVector<FxChannel*> m_graphOrder;
+    QAtomicInt          m_graphOrderDirty;
+    f_cnt_t             m_latency;
+
     int m_lastSoloed;
 };
 
@@ -105,6 +105,13 @@ class EXPORT Instrument : public Plugin
         return 0;
     }
 
+    // delay between a note and its sound, in frames at the processing
+    // sample rate, for instance when the rendering is pipelined
+    virtual f_cnt_t latency() const
+    {
+        return 0;
+    }
+
     // convenient accessors
     INLINE virtual bool isBendable() const final
     {
@@ -74,6 +74,9 @@ class InstrumentSoundShaping : public Model, public JournallingObject
         return "eldata";
     }
 
+  private slots:
+    void updateFilterTables();
+
   private:
     EnvelopeAndLfo*  m_envLfo[NumTargets];
     InstrumentTrack* m_instrumentTrack;
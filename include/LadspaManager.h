@@ -33,11 +33,15 @@
 //#include "lmms_basics.h"
 
 #include <QFileInfo>
+#include <QHash>
 #include <QMap>
+#include <QMutex>
 #include <QPair>
 #include <QString>
 //#include <QStringList>
 
+#include <atomic>
+
 const float NOHINT = -99342.2243f;
 
 typedef QPair<QString, QString>      ladspa_key_t;
@@ -70,11 +74,34 @@ enum ladspaPluginType
 
 typedef struct ladspaManagerStorage
 {
-    LADSPA_Descriptor_Function descriptorFunction;
+    ladspaManagerStorage() :
+          descriptorFunction(nullptr), index(0), type(OTHER),
+          inputChannels(0), outputChannels(0), properties(0)
+    {
+    }
+
+    ladspaManagerStorage(const ladspaManagerStorage& _other) :
+          descriptorFunction(_other.descriptorFunction.load()),
+          index(_other.index), type(_other.type),
+          inputChannels(_other.inputChannels),
+          outputChannels(_other.outputChannels), path(_other.path),
+          label(_other.label), name(_other.name),
+          properties(_other.properties)
+    {
+    }
+
+    // nullptr until the library is loaded, on first use. Read without
+    // the lock by the instances.
+    std::atomic<LADSPA_Descriptor_Function> descriptorFunction;
     uint32_t                   index;
     ladspaPluginType           type;
     uint16_t                   inputChannels;
     uint16_t                   outputChannels;
+    // known without loading the library
+    QString                    path;
+    QString                    label;
+    QString                    name;
+    int                        properties;
 } ladspaManagerDescription;
 
 class EXPORT LadspaManager : public QObject
@@ -308,15 +335,36 @@ class EXPORT LadspaManager : public QObject
     bool cleanup(const ladspa_key_t& _plugin, LADSPA_Handle _instance);
 
   private:
+    // what is kept of the libraries between two runs, in the user cache
+    // directory, valid while their size and time are the same
+    struct CachedLibrary
+    {
+        qint64                          size;
+        qint64                          time;
+        QList<ladspaManagerDescription> plugins;
+    };
+
     void     addPlugins(LADSPA_Descriptor_Function _descriptor_func,
                         const QFileInfo&           _file);
+    void     addCachedPlugins(const QFileInfo& _file);
     uint16_t getPluginInputs(const LADSPA_Descriptor* _descriptor);
     uint16_t getPluginOutputs(const LADSPA_Descriptor* _descriptor);
 
+    // loads the library of the plugin if it is not yet
+    LADSPA_Descriptor_Function loadDescriptorFunction(
+            const ladspa_key_t& _plugin);
+
+    static QString cacheFile();
+    void           readCache();
+    void           writeCache();
+
     typedef QMap<ladspa_key_t, ladspaManagerDescription*>
                          ladspaManagerMapType;
     ladspaManagerMapType m_ladspaManagerMap;
     l_sortable_plugin_t  m_sortedPlugins;
+
+    QHash<QString, CachedLibrary> m_cache;
+    QMutex                        m_loadMutex;
 };
 
 #endif
@@ -64,6 +64,28 @@ class LocklessList
         } while(!m_first.testAndSetOrdered(e->next, e));
     }
 
+    // same as push() but returns false instead of crashing when the
+    // allocator is exhausted
+    bool tryPush(T value)
+    {
+        Element* e = m_allocator->alloc();
+        if(e == nullptr)
+            return false;
+
+        e->value = value;
+
+        do
+        {
+#if QT_VERSION >= 0x050000
+            e->next = m_first.loadAcquire();
+#else
+            e->next = m_first;
+#endif
+        } while(!m_first.testAndSetOrdered(e->next, e));
+
+        return true;
+    }
+
     Element* popList()
     {
         return m_first.fetchAndStoreOrdered(nullptr);
@@ -26,28 +26,39 @@
 //#include <stdlib.h>
 //#include <string.h>
 
-#include "Bitset.h"
 #include "MemoryManager.h"
 #include "export.h"
 
-#include <QHash>
 #include <QMutex>
 
+#include <atomic>
+
 #ifndef MEMORY_MANAGER_CLASS
 #define MEMORY_MANAGER_CLASS MemoryManagerArray
 #endif
 
+// One instance per power-of-two size class.
+//
+// Elements are carved from 1 MiB slabs, aligned on their size so the
+// owner of a pointer is found with a lookup in a table of slabs. Each
+// thread keeps a small magazine of free elements per class. A magazine is
+// refilled from (and flushed to) a lock-free stack of free elements shared
+// by the threads, and a new slab is added when the class is exhausted.
+//
+// Allocations are counted per class and per thread, and a sample of them
+// per call site, see report(). Nothing shared is written on the fast
+// path, only when a magazine is refilled or flushed.
 class EXPORT MemoryManagerArray
 {
   public:
-    MemoryManagerArray(const int    nbe,
+    MemoryManagerArray(const int    sizeClass,
                        const size_t size,
+                       const int    prewarm,
                        const char*  ref = "");
     virtual ~MemoryManagerArray();
 
-    // bool  full();
     void* allocate(size_t size, const char* file, long line);
-    bool  deallocate(void* ptr, const char* file, long line);
+    void  deallocate(int slab, void* ptr, const char* file, long line);
 
     static bool  init();
     static void  cleanup();
@@ -58,39 +69,70 @@ class EXPORT MemoryManagerArray
     static void  alignedFree(void* ptr, const char* file, long line);
     static void  setActive(bool active);
 
+    // prints the usage of every size class and the biggest call sites
+    static void report();
+
+    enum
+    {
+        SlabShift = 20,  // 1 MiB
+        SlabSize  = 1 << SlabShift,
+        MaxSlabs  = 1024,  // per class
+        MaxMagazineSize = 32
+    };
+
+    struct Magazine
+    {
+        int count;
+        int items[MaxMagazineSize];
+    };
+
+    // written by one thread only, added up by report()
+    struct Stats
+    {
+        std::atomic<long>      allocs;
+        std::atomic<long>      frees;
+        std::atomic<long long> wasted;
+    };
+
   private:
-    QMutex       m_mutex;
-    const int    m_nbe;
+    inline char* address(int _index) const
+    {
+        return m_slabs[_index / m_perSlab] + (_index % m_perSlab) * m_size;
+    }
+
+    void push(int _index);
+    int  pop();
+    int  carve();
+    bool grow();
+    void refill(Magazine& _m);
+    void flush(Magazine& _m, int _n);
+
+    const int    m_class;
     const size_t m_size;
-    char*        m_data;
-
-    int m_lastfree;
-    int m_count;
-
-    // info
-    int                    m_max;
-    unsigned long long int m_wasted;
-    const char*            m_ref;
-
-    // unsigned int available[1024]; // nbe<1024*32
-    // bool*   m_available;
-    Bitset m_available;
-
-    QHash<size_t, long> m_stats;
+    const int    m_perSlab;
+    const int    m_magazineSize;
+    const char*  m_ref;
+
+    QMutex           m_growMutex;
+    char*            m_slabs[MaxSlabs];
+    std::atomic<int> m_numSlabs;
+    std::atomic<int> m_bump;  // first element never used
+
+    // free elements, tag << 32 | (index + 1)
+    std::atomic<quint64> m_head;
+
+    // info, the counts of the running threads are in their Stats
+    std::atomic<long>      m_allocs;  // by the threads which exited
+    std::atomic<long>      m_frees;
+    std::atomic<long long> m_wasted;
+    std::atomic<long>      m_refills;
+    // out of the shared stack, in use or in a magazine
+    std::atomic<int> m_taken;
+    std::atomic<int> m_max;
 
     static bool s_active;
 
-    /*
-      static MemoryManagerArray S4, S8, S16, S32, S80, S112, S128, S192, S224,
-      S264, S480, S496, S512, S552, S1024, S1056, S1392, S2048, S2464,
-      S4128;
-
-    bool bit(const unsigned int i) const;
-    void set(const unsigned int i);
-    void unset(const unsigned int i);
-    int  nextSet(const unsigned int i) const;
-    int  nextUnset(const unsigned int i) const;
-    */
+    friend struct MemoryManagerArrayMagazines;
 };
 
 #endif
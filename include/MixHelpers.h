@@ -54,6 +54,22 @@ sample_t convertFromS16(int16_t _v);
 sample_t convertFromS32(int32_t _v);
 sample_t convertFromS64(int64_t _v);
 
+/*! \brief Instruction sets of the mixing kernels */
+enum Isa
+{
+    Isa_Scalar,
+    Isa_SSE2,
+    Isa_AVX2,
+    Isa_AVX512
+};
+
+/*! \brief Instruction set in use, the best one of the cpu by default */
+Isa         isa();
+const char* isaName(Isa _isa);
+bool        isaSupported(Isa _isa);
+/*! \brief Force the instruction set, returns false if not supported */
+bool setIsa(Isa _isa);
+
 bool isSilent(const sampleFrame* _src, const f_cnt_t _frames);
 bool isClipping(const sampleFrame* _src, const f_cnt_t _frames);
 
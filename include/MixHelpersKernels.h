@@ -0,0 +1,378 @@
+/*
+ * MixHelpersKernels.h - vector kernels of the mixing helpers
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+// No include guard: MixHelpers.cpp includes this file once per instruction
+// set, with a "#pragma GCC target" active and these macros defined:
+//   MIXHELPERS_ISA    namespace of the kernels
+//   MIXHELPERS_LANES  number of samples in a vector register
+//
+// Every kernel computes the same operations as its scalar version, lane by
+// lane, so the results are bit-exact. The frames left after the last full
+// vector are given to the scalar version.
+
+namespace MIXHELPERS_ISA
+{
+
+static const int LANES  = MIXHELPERS_LANES;
+static const int FRAMES = LANES / DEFAULT_CHANNELS;
+
+typedef sample_t vec_t __attribute__((vector_size(LANES * sizeof(sample_t))));
+typedef mask_t   ivec_t __attribute__((vector_size(LANES * sizeof(sample_t))));
+
+static inline vec_t load(const sampleFrame* _p)
+{
+    vec_t r;
+    memcpy(&r, _p, sizeof(r));
+    return r;
+}
+
+static inline void store(sampleFrame* _p, const vec_t& _v)
+{
+    memcpy(_p, &_v, sizeof(_v));
+}
+
+// {c0, c0, c1, c1, ...}
+static inline vec_t frameCoeffs(const real_t* _c)
+{
+    vec_t r;
+    for(int k = 0; k < FRAMES; ++k)
+    {
+        r[2 * k]     = _c[k];
+        r[2 * k + 1] = _c[k];
+    }
+    return r;
+}
+
+// {c0 * d0, c0 * d0, c1 * d1, c1 * d1, ...}
+static inline vec_t frameCoeffs(const real_t* _c, const real_t* _d)
+{
+    vec_t r;
+    for(int k = 0; k < FRAMES; ++k)
+    {
+        const real_t c = _c[k] * _d[k];
+        r[2 * k]       = c;
+        r[2 * k + 1]   = c;
+    }
+    return r;
+}
+
+static inline vec_t joined(const sample_t* _left, const sample_t* _right)
+{
+    vec_t r;
+    for(int k = 0; k < FRAMES; ++k)
+    {
+        r[2 * k]     = _left[k];
+        r[2 * k + 1] = _right[k];
+    }
+    return r;
+}
+
+static inline vec_t swapped(const vec_t& _v)
+{
+    vec_t r;
+    for(int k = 0; k < FRAMES; ++k)
+    {
+        r[2 * k]     = _v[2 * k + 1];
+        r[2 * k + 1] = _v[2 * k];
+    }
+    return r;
+}
+
+static inline vec_t absolute(const vec_t& _v)
+{
+    ivec_t m = {};
+    m += std::numeric_limits<mask_t>::max();  // all bits but the sign
+    return (vec_t)((ivec_t)_v & m);
+}
+
+// true for the lanes which are neither inf nor nan
+static inline ivec_t finite(const vec_t& _v)
+{
+    return (ivec_t)(absolute(_v) <= std::numeric_limits<sample_t>::max());
+}
+
+static inline vec_t select(const ivec_t& _mask, const vec_t& _v)
+{
+    return (vec_t)((ivec_t)_v & _mask);
+}
+
+static inline bool any(const ivec_t& _mask)
+{
+    mask_t r = 0;
+    for(int k = 0; k < LANES; ++k)
+        r |= _mask[k];
+    return r != 0;
+}
+
+static bool isClipping(const sampleFrame* _src, const f_cnt_t _frames)
+{
+    ivec_t  found = {};
+    f_cnt_t f     = 0;
+    for(; f + FRAMES <= _frames; f += FRAMES)
+        found |= (ivec_t)(absolute(load(_src + f)) > 1.);
+    return any(found) || Scalar::isClipping(_src + f, _frames - f);
+}
+
+static bool sanitize(sampleFrame* _src, const f_cnt_t _frames)
+{
+    ivec_t  found = {};
+    f_cnt_t f     = 0;
+    for(; f + FRAMES <= _frames; f += FRAMES)
+    {
+        const vec_t  v    = load(_src + f);
+        const ivec_t fin  = finite(v);
+        const ivec_t loud = (ivec_t)(absolute(v) > SILENCE);
+        found |= ~fin;
+        store(_src + f, select(fin & loud, v));
+    }
+    // evaluated first, the tail must be sanitized too
+    const bool tail = Scalar::sanitize(_src + f, _frames - f);
+    return any(found) || tail;
+}
+
+static bool unclip(sampleFrame* _src, const f_cnt_t _frames)
+{
+    ivec_t  found = {};
+    f_cnt_t f     = 0;
+    for(; f + FRAMES <= _frames; f += FRAMES)
+    {
+        const vec_t  v    = load(_src + f);
+        const ivec_t low  = (ivec_t)(v < -1.);
+        const ivec_t high = (ivec_t)(v > 1.);
+        vec_t        one  = {};
+        one += 1.;
+        found |= low | high;
+        store(_src + f, (vec_t)(((ivec_t)v & ~(low | high))
+                                | ((ivec_t)(-one) & low)
+                                | ((ivec_t)one & high)));
+    }
+    const bool tail = Scalar::unclip(_src + f, _frames - f);
+    return any(found) || tail;
+}
+
+static void add(sampleFrame* _dst, const sampleFrame* _src, int _frames)
+{
+    int f = 0;
+    for(; f + FRAMES <= _frames; f += FRAMES)
+        store(_dst + f, load(_dst + f) + load(_src + f));
+    Scalar::add(_dst + f, _src + f, _frames - f);
+}
+
+static void addSanitized(sampleFrame*       _dst,
+                         const sampleFrame* _src,
+                         f_cnt_t            _frames)
+{
+    f_cnt_t f = 0;
+    for(; f + FRAMES <= _frames; f += FRAMES)
+    {
+        const vec_t s = load(_src + f);
+        store(_dst + f, load(_dst + f) + select(finite(s), s));
+    }
+    Scalar::addSanitized(_dst + f, _src + f, _frames - f);
+}
+
+static void addMultiplied(sampleFrame*       _dst,
+                          const sampleFrame* _src,
+                          real_t             _coeffSrc,
+                          int                _frames)
+{
+    int f = 0;
+    for(; f + FRAMES <= _frames; f += FRAMES)
+        store(_dst + f, load(_dst + f) + load(_src + f) * _coeffSrc);
+    Scalar::addMultiplied(_dst + f, _src + f, _coeffSrc, _frames - f);
+}
+
+static void addMultipliedByValues(sampleFrame*       _dst,
+                                  const sampleFrame* _src,
+                                  const real_t*      _coeffs,
+                                  f_cnt_t            _frames)
+{
+    f_cnt_t f = 0;
+    for(; f + FRAMES <= _frames; f += FRAMES)
+        store(_dst + f,
+              load(_dst + f) + load(_src + f) * frameCoeffs(_coeffs + f));
+    Scalar::addMultipliedByValues(_dst + f, _src + f, _coeffs + f,
+                                  _frames - f);
+}
+
+static void addSwappedMultiplied(sampleFrame*       _dst,
+                                 const sampleFrame* _src,
+                                 real_t             _coeffSrc,
+                                 int                _frames)
+{
+    int f = 0;
+    for(; f + FRAMES <= _frames; f += FRAMES)
+        store(_dst + f,
+              load(_dst + f) + swapped(load(_src + f)) * _coeffSrc);
+    Scalar::addSwappedMultiplied(_dst + f, _src + f, _coeffSrc, _frames - f);
+}
+
+static void addMultipliedByBuffer(sampleFrame*       _dst,
+                                  const sampleFrame* _src,
+                                  real_t             _coeffSrc,
+                                  const real_t*      _coeffs,
+                                  int                _frames)
+{
+    int f = 0;
+    for(; f + FRAMES <= _frames; f += FRAMES)
+    {
+        const vec_t c = _coeffSrc * frameCoeffs(_coeffs + f);
+        store(_dst + f, load(_dst + f) + load(_src + f) * c);
+    }
+    Scalar::addMultipliedByBuffer(_dst + f, _src + f, _coeffSrc, _coeffs + f,
+                                  _frames - f);
+}
+
+static void addMultipliedByBuffers(sampleFrame*       _dst,
+                                   const sampleFrame* _src,
+                                   const real_t*      _coeffs1,
+                                   const real_t*      _coeffs2,
+                                   int                _frames)
+{
+    int f = 0;
+    for(; f + FRAMES <= _frames; f += FRAMES)
+    {
+        const vec_t c = frameCoeffs(_coeffs1 + f, _coeffs2 + f);
+        store(_dst + f, load(_dst + f) + load(_src + f) * c);
+    }
+    Scalar::addMultipliedByBuffers(_dst + f, _src + f, _coeffs1 + f,
+                                   _coeffs2 + f, _frames - f);
+}
+
+static void addSanitizedMultiplied(sampleFrame*       _dst,
+                                   const sampleFrame* _src,
+                                   real_t             _coeffSrc,
+                                   int                _frames)
+{
+    int f = 0;
+    for(; f + FRAMES <= _frames; f += FRAMES)
+    {
+        const vec_t s = load(_src + f);
+        store(_dst + f, load(_dst + f) + select(finite(s), s * _coeffSrc));
+    }
+    Scalar::addSanitizedMultiplied(_dst + f, _src + f, _coeffSrc,
+                                   _frames - f);
+}
+
+static void addSanitizedMultipliedByBuffer(sampleFrame*       _dst,
+                                           const sampleFrame* _src,
+                                           real_t             _coeffSrc,
+                                           const real_t*      _coeffs,
+                                           int                _frames)
+{
+    int f = 0;
+    for(; f + FRAMES <= _frames; f += FRAMES)
+    {
+        const vec_t s = load(_src + f);
+        const vec_t c = _coeffSrc * frameCoeffs(_coeffs + f);
+        store(_dst + f, load(_dst + f) + select(finite(s), s * c));
+    }
+    Scalar::addSanitizedMultipliedByBuffer(_dst + f, _src + f, _coeffSrc,
+                                           _coeffs + f, _frames - f);
+}
+
+static void addSanitizedMultipliedByBuffers(sampleFrame*       _dst,
+                                            const sampleFrame* _src,
+                                            const real_t*      _coeffs1,
+                                            const real_t*      _coeffs2,
+                                            int                _frames)
+{
+    int f = 0;
+    for(; f + FRAMES <= _frames; f += FRAMES)
+    {
+        const vec_t s = load(_src + f);
+        const vec_t c = frameCoeffs(_coeffs1 + f, _coeffs2 + f);
+        store(_dst + f, load(_dst + f) + select(finite(s), s * c));
+    }
+    Scalar::addSanitizedMultipliedByBuffers(_dst + f, _src + f, _coeffs1 + f,
+                                            _coeffs2 + f, _frames - f);
+}
+
+static void addMultipliedStereo(sampleFrame*       _dst,
+                                const sampleFrame* _src,
+                                real_t             _coeffSrcLeft,
+                                real_t             _coeffSrcRight,
+                                int                _frames)
+{
+    vec_t c;
+    for(int k = 0; k < FRAMES; ++k)
+    {
+        c[2 * k]     = _coeffSrcLeft;
+        c[2 * k + 1] = _coeffSrcRight;
+    }
+
+    int f = 0;
+    for(; f + FRAMES <= _frames; f += FRAMES)
+        store(_dst + f, load(_dst + f) + load(_src + f) * c);
+    Scalar::addMultipliedStereo(_dst + f, _src + f, _coeffSrcLeft,
+                                _coeffSrcRight, _frames - f);
+}
+
+static void multiplyAndAddMultiplied(sampleFrame*       _dst,
+                                     const sampleFrame* _src,
+                                     real_t             _coeffDst,
+                                     real_t             _coeffSrc,
+                                     int                _frames)
+{
+    int f = 0;
+    for(; f + FRAMES <= _frames; f += FRAMES)
+        store(_dst + f,
+              load(_dst + f) * _coeffDst + load(_src + f) * _coeffSrc);
+    Scalar::multiplyAndAddMultiplied(_dst + f, _src + f, _coeffDst,
+                                     _coeffSrc, _frames - f);
+}
+
+static void multiplyAndAddMultipliedJoined(sampleFrame*    _dst,
+                                           const sample_t* _srcLeft,
+                                           const sample_t* _srcRight,
+                                           real_t          _coeffDst,
+                                           real_t          _coeffSrc,
+                                           int             _frames)
+{
+    int f = 0;
+    for(; f + FRAMES <= _frames; f += FRAMES)
+        store(_dst + f, load(_dst + f) * _coeffDst
+                                + joined(_srcLeft + f, _srcRight + f)
+                                          * _coeffSrc);
+    Scalar::multiplyAndAddMultipliedJoined(_dst + f, _srcLeft + f,
+                                           _srcRight + f, _coeffDst,
+                                           _coeffSrc, _frames - f);
+}
+
+static const Kernels KERNELS = {isClipping,
+                                sanitize,
+                                unclip,
+                                add,
+                                addSanitized,
+                                addMultiplied,
+                                addMultipliedByValues,
+                                addSwappedMultiplied,
+                                addMultipliedByBuffer,
+                                addMultipliedByBuffers,
+                                addSanitizedMultiplied,
+                                addSanitizedMultipliedByBuffer,
+                                addSanitizedMultipliedByBuffers,
+                                addMultipliedStereo,
+                                multiplyAndAddMultiplied,
+                                multiplyAndAddMultipliedJoined};
+
+}  // namespace MIXHELPERS_ISA
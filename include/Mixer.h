@@ -24,13 +24,14 @@
 #ifndef MIXER_H
 #define MIXER_H
 
-//#include "LocklessList.h"
 #include "AudioPort.h"
 #include "Configuration.h"
+#include "LocklessList.h"
 #include "MemoryManager.h"
 #include "MixerProfiler.h"
 #include "Note.h"
 #include "NotePlayHandle.h"
+#include "PlayHandleRegistry.h"
 #include "Ring.h"
 #include "fifo_buffer.h"
 #include "lmms_basics.h"
@@ -92,6 +93,7 @@ class HandleManager : public QThread
     void removePlayHandlesOfTypesHM(const Track* _track, const quint8 _types);
     void removePlayHandlesForInstrumentHM(const Instrument* _instrument);
     void removeAllPlayHandlesHM();
+    void deleteRemovedPlayHandlesHM();
 
   private:
     Mixer* m_mixer;
@@ -260,6 +262,13 @@ class EXPORT Mixer : public QObject
     void waitUntilNoPlayHandle(const Track* _track, const quint8 _types);
     void waitUntilNoPlayHandle(const Instrument* _instrument);
 
+    // hands a new play handle over to the rendering thread without
+    // locking or allocating, callable from any thread. The handle starts
+    // playing in the next period (or the current one when called while
+    // the song is processed). Falls back to the handle manager when the
+    // queue is full.
+    void addPlayHandle(PlayHandlePointer handle);
+
     void adjustTempo(const bpm_t _tempo);
 
     // methods providing information for other classes
@@ -378,6 +387,8 @@ class EXPORT Mixer : public QObject
         return QThread::currentThread() == m_handleManager;
     }
 
+    static bool isRenderingThread();
+
   signals:
     void qualitySettingsChanged();
     void sampleRateChanged();
@@ -404,13 +415,16 @@ class EXPORT Mixer : public QObject
     MidiClient*  tryMidiClients();
 
     const surroundSampleFrame* renderNextBuffer();
+    void                       processJobGraph();
 
     void addAudioPort1(AudioPortPointer port);
     void removeAudioPort1(AudioPortPointer port);
 
     void addPlayHandle1(PlayHandlePointer handle);
+    void addNewPlayHandles();
     void removePlayHandle1(PlayHandlePointer handle);
     void deletePlayHandle1(PlayHandlePointer _ph);
+    void deleteRemovedPlayHandles1();
     void removePlayHandlesOfTypes1(const Track* _track, const quint8 types);
     void removePlayHandlesForInstrument1(const Instrument* _instrument);
     void removeAllPlayHandles1();
@@ -444,11 +458,17 @@ class EXPORT Mixer : public QObject
     int                         m_numWorkers;
 
     // playhandle stuff
-    PlayHandleList m_playHandles;
-    PlayHandleList m_playHandlesToAdd;
-    PlayHandleList m_playHandlesToRemove; /*Const*/
+    PlayHandleRegistry m_playHandles;
+    PlayHandleRegistry m_playHandlesToAdd;
+    PlayHandleRegistry m_playHandlesToRemove; /*Const*/
+    // snapshots of the jobs processed in the current period
+    QVector<PlayHandlePointer> m_graphHandles;
+    QVector<AudioPortPointer>  m_graphPorts;
     // place where new playhandles are added temporarily
-    // LocklessList<PlayHandle *> m_newPlayHandles;
+    LocklessList<PlayHandle*> m_newPlayHandles;
+    // removed by the handle manager, deleted together after a single
+    // synchronization of the registries
+    QVector<PlayHandlePointer> m_playHandlesToDelete;
 
     struct qualitySettings m_qualitySettings;
     real_t                 m_masterVolumeGain;
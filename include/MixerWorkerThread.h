@@ -28,10 +28,11 @@
 #include "AudioPort.h"
 #include "SafeList.h"
 
-#include <QAtomicPointer>
 #include <QThread>
+#include <QVector>
 
 #include <AtomicInt.h>
+#include <atomic>
 
 class QWaitCondition;
 class Mixer;
@@ -40,8 +41,58 @@ class ThreadableJob;
 class MixerWorkerThread : public QThread
 {
   public:
+    // lock-free work-stealing deque (Chase-Lev). The owner thread pushes
+    // and pops at the bottom, the other threads steal from the top. The
+    // storage is sized by reserve() before the jobs are queued, grows
+    // when full anyway and is never shrunk.
+    class JobDeque
+    {
+      public:
+        JobDeque(int _capacity = 256);
+        ~JobDeque();
+
+        void           push(ThreadableJob* _job);  // owner only
+        ThreadableJob* pop();                      // owner only
+        ThreadableJob* steal();                    // any thread
+
+        // while no job is queued
+        void reserve(long _jobs);
+
+      private:
+        struct Array
+        {
+            Array(long _size);
+            ~Array();
+
+            ThreadableJob* get(long _i) const
+            {
+                return m_items[_i & m_mask].load(std::memory_order_relaxed);
+            }
+
+            void put(long _i, ThreadableJob* _job)
+            {
+                m_items[_i & m_mask].store(_job, std::memory_order_relaxed);
+            }
+
+            const long                   m_size;
+            const long                   m_mask;
+            std::atomic<ThreadableJob*>* m_items;
+        };
+
+        Array* resize(Array* _a, long _top, long _bottom, long _size);
+
+        std::atomic<long>   m_top;
+        std::atomic<long>   m_bottom;
+        std::atomic<Array*> m_array;
+        // replaced arrays, thieves may still be reading them
+        QVector<Array*> m_retired;
+    };
+
     // internal representation of the job queue - all functions are
-    // thread-safe
+    // thread-safe. There is one deque per worker thread and one for the
+    // other threads (the thread rendering the period). Jobs are pushed on
+    // the deque of the calling thread and idle workers steal from the
+    // others.
     class JobQueue
     {
       public:
@@ -51,12 +102,14 @@ class MixerWorkerThread : public QThread
             Dynamic  // jobs can be added while processing queue
         };
 
-        JobQueue() :
-              m_items(), m_queueSize(0), m_itemsDone(0), m_opMode(Static)
-        {
-        }
+        JobQueue();
+        ~JobQueue();
+
+        int addDeque();
 
         void reset(OperationMode _opMode);
+        // any deque may get all the jobs, called while the workers are idle
+        void reserve(int _jobs);
 
         void addJob(ThreadableJob* _job);
 
@@ -64,12 +117,12 @@ class MixerWorkerThread : public QThread
         void wait();
 
       private:
-#define JOB_QUEUE_SIZE 256
-        // 2048
-        QAtomicPointer<ThreadableJob> m_items[JOB_QUEUE_SIZE];
-        AtomicInt                     m_queueSize;
-        AtomicInt                     m_itemsDone;
-        OperationMode                 m_opMode;
+        void           jobDone(ThreadableJob* _job);
+        ThreadableJob* takeJob(int _index);
+
+        QVector<JobDeque*> m_deques;
+        AtomicInt          m_pending;
+        OperationMode      m_opMode;
     };
 
     MixerWorkerThread(Mixer* mixer);
@@ -83,6 +136,11 @@ class MixerWorkerThread : public QThread
         s_globalJobQueue.reset(_opMode);
     }
 
+    static void reserveJobs(int _jobs)
+    {
+        s_globalJobQueue.reserve(_jobs);
+    }
+
     static void addJob(ThreadableJob* _job)
     {
         s_globalJobQueue.addJob(_job);
@@ -123,6 +181,7 @@ class MixerWorkerThread : public QThread
     static SafeList<MixerWorkerThread*> s_workerThreads;
 
     volatile bool m_quit;
+    int           m_dequeIndex;
 };
 
 #endif
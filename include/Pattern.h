@@ -88,6 +88,12 @@ class EXPORT Pattern : public Tile
         return m_notes;
     }
 
+    // the notes starting at _tick are [_first,_last[. For the playback
+    // only: a cursor makes increasing ticks O(1) and seeks O(log n).
+    void notesAt(tick_t                 _tick,
+                 Notes::const_iterator& _first,
+                 Notes::const_iterator& _last) const;
+
     const Chords chords() const;
 
     Note* noteAtStep(int _step);
@@ -159,6 +165,11 @@ class EXPORT Pattern : public Tile
     PatternTypes     m_patternType;
     Notes            m_notes;
 
+    // shared copy of m_notes for notesAt(), any edit detaches m_notes
+    mutable Notes  m_playNotes;
+    mutable int    m_playCursor;  // first note at or after m_playTick
+    mutable tick_t m_playTick;
+
     friend class PatternView;
     friend class BBEditor;
 
@@ -39,7 +39,7 @@ class QThread;
 
 class Track;
 class Instrument;
-// class AudioPort;
+class AudioPort;
 class PlayHandle;
 
 typedef QSharedPointer<PlayHandle>        PlayHandlePointer;
@@ -67,22 +67,52 @@ class PlayHandle : public ThreadableJob
         MaxNumber = 1024
     };
 
+    // registries a handle can be in at the same time,
+    // see PlayHandleRegistry
+    enum RegistryHooks
+    {
+        MixerHook,
+        MixerToAddHook,
+        MixerToRemoveHook,
+        AudioPortHook,
+        NumRegistryHooks
+    };
+
     Type type() const
     {
         return m_type;
     }
 
-    /*
-    INLINE AudioPort* audioPort() const
+    // the audio port mixing this handle, set by AudioPort::addPlayHandle()
+    INLINE AudioPort* mixingPort() const
     {
-        return m_audioPort;
+        return m_mixingPort;
     }
 
-    INLINE void setAudioPort(AudioPort* port)
+    INLINE void setMixingPort(AudioPort* _port)
     {
-        m_audioPort = port;
+        m_mixingPort = _port;
+    }
+
+    // handoff to the rendering thread, see Mixer::addPlayHandle()
+    INLINE void setHandedOff()
+    {
+        m_handoffState.storeRelease(HandedOff);
+    }
+
+    // called by the handle manager, returns true when the handle is still
+    // in the queue of the mixer. The removal is then done by the mixer.
+    INLINE bool deferRemoval()
+    {
+        return m_handoffState.testAndSetOrdered(HandedOff, RemovalDeferred);
+    }
+
+    // called by the mixer, returns true when a removal was deferred
+    INLINE bool takeHandedOff()
+    {
+        return m_handoffState.fetchAndStoreOrdered(NotHandedOff)
+               == RemovalDeferred;
     }
-    */
 
     virtual void enterMixer() = 0;
     virtual void exitMixer()  = 0;
@@ -186,12 +216,23 @@ class PlayHandle : public ThreadableJob
 
     virtual void doProcessing() final;
 
-    // AudioPortPointer m_audioPort;
-    bool m_finished;
+    AudioPort* m_mixingPort;
+    AtomicInt  m_handoffState;
+    bool       m_finished;
 
   private:
+    enum HandoffStates
+    {
+        NotHandedOff,
+        HandedOff,
+        RemovalDeferred
+    };
+
     virtual void releaseBuffer() final;
 
+    // slot index in each registry, -1 when not registered
+    AtomicInt m_registrySlots[NumRegistryHooks];
+
     Type         m_type;
     f_cnt_t      m_offset;
     Mutex        m_processingLock;
@@ -200,6 +241,8 @@ class PlayHandle : public ThreadableJob
     // bool               m_bufferReleased;
     // int                m_refCount;
     PlayHandlePointer* m_pointer;
+
+    friend class PlayHandleRegistry;
 };
 
 #endif
@@ -0,0 +1,178 @@
+/*
+ * PlayHandleRegistry.h - slot-indexed set of play handles
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PLAY_HANDLE_REGISTRY_H
+#define PLAY_HANDLE_REGISTRY_H
+
+#include "MemoryManager.h"
+#include "PlayHandle.h"
+
+#include <QMutex>
+#include <QSemaphore>
+
+#include <atomic>
+
+// Replaces SafeList<PlayHandlePointer> on the audio path.
+//
+// The registry is a fixed array of slots. The index of the slot holding a
+// handle is stored in the handle itself (one index per hook, so a handle
+// can be in several registries), which makes insert, remove and contains
+// O(1). Free slots are tracked in a bitmap. Nothing locks nor allocates
+// after construction, iteration just scans the slots up to the highest
+// one ever used. The capacities come from the settings
+// (mixer/maxplayhandles and mixer/maxplayhandlesperport).
+//
+// Readers are counted per epoch. A thread that is about to delete removed
+// handles calls synchronize(), which sleeps until every reader that could
+// still see them is gone; the last reader wakes it up. synchronize() may
+// block and must not be called by the rendering thread. Removing several
+// handles then synchronizing once costs a single wait.
+class PlayHandleRegistry
+{
+    MM_OPERATORS
+
+  public:
+    PlayHandleRegistry(PlayHandle::RegistryHooks _hook, int _capacity);
+    virtual ~PlayHandleRegistry();
+
+    // returns false if the handle is already in or the registry is full
+    bool insert(PlayHandle* _ph);
+    bool remove(PlayHandle* _ph);
+
+    INLINE bool contains(const PlayHandle* _ph) const
+    {
+        const int s = _ph->m_registrySlots[m_hook].loadAcquire();
+        return s >= 0 && m_slots[s].load(std::memory_order_acquire) == _ph;
+    }
+
+    INLINE int size() const
+    {
+        return m_size.load(std::memory_order_relaxed);
+    }
+
+    INLINE bool isEmpty() const
+    {
+        return size() == 0;
+    }
+
+    INLINE int capacity() const
+    {
+        return m_capacity;
+    }
+
+    // same names as SafeList, to keep the call sites unchanged. Returns
+    // false if the registry is full.
+    INLINE bool appendUnique(const PlayHandlePointer& _ph)
+    {
+        return contains(_ph.data()) || insert(_ph.data());
+    }
+
+    INLINE int removeAll(const PlayHandlePointer& _ph, bool _check = true)
+    {
+        if(remove(_ph.data()))
+            return 1;
+        if(_check)
+            qCritical("PlayHandleRegistry::removeAll doesn't contain that "
+                      "element");
+        return 0;
+    }
+
+    INLINE bool contains(const PlayHandlePointer& _ph) const
+    {
+        return contains(_ph.data());
+    }
+
+    void clear();
+
+    template <typename F>
+    void map(F _f, bool _clear = false)
+    {
+        const int epoch = enterRead();
+        const int hw    = m_highWater.load(std::memory_order_acquire);
+        for(int s = 0; s < hw; ++s)
+        {
+            PlayHandle* ph = m_slots[s].load(std::memory_order_acquire);
+            if(ph == nullptr)
+                continue;
+            _f(ph->pointer());
+            if(_clear)
+                remove(ph);
+        }
+        leaveRead(epoch);
+    }
+
+    template <typename F>
+    void map(F _f) const
+    {
+        const_cast<PlayHandleRegistry*>(this)->map(_f, false);
+    }
+
+    // keeps the handles seen inside the section alive
+    class ReadSection
+    {
+      public:
+        ReadSection(PlayHandleRegistry& _registry) :
+              m_registry(_registry), m_epoch(_registry.enterRead())
+        {
+        }
+
+        ~ReadSection()
+        {
+            m_registry.leaveRead(m_epoch);
+        }
+
+      private:
+        PlayHandleRegistry& m_registry;
+        int                 m_epoch;
+    };
+
+    // waits until the readers entered before the call are gone
+    void synchronize();
+
+  private:
+    int  enterRead();
+    void leaveRead(int _epoch);
+    void wakeSynchronizer(int _parity);
+
+    int  allocSlot();
+    void freeSlot(int _s);
+
+    const PlayHandle::RegistryHooks m_hook;
+    const int                       m_capacity;
+
+    std::atomic<PlayHandle*>* m_slots;
+    std::atomic<quint32>*     m_used;
+    int                       m_words;
+
+    std::atomic<int> m_size;
+    std::atomic<int> m_highWater;
+    std::atomic<int> m_hint;
+
+    std::atomic<int> m_epoch;
+    std::atomic<int> m_readers[2];
+    QMutex           m_syncMutex;
+    // 1 + the parity of the epoch waited for, 0 if none
+    std::atomic<int> m_waiting;
+    QSemaphore       m_synchronized;
+};
+
+#endif
@@ -28,6 +28,8 @@
 #include "DataFile.h"
 #include "lmms_basics.h"
 
+#include <QByteArray>
+#include <QElapsedTimer>
 #include <QHash>
 #include <QStack>
 #include <QObject>
@@ -97,26 +99,44 @@ class ProjectJournal : public QObject
   private:
     typedef QHash<jo_id_t, JournallingObject*> JoIdMap;
 
+    // The value of a model is kept as is. Anything else is kept as its
+    // state, serialized and compressed: a DOM per check point was most of
+    // the memory of the journal.
     struct CheckPoint
     {
-        CheckPoint(jo_id_t         initID = 0,
-                   const DataFile& initData
-                   = DataFile(DataFile::JournalData)) :
-              joID(initID),
-              data(initData)
+        CheckPoint(jo_id_t _joID = 0) :
+              joID(_joID), isValue(false), value(0.)
         {
         }
 
-        jo_id_t  joID;
-        DataFile data;
+        jo_id_t    joID;
+        bool       isValue;
+        real_t     value;
+        QByteArray state;
+
+        int size() const
+        {
+            return int(sizeof(CheckPoint)) + state.size();
+        }
     };
 
     typedef QStack<CheckPoint> CheckPointStack;
 
+    static CheckPoint checkPoint(JournallingObject* _jo);
+    static void       restore(JournallingObject* _jo, const CheckPoint& _c);
+
+    // removes the oldest check points above MAX_UNDO_STATES or above
+    // app/undomb
+    void bound(CheckPointStack& _stack);
+
     JoIdMap m_joIDs;
 
     CheckPointStack m_undoCheckPoints;
     CheckPointStack m_redoCheckPoints;
+    qint64          m_maxBytes;
+
+    // the changes of a model in a short time are undone at once
+    QElapsedTimer m_lastValueTimer;
 
     bool m_journalling;
 };
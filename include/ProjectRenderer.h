@@ -77,6 +77,9 @@ class ProjectRenderer : public QThread
         return m_fileDev->outputFile();
     }
 
+    // the output files of the other formats
+    QStringList mirrorFiles() const;
+
     inline bool aborted()
     {
         return m_abort;
@@ -88,6 +91,16 @@ class ProjectRenderer : public QThread
 
     static const FileEncodeDevice& fileEncodeDevices(int i);
 
+    // devices capturing stems during the same pass, not owned
+    void addStemDevice(AudioFileDevice* _dev)
+    {
+        m_stemDevices.append(_dev);
+    }
+
+    // also writes the master output in another format, into the output
+    // file with the extension of that format
+    bool addMirrorFormat(ExportFileFormats _fmt);
+
   public slots:
     void startProcessing();
     void abortProcessing();
@@ -100,8 +113,11 @@ class ProjectRenderer : public QThread
   private:
     virtual void run();
 
-    AudioFileDevice*       m_fileDev;
-    Mixer::qualitySettings m_qualitySettings;
+    AudioFileDevice*          m_fileDev;
+    QVector<AudioFileDevice*> m_mirrorDevices;
+    QVector<AudioFileDevice*> m_stemDevices;
+    OutputSettings            m_outputSettings;
+    Mixer::qualitySettings    m_qualitySettings;
 
     volatile int  m_progress;
     volatile bool m_abort;
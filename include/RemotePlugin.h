@@ -473,6 +473,11 @@ class EXPORT RemotePluginBase
             return (float)atof(data[_p].c_str());
         }
 
+        INLINE int size() const
+        {
+            return int(data.size());
+        }
+
         INLINE bool operator==(const message& _m) const
         {
             return (id == _m.id);
@@ -743,6 +748,19 @@ class EXPORT RemotePlugin : public QObject, public RemotePluginBase
 
     bool process(const sampleFrame* _in_buf, sampleFrame* _out_buf);
 
+    // In pipelined mode, process() hands the period N to the remote
+    // process and returns the output of the period N-1, so both
+    // processes work at the same time. The cost is one period of latency.
+    void setPipelined(bool _on);
+
+    INLINE bool isPipelined() const
+    {
+        return m_pipelined;
+    }
+
+    // added latency, in frames
+    f_cnt_t latency() const;
+
     void processMidiEvent(const MidiEvent&, const f_cnt_t _offset);
 
     void updateSampleRate(sample_rate_t _sr)
@@ -789,6 +807,9 @@ class EXPORT RemotePlugin : public QObject, public RemotePluginBase
 
   private:
     void resizeSharedProcessingMemory();
+    void writeInput(float* _shm, const sampleFrame* _in_buf, fpp_t _frames);
+    void readOutput(const float* _shm, sampleFrame* _out_buf, fpp_t _frames);
+    void waitForProcessingDone();
 
     bool m_failed;
 
@@ -808,6 +829,10 @@ class EXPORT RemotePlugin : public QObject, public RemotePluginBase
     int m_inputCount;
     int m_outputCount;
 
+    bool          m_pipelined;
+    volatile bool m_pending;  // a period is being processed remotely
+    int           m_half;     // half for the next period, -1 at start
+
 #ifndef SYNC_WITH_SHM_FIFO
     int     m_server;
     QString m_socketFile;
@@ -904,7 +929,7 @@ class RemotePluginClient : public RemotePluginBase
 
   private:
     void setShmKey(key_t _key, int _size);
-    void doProcessing();
+    void doProcessing(int _offset = 0);
 
 #ifdef USE_QT_SHMEM
     QSharedMemory m_shmObj;
@@ -1221,7 +1246,8 @@ bool RemotePluginClient::processMessage(const message& _m)
             break;
 
         case IdStartProcessing:
-            doProcessing();
+            // pipelined hosts give the offset of the buffer to use
+            doProcessing(_m.size() > 0 ? _m.getInt(0) : 0);
             reply_message.id = IdProcessingDone;
             reply            = true;
             break;
@@ -1288,12 +1314,13 @@ void RemotePluginClient::setShmKey(key_t _key, int _size)
 #endif
 }
 
-void RemotePluginClient::doProcessing()
+void RemotePluginClient::doProcessing(int _offset)
 {
     if(m_shm != nullptr)
     {
-        process((sampleFrame*)(m_inputCount > 0 ? m_shm : nullptr),
-                (sampleFrame*)(m_shm + (m_inputCount * m_bufferSize)));
+        float* shm = m_shm + _offset;
+        process((sampleFrame*)(m_inputCount > 0 ? shm : nullptr),
+                (sampleFrame*)(shm + (m_inputCount * m_bufferSize)));
     }
     else
     {
@@ -29,8 +29,11 @@
 #include <vector>
 
 //#include "OutputSettings.h"
+#include "AudioPort.h"
 #include "ProjectRenderer.h"
 
+class FxChannel;
+
 class RenderManager : public QObject
 {
     Q_OBJECT
@@ -43,6 +46,13 @@ class RenderManager : public QObject
 
     virtual ~RenderManager();
 
+    // writes the same render in another format too, encoded in parallel
+    void addFormat(ProjectRenderer::ExportFileFormats _fmt)
+    {
+        if(_fmt != m_format && !m_mirrorFormats.contains(_fmt))
+            m_mirrorFormats.append(_fmt);
+    }
+
     /// Export all unmuted tracks into a single file
     void renderProject();
 
@@ -52,6 +62,10 @@ class RenderManager : public QObject
     /// Export all unmuted tracks into individual file
     void renderTracks();
 
+    /// Export all unmuted tracks and channels into individual files,
+    /// in a single pass
+    void renderStems();
+
     void abortProcessing();
 
   signals:
@@ -63,20 +77,35 @@ class RenderManager : public QObject
 
   private slots:
     void renderNextTrack();
+    void finishStems();
     void updateConsoleProgress();
 
   private:
     QString pathForTrack(const Track* track, int num);
+    QString pathForChannel(const FxChannel* channel, int num);
     void    restoreMutedState();
 
+    void             renderInOnePass(bool _tracks, bool _channels);
+    void             addMirrorFormats();
+    AudioFileDevice* createStemDevice(const QString&                    _path,
+                                      ProjectRenderer::ExportFileFormats _fmt);
+    void             clearStems(bool _aborted);
+
     const Mixer::qualitySettings       m_qualitySettings;
     const Mixer::qualitySettings       m_oldQualitySettings;
     const OutputSettings               m_outputSettings;
     ProjectRenderer::ExportFileFormats m_format;
+    QVector<ProjectRenderer::ExportFileFormats> m_mirrorFormats;
     QString                            m_outputPath;
     ProjectRenderer*                   m_activeRenderer;
     Tracks                             m_tracksToRender;
     Tracks                             m_unmuted;
+
+    // single pass rendering
+    QVector<AudioFileDevice*> m_stemDevices;
+    QVector<AudioFileDevice*> m_stemMirrors;
+    QVector<AudioPortPointer> m_stemPorts;
+    QVector<FxChannel*>       m_stemChannels;
 };
 
 #endif
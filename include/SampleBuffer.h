@@ -275,6 +275,11 @@ class EXPORT SampleBuffer : public QObject  //, public sharedObject
     static QString       tryToMakeRelative(const QString& _file);
     static QString       tryToMakeAbsolute(const QString& _file);
     static void          clearMMap();
+    // starts decoding the file into the disk cache in the pool, once per
+    // file. The buffers loading the file wait for it.
+    static void warmCache(const QString& _audioFile);
+    // waits for all the files being decoded
+    static void waitForWarmCache(bool _cancel = false);
 
   public slots:
     void setAudioFile(const QString& _audioFile);
@@ -302,11 +307,21 @@ class EXPORT SampleBuffer : public QObject  //, public sharedObject
                               const real_t   _step);
 
     void update(bool _keep_settings = false);
-    void prefetch(f_cnt_t _index);
+    // asks the streamer to read the mapped cache around _index
+    void prefetch(f_cnt_t _index, bool _backwards = false);
 
     void getDataFrame(f_cnt_t _f, sample_t& ch0_, sample_t& ch1_);
     void setDataFrame(f_cnt_t _f, sample_t _ch0, sample_t _ch1);
     void writeCacheData(QString _fileName) const;
+    bool mapFile(const QString& _fileName);
+    QString cacheKey(const QString&      _file,
+                     const sample_rate_t _samplerate) const;
+    bool    decodeFile(const QString& _filename, sample_rate_t& _samplerate);
+    static void decodeForCache(const QString& _file);
+    static void waitForWarming(const QString& _file);
+    bool decodeToCache(const QString&      _file,
+                       const QString&      _cache,
+                       const sample_rate_t _samplerate);
 
     void convertFromS16(sampleS16_t*& _ibuf, f_cnt_t _frames, int _channels);
     void directFloatWrite(sample_t*& _fbuf, f_cnt_t _frames, int _channels);
@@ -0,0 +1,57 @@
+/*
+ * SampleCache.h - shared on-disk cache of the decoded samples
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SAMPLE_CACHE_H
+#define SAMPLE_CACHE_H
+
+#include "export.h"
+#include "lmms_basics.h"
+
+#include <QString>
+
+// The samples, once decoded, resampled, reversed, stretched and delayed,
+// are written as raw frames (like the .f2r caches) in the user cache
+// directory. An entry is named after the content of the audio file and
+// the parameters, so it is found again whatever the path of the file and
+// it is shared by all the running processes. The entries are written
+// aside then renamed, and the least recently used ones are removed when
+// the cache is bigger than mixer/samplediskcachemb (4096 MB by default).
+namespace SampleCache
+{
+
+// false when disabled in the settings (mixer/samplediskcache)
+EXPORT bool isEnabled();
+
+// the key of the file for the given parameters, empty if the file can
+// not be read
+EXPORT QString key(const QString& _file, const QString& _params);
+
+// the path of the entry if it exists, empty otherwise
+EXPORT QString find(const QString& _key);
+
+EXPORT bool store(const QString&     _key,
+                  const sampleFrame* _data,
+                  const f_cnt_t      _frames);
+
+};  // namespace SampleCache
+
+#endif
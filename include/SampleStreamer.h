@@ -0,0 +1,119 @@
+/*
+ * SampleStreamer.h - keeps the played parts of the mapped sample caches
+ *                    in memory
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SAMPLE_STREAMER_H
+#define SAMPLE_STREAMER_H
+
+#include "LocklessList.h"
+#include "export.h"
+#include "lmms_basics.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <atomic>
+
+// The big samples are played from their raw cache (.f2r<rate>), mapped in
+// memory. The mapped files are split in chunks: the players request the
+// chunk they are playing and the streamer thread reads it and the next
+// ones ahead of time, so the audio threads do not wait for the disk.
+// The resident chunks are bounded (mixer/samplecachemb), the least
+// recently played ones are dropped first.
+class EXPORT SampleStreamer : public QThread
+{
+  public:
+    // 1 MB of stereo frames
+    static const f_cnt_t CHUNK_FRAMES = 65536;
+
+    struct Stats
+    {
+        qint64 hits;        // the played chunk was resident
+        qint64 misses;      // the played chunk had to be read
+        qint64 prefetched;  // chunks read ahead of the players
+        qint64 evicted;
+        qint64 residentBytes;
+    };
+
+    static SampleStreamer* inst();
+    static void            cleanup();
+
+    // called when a cache is mapped or unmapped
+    void addMapping(const sampleFrame* _base, const f_cnt_t _frames);
+    void removeMapping(const sampleFrame* _base);
+    void clear();
+
+    // called by the players, does not allocate and only locks to wake
+    // the streamer up when it sleeps. Returns false if the request is
+    // dropped because the queue is full.
+    bool request(const sampleFrame* _base,
+                 const f_cnt_t      _index,
+                 const bool         _backwards = false);
+
+    Stats stats() const;
+
+  protected:
+    virtual void run();
+
+  private:
+    SampleStreamer();
+    virtual ~SampleStreamer();
+
+    struct Request
+    {
+        const sampleFrame* base;
+        f_cnt_t            index;
+        bool               backwards;
+    };
+
+    typedef QPair<const sampleFrame*, int> ChunkKey;
+
+    void serve(const Request& _r);
+    void touch(const ChunkKey& _key, bool _played);
+    void load(const ChunkKey& _key);
+    void evict(const ChunkKey& _key);
+    qint64 chunkBytes(const ChunkKey& _key) const;
+
+    static SampleStreamer* s_instance;
+
+    LocklessList<Request> m_requests;
+    volatile bool         m_stop;
+
+    // the streamer sleeps until a request is pushed
+    QMutex            m_wakeMutex;
+    QWaitCondition    m_wake;
+    std::atomic<bool> m_sleeping;
+
+    // the mappings and the chunks, used by the streamer thread
+    mutable QMutex                     m_mutex;
+    QHash<const sampleFrame*, f_cnt_t> m_mappings;
+    QHash<ChunkKey, qint64>            m_resident;  // last use
+    qint64                             m_clock;
+    qint64                             m_budget;
+    int                                m_readAhead;
+    Stats                              m_stats;
+};
+
+#endif
@@ -37,12 +37,17 @@
 
 //#include <QSharedMemory>
 //#include <QVector>
+#include <QHash>
+#include <QPointer>
+#include <QSet>
+#include <QVector>
 
 #include <cmath>
 #include <utility>
 
 class AutomationTrack;
 class AutomationPattern;
+class FxChannel;
 class Pattern;
 class TimeLineWidget;
 
@@ -91,6 +96,9 @@ class EXPORT Song : public TrackContainer, public virtual Transportable
         return m_nLoadingTrack;
     }
 
+    // the time spent on each track, reported at the end of the load
+    void addLoadProfile(const QString& _what, const qint64 _ms);
+
     INLINE int getMilliseconds() const
     {
         return m_elapsedMilliSeconds;
@@ -409,6 +417,12 @@ class EXPORT Song : public TrackContainer, public virtual Transportable
     void processAutomations(const TrackList& tracks,
                             MidiTime         timeStart,
                             fpp_t            frames);
+    void collectAutomations(const TrackList& tracks, MidiTime timeStart);
+    void renderAutomations(f_cnt_t _offset,
+                           real_t  _currentFrame,
+                           fpp_t   _frames);
+    void flushAutomations();
+    void clearAutomationBuffers();
 
     AutomationTrack* m_globalAutomationTrack;
 
@@ -423,7 +437,8 @@ class EXPORT Song : public TrackContainer, public virtual Transportable
 
     Controllers m_controllers;
 
-    int m_nLoadingTrack;
+    int                              m_nLoadingTrack;
+    QVector<QPair<QString, qint64>> m_loadProfile;
 
     QString m_fileName;
     QString m_oldFileName;
@@ -444,7 +459,27 @@ class EXPORT Song : public TrackContainer, public virtual Transportable
 
     QStringList m_errors;
 
-    AutomatedValueMap m_automatedValues;
+    // sample-exact automation of one model during the current period
+    struct AutomationBuffer
+    {
+        QPointer<AutomatableModel> model;  // null once destroyed
+        ValueBuffer                values;
+        f_cnt_t                    filled;  // frames rendered so far
+        long                       period;
+        long checked;  // last period the model was found automated
+        QPointer<FxChannel> channel;  // delays the audio of the model
+
+        AutomationBuffer(AutomatableModel* _model, int _length) :
+              model(_model), values(_length), filled(0), period(-1),
+              checked(-1)
+        {
+        }
+    };
+
+    AutomatedSourceMap                          m_automatedSources;
+    QSet<const AutomatableModel*>               m_recordedModels;
+    QHash<AutomatableModel*, AutomationBuffer*> m_automationBuffers;
+    QVector<AutomationBuffer*>                  m_renderedAutomations;
     PlayModes         m_playMode;
     PlayPos           m_playPos[Mode_Count];
     tact_t            m_length;
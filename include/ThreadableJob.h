@@ -40,7 +40,9 @@ class ThreadableJob
         Done
     };
 
-    ThreadableJob() : m_state(ThreadableJob::Unstarted)
+    ThreadableJob() :
+          m_state(ThreadableJob::Unstarted), m_pendingDependencies(0),
+          m_dependent(nullptr)
     {
     }
 
@@ -75,11 +77,46 @@ class ThreadableJob
 
     virtual bool requiresProcessing() const = 0;
 
+    // per-period job graph: a job is queued once all the jobs it depends
+    // on are done. When it is done itself, its dependent is notified.
+    virtual void setDependencies(int _n) final
+    {
+        m_pendingDependencies = _n;
+    }
+
+    virtual void addDependency() final
+    {
+        m_pendingDependencies.ref();
+    }
+
+    // returns true when the last pending dependency has been met
+    virtual bool dependencyDone() final
+    {
+        return m_pendingDependencies.fetchAndAddOrdered(-1) == 1;
+    }
+
+    virtual bool hasPendingDependencies() const final
+    {
+        return (int)m_pendingDependencies > 0;
+    }
+
+    virtual ThreadableJob* dependent() const final
+    {
+        return m_dependent;
+    }
+
+    virtual void setDependent(ThreadableJob* _job) final
+    {
+        m_dependent = _job;
+    }
+
   protected:
     virtual void doProcessing() = 0;
 
   private:
-    AtomicInt m_state;
+    AtomicInt      m_state;
+    AtomicInt      m_pendingDependencies;
+    ThreadableJob* m_dependent;
 };
 
 #endif
@@ -97,6 +97,9 @@ class EXPORT TrackContainer : public Model, public JournallingObject
     virtual void automatedValuesAt(MidiTime           time,
                                    int                tcoNum /*= -1*/,
                                    AutomatedValueMap& _map) const;
+    virtual void automatedSourcesAt(MidiTime            time,
+                                    int                 tcoNum /*= -1*/,
+                                    AutomatedSourceMap& _map) const;
 
   signals:
     void trackAdded(Track* _track);
@@ -107,6 +110,10 @@ class EXPORT TrackContainer : public Model, public JournallingObject
                                           MidiTime           timeStart,
                                           int                tcoNum /*= -1*/,
                                           AutomatedValueMap& _map);
+    static void automatedSourcesFromTracks(const Tracks&       tracks,
+                                           MidiTime            timeStart,
+                                           int                 tcoNum,
+                                           AutomatedSourceMap& _map);
     static void automatedValuesFromTrack(const Track*       _track,
                                          MidiTime           timeStart,
                                          int                tcoNum,
@@ -115,6 +122,12 @@ class EXPORT TrackContainer : public Model, public JournallingObject
     mutable QReadWriteLock m_tracksMutex;
 
   private:
+    template <typename M>
+    static void automatedFromTracks(const Tracks& tracks,
+                                    MidiTime      timeStart,
+                                    int           tcoNum,
+                                    M&            _map);
+
     Tracks m_tracks;
 
     TrackContainerTypes m_TrackContainerType;
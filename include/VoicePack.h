@@ -0,0 +1,98 @@
+/*
+ * VoicePack.h - oscillator voices rendered together
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef VOICE_PACK_H
+#define VOICE_PACK_H
+
+#include "Oscillator.h"
+
+// Up to LANES voices of the same wave shape and modulation, rendered
+// together by blocks of BLOCK_FRAMES frames. The state is kept as structure
+// of arrays and the output is interleaved: out[frame * numVoices() + lane].
+// With two voices, that is a sampleFrame buffer (left and right).
+//
+// Packs are chained like the oscillators: the sub pack is the modulator
+// and must have the same number of voices. It is not owned.
+//
+// The packs have no heap data, so an instrument can keep all the packs of
+// a note in one MM_OPERATORS object.
+class EXPORT VoicePack final
+{
+    MM_OPERATORS
+
+  public:
+    static const int LANES        = 8;
+    static const int BLOCK_FRAMES = 64;
+
+    VoicePack();
+
+    void setModels(const IntModel* _waveShapeModel,
+                   const IntModel* _modAlgoModel,
+                   VoicePack*      _subPack = nullptr);
+
+    // the values are read at each update, like in Oscillator
+    // returns the lane or -1 when the pack is full
+    int addVoice(const frequency_t& _freq,
+                 const real_t&      _detuning,
+                 const real_t&      _phaseOffset,
+                 const volume_t&    _volume);
+
+    INLINE int numVoices() const
+    {
+        return m_size;
+    }
+
+    INLINE void setUserWave(SampleBufferPointer _wave)
+    {
+        m_userWave = _wave;
+    }
+
+    void update(real_t* _out, const fpp_t _frames);
+
+  private:
+    const IntModel*     m_waveShapeModel;
+    const IntModel*     m_modulationAlgoModel;
+    VoicePack*          m_subPack;
+    SampleBufferPointer m_userWave;
+
+    int                m_size;
+    const frequency_t* m_freq[LANES];
+    const real_t*      m_detuning[LANES];
+    const real_t*      m_ext_phaseOffset[LANES];
+    const volume_t*    m_volume[LANES];
+    real_t             m_phaseOffset[LANES];
+    real_t             m_phase[LANES];
+
+    void recalcPhases();
+    void syncInit(real_t* _out, const fpp_t _frames, real_t* _coeffs);
+
+    template <int A>
+    void updateAlgo(real_t* _out, const fpp_t _frames);
+    template <int A, Oscillator::WaveShapes W>
+    void updateLanes(real_t* _out, const fpp_t _frames);
+
+    // _x is modified
+    template <Oscillator::WaveShapes W>
+    INLINE void getSamples(real_t* _x, real_t* _r, const int _n) const;
+};
+
+#endif
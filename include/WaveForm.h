@@ -84,6 +84,8 @@ class WaveForm : public QObject  // public JournallingObject
     real_t f(const real_t          _x,
              const real_t          _antialias,
              const interpolation_t _m) const;
+    // same as f(_x[k]) for the _n values, in one loop
+    void f(const real_t* _x, real_t* _r, const int _n) const;
 
     INLINE const QString& name() const
     {
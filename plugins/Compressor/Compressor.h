@@ -42,6 +42,14 @@ class CompressorEffect : public Effect
     ~CompressorEffect() override;
     bool processAudioBuffer(sampleFrame* buf, const fpp_t frames) override;
 
+    // the lookahead delays the signal by 20 ms
+    f_cnt_t latency() const override
+    {
+        return m_compressorControls.m_lookaheadModel.value()
+                       ? m_lookaheadDelayLength
+                       : 0;
+    }
+
     EffectControls* controls() override
     {
         return &m_compressorControls;
@@ -65,7 +65,8 @@ LadspaEffect::LadspaEffect(Model*                                    _parent,
                            const Descriptor::SubPluginFeatures::Key* _key) :
       Effect(&ladspaeffect_plugin_descriptor, _parent, _key),
       m_controls(NULL), m_maxSampleRate(0),
-      m_key(LadspaSubPluginFeatures::subPluginKeyToLadspaKey(_key))
+      m_key(LadspaSubPluginFeatures::subPluginKeyToLadspaKey(_key)),
+      m_latencyPort(nullptr), m_latency(0)
 {
     setColor(QColor(59, 66, 128));
 
@@ -209,6 +210,7 @@ bool LadspaEffect::processAudioBuffer(sampleFrame* _buf, const fpp_t _frames)
     {
         (m_descriptor->run)(m_handles[proc], frames);
     }
+    updateLatency();
 
     // Copy the LADSPA output buffers to the LMMS buffer.
     channel = 0;
@@ -443,6 +445,14 @@ void LadspaEffect::pluginInstantiation()
 
             p->suggests_logscale = manager->isLogarithmic(m_key, port);
 
+            if(proc == 0 && p->rate == CONTROL_RATE_OUTPUT
+               && p->name.compare("latency", Qt::CaseInsensitive) == 0)
+            {
+                // written by the plugin when it runs
+                p->buffer[0]  = 0.f;
+                m_latencyPort = p;
+            }
+
             ports.append(p);
 
             // For convenience, keep a separate list of the ports that are
@@ -547,6 +557,31 @@ void LadspaEffect::pluginDestruction()
     m_ports.clear();
     m_handles.clear();
     m_portControls.clear();
+    m_latencyPort = nullptr;
+    m_latency     = 0;
+}
+
+void LadspaEffect::updateLatency()
+{
+    if(m_latencyPort == nullptr)
+    {
+        m_latency = 0;
+        return;
+    }
+
+    // in frames at the rate of the plugin
+    const sample_rate_t sr = Engine::mixer()->processingSampleRate();
+    const LADSPA_Data   v  = m_latencyPort->buffer[0];
+    if(!(v > 0.f && v < sr))
+    {
+        m_latency = 0;
+        return;
+    }
+
+    f_cnt_t r = f_cnt_t(v);
+    if(m_maxSampleRate < sr)
+        r = r * sr / m_maxSampleRate;
+    m_latency = r;
 }
 
 static QMap<QString, sample_rate_t> __buggy_plugins;
@@ -45,6 +45,12 @@ class LadspaEffect : public Effect
 
     virtual bool processAudioBuffer(sampleFrame* _buf, const fpp_t _frames);
 
+    // from the "latency" output port, by convention
+    virtual f_cnt_t latency() const
+    {
+        return m_latency;
+    }
+
     void setControl(int _control, LADSPA_Data _data);
 
     virtual EffectControls* controls()
@@ -68,6 +74,7 @@ class LadspaEffect : public Effect
   private:
     void pluginInstantiation();
     void pluginDestruction();
+    void updateLatency();
 
     static sample_rate_t maxSamplerate(const QString& _name);
 
@@ -84,6 +91,8 @@ class LadspaEffect : public Effect
 
     QVector<multi_proc_t> m_ports;
     multi_proc_t          m_portControls;
+    port_desc_t*          m_latencyPort;
+    f_cnt_t               m_latency;
 };
 
 #endif
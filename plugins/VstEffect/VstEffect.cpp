@@ -50,7 +50,8 @@ extern "C"
 VstEffect::VstEffect(Model*                                    _parent,
                      const Descriptor::SubPluginFeatures::Key* _key) :
       Effect(&vsteffect_plugin_descriptor, _parent, _key),
-      m_plugin(NULL), m_pluginMutex(), m_key(*_key), m_vstControls(this)
+      m_plugin(NULL), m_pluginMutex(), m_key(*_key), m_latency(0),
+      m_vstControls(this)
 {
     setColor(QColor(128, 96, 74));
 
@@ -101,6 +102,7 @@ bool VstEffect::processAudioBuffer(sampleFrame* _buf, const fpp_t _frames)
     if(m_pluginMutex.tryLock())
     {
         m_plugin->process(vstbuf, vstbuf);
+        m_latency = m_plugin->latency();
         m_pluginMutex.unlock();
     }
 
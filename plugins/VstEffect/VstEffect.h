@@ -44,6 +44,11 @@ class VstEffect : public Effect  // , public MidiEventProcessor
 
     virtual bool processAudioBuffer(sampleFrame* _buf, const fpp_t _frames);
 
+    virtual f_cnt_t latency() const
+    {
+        return m_latency;
+    }
+
     virtual EffectControls* controls()
     {
         return &m_vstControls;
@@ -87,6 +92,7 @@ class VstEffect : public Effect  // , public MidiEventProcessor
     VstPlugin* m_plugin;
     QMutex     m_pluginMutex;
     EffectKey  m_key;
+    f_cnt_t    m_latency;
 
     VstEffectControls m_vstControls;
 
@@ -321,6 +321,10 @@ lb302Synth::lb302Synth(InstrumentTrack* _instrumentTrack) :
 
     filterChanged();
 
+    // map the wavetables here rather than in the audio threads
+    for(int w = 0; w < BandLimitedWave::NumBLWaveforms; ++w)
+        BandLimitedWave::waveform(BandLimitedWave::Waveforms(w));
+
     InstrumentPlayHandle* iph
             = new InstrumentPlayHandle(this, _instrumentTrack);
     Engine::mixer()->emit playHandleToAdd(iph->pointer());
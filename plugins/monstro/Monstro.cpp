@@ -1143,6 +1143,10 @@ Monstro::Monstro(InstrumentTrack* _instrument_track) :
     updatePO3();
     updateSlope1();
     updateSlope2();
+
+    // map the wavetables here rather than in the audio threads
+    for(int w = 0; w < BandLimitedWave::NumBLWaveforms; ++w)
+        BandLimitedWave::waveform(BandLimitedWave::Waveforms(w));
 }
 
 Monstro::~Monstro()
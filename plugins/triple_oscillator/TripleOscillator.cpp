@@ -285,60 +285,37 @@ void TripleOscillator::playNote(NotePlayHandle* _n,
 
     if(_n->m_pluginData == nullptr)
     {
-        Oscillator* oscs_l[NUM_OF_OSCILLATORS];
-        Oscillator* oscs_r[NUM_OF_OSCILLATORS];
+        NoteVoices* voices = new NoteVoices;
 
         for(int i = NUM_OF_OSCILLATORS - 1; i >= 0; --i)
         {
+            VoicePack& pack = voices->packs[i];
 
             // the last oscs needs no sub-oscs...
-            if(i == NUM_OF_OSCILLATORS - 1)
-            {
-                oscs_l[i] = new Oscillator(
-                        &m_osc[i]->m_waveShapeModel,
-                        &m_osc[i]->m_modulationAlgoModel, _n->frequency(),
-                        m_osc[i]->m_detuningLeft, m_osc[i]->m_phaseOffsetLeft,
-                        m_osc[i]->m_volumeLeft);
-                oscs_r[i] = new Oscillator(&m_osc[i]->m_waveShapeModel,
-                                           &m_osc[i]->m_modulationAlgoModel,
-                                           _n->frequency(),
-                                           m_osc[i]->m_detuningRight,
-                                           m_osc[i]->m_phaseOffsetRight,
-                                           m_osc[i]->m_volumeRight);
-            }
-            else
-            {
-                oscs_l[i] = new Oscillator(
-                        &m_osc[i]->m_waveShapeModel,
-                        &m_osc[i]->m_modulationAlgoModel, _n->frequency(),
-                        m_osc[i]->m_detuningLeft, m_osc[i]->m_phaseOffsetLeft,
-                        m_osc[i]->m_volumeLeft, oscs_l[i + 1]);
-                oscs_r[i] = new Oscillator(
-                        &m_osc[i]->m_waveShapeModel,
-                        &m_osc[i]->m_modulationAlgoModel, _n->frequency(),
-                        m_osc[i]->m_detuningRight,
-                        m_osc[i]->m_phaseOffsetRight, m_osc[i]->m_volumeRight,
-                        oscs_r[i + 1]);
-            }
-
-            oscs_l[i]->setUserWave(m_osc[i]->m_sampleBuffer);
-            oscs_r[i]->setUserWave(m_osc[i]->m_sampleBuffer);
+            pack.setModels(&m_osc[i]->m_waveShapeModel,
+                           &m_osc[i]->m_modulationAlgoModel,
+                           i == NUM_OF_OSCILLATORS - 1
+                                   ? nullptr
+                                   : &voices->packs[i + 1]);
+            pack.addVoice(_n->frequency(), m_osc[i]->m_detuningLeft,
+                          m_osc[i]->m_phaseOffsetLeft,
+                          m_osc[i]->m_volumeLeft);
+            pack.addVoice(_n->frequency(), m_osc[i]->m_detuningRight,
+                          m_osc[i]->m_phaseOffsetRight,
+                          m_osc[i]->m_volumeRight);
+            pack.setUserWave(m_osc[i]->m_sampleBuffer);
         }
 
-        _n->m_pluginData = new oscPtr;
-
-        static_cast<oscPtr*>(_n->m_pluginData)->oscLeft  = oscs_l[0];
-        static_cast<oscPtr*>(_n->m_pluginData)->oscRight = oscs_r[0];
+        _n->m_pluginData = voices;
     }
 
-    Oscillator* osc_l = static_cast<oscPtr*>(_n->m_pluginData)->oscLeft;
-    Oscillator* osc_r = static_cast<oscPtr*>(_n->m_pluginData)->oscRight;
+    NoteVoices* voices = static_cast<NoteVoices*>(_n->m_pluginData);
 
     const fpp_t   frames = _n->framesLeftForCurrentPeriod();
     const f_cnt_t offset = _n->noteOffset();
 
-    osc_l->update(_working_buffer + offset, frames, 0);
-    osc_r->update(_working_buffer + offset, frames, 1);
+    // lanes 0 and 1 are the channels of the stereo frames
+    voices->packs[0].update(_working_buffer[offset], frames);
 
     applyRelease(_working_buffer, _n);
 
@@ -348,11 +325,7 @@ void TripleOscillator::playNote(NotePlayHandle* _n,
 
 void TripleOscillator::deleteNotePluginData(NotePlayHandle* _n)
 {
-    delete static_cast<Oscillator*>(
-            static_cast<oscPtr*>(_n->m_pluginData)->oscLeft);
-    delete static_cast<Oscillator*>(
-            static_cast<oscPtr*>(_n->m_pluginData)->oscRight);
-    delete static_cast<oscPtr*>(_n->m_pluginData);
+    delete static_cast<NoteVoices*>(_n->m_pluginData);
     _n->m_pluginData = nullptr;  // TMP ???
 }
 
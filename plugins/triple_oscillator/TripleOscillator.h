@@ -31,6 +31,7 @@
 #include "InstrumentView.h"
 #include "Oscillator.h"
 #include "SampleBuffer.h"
+#include "VoicePack.h"
 
 class AutomatableButtonGroup;
 class Knob;
@@ -111,11 +112,12 @@ class TripleOscillator : public Instrument
   private:
     OscillatorObject* m_osc[NUM_OF_OSCILLATORS];
 
-    struct oscPtr
+    // state of a note, one allocation: each pack renders the left and
+    // the right voices of an oscillator
+    struct NoteVoices
     {
         MM_OPERATORS
-        Oscillator* oscLeft;
-        Oscillator* oscRight;
+        VoicePack packs[NUM_OF_OSCILLATORS];
     };
 
     friend class TripleOscillatorView;
@@ -270,6 +270,12 @@ void vestigeInstrument::loadFile(const QString& _file)
     delete tf;
 }
 
+// called by processAudioBuffer() while playing, under the plugin mutex
+f_cnt_t vestigeInstrument::latency() const
+{
+    return m_plugin != nullptr ? m_plugin->latency() : 0;
+}
+
 void vestigeInstrument::play(sampleFrame* _buf)
 {
     // m_pluginMutex.lock();
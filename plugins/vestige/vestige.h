@@ -51,6 +51,8 @@ class vestigeInstrument : public Instrument
 
     virtual void play(sampleFrame* _working_buffer);
 
+    virtual f_cnt_t latency() const;
+
     virtual void saveSettings(QDomDocument& _doc, QDomElement& _parent);
     virtual void loadSettings(const QDomElement& _this);
 
@@ -89,6 +89,7 @@ ZynAddSubFxInstrument::ZynAddSubFxInstrument(
         InstrumentTrack* _instrumentTrack) :
       Instrument(_instrumentTrack, &zynaddsubfx_plugin_descriptor),
       m_hasGUI(false), m_plugin(nullptr), m_remotePlugin(nullptr),
+      m_latency(0),
       m_portamentoModel(0, 0, 127, 1, this, tr("Portamento")),
       m_filterFreqModel(64, 0, 127, 1, this, tr("Filter Frequency")),
       m_filterQModel(64, 0, 127, 1, this, tr("Filter Resonance")),
@@ -329,10 +330,12 @@ void ZynAddSubFxInstrument::play(sampleFrame* _buf)
     if(m_remotePlugin)
     {
         m_remotePlugin->process(nullptr, _buf);
+        m_latency = m_remotePlugin->latency();
     }
     else
     {
         m_plugin->processAudio(_buf);
+        m_latency = 0;
     }
 
     m_pluginMutex.unlock();
@@ -65,6 +65,11 @@ class ZynAddSubFxInstrument : public Instrument
 
     virtual void play(sampleFrame* _working_buffer);
 
+    virtual f_cnt_t latency() const
+    {
+        return m_latency;
+    }
+
     virtual bool handleMidiEvent(const MidiEvent& event,
                                  const MidiTime&  time   = MidiTime(),
                                  f_cnt_t          offset = 0);
@@ -102,6 +107,7 @@ class ZynAddSubFxInstrument : public Instrument
     QMutex                   m_pluginMutex;
     LocalZynAddSubFx*        m_plugin;
     ZynAddSubFxRemotePlugin* m_remotePlugin;
+    f_cnt_t                  m_latency;
 
     FloatModel m_portamentoModel;
     FloatModel m_filterFreqModel;
@@ -34,12 +34,17 @@
 #include "Song.h"
 #include "WaveFormStandard.h"
 #include "debug.h"
+#include "LocklessList.h"
 #include "lmms_math.h"  // REQUIRED
 
 #include <QTimer>
 
 long AutomatableModel::s_periodCounter = 0;
 
+// the ids of the models to notify, the views are not touched by the audio
+// threads and a model changed many times is notified once per display frame
+static LocklessList<jo_id_t> s_dirtyModels(4096);
+
 AutomatableModel::AutomatableModel(const real_t   val,
                                    const real_t   min,
                                    const real_t   max,
@@ -55,7 +60,7 @@ AutomatableModel::AutomatableModel(const real_t   val,
       m_setValueDepth(0), m_hasStrictStepSize(false),
       m_controllerConnection(nullptr),
       m_valueBuffer(static_cast<int>(Engine::mixer()->framesPerPeriod())),
-      m_lastUpdatedPeriod(-1), m_hasSampleExactData(false)
+      m_lastUpdatedPeriod(-1), m_hasSampleExactData(false), m_dirty(false)
 
 {
     m_value = fittedValue(val);
@@ -488,6 +493,8 @@ void AutomatableModel::setValue(const real_t value)
         m_oldValue     = m_value;
         m_value        = newval;
         m_valueChanged = true;
+        // a buffer from the last automated period would hide the new value
+        m_hasSampleExactData = false;
         emit dataChanged();
         propagateValue();
     }
@@ -536,7 +543,7 @@ void AutomatableModel::setAutomatedValue(const real_t value)
         m_value        = newval;
         m_valueChanged = true;
         propagateAutomatedValue();
-        emit dataChanged();
+        markDirty();
     }
     /*
     else
@@ -966,8 +973,8 @@ false ) ); else v=fittedValue( lm->m_value );
 
 ValueBuffer* AutomatableModel::valueBuffer()
 {
-    // QMutexLocker m(const_cast<QMutex*>(&m_valueBufferMutex));
-    QMutexLocker m(&m_valueBufferMutex);
+    // the buffer is written by the audio thread which reads it, the lock
+    // would not protect the returned pointer anyway
     return m_hasSampleExactData ? &m_valueBuffer : nullptr;
 }
 
@@ -1325,6 +1332,41 @@ void AutomatableModel::incrementPeriodCounter()
     // s_postponedUpdates.clear();
 }
 
+void AutomatableModel::markDirty()
+{
+    // already queued
+    if(m_dirty.exchange(true))
+        return;
+
+    // the queue is full: the next change will try again
+    if(!s_dirtyModels.tryPush(id()))
+        m_dirty = false;
+}
+
+void AutomatableModel::flushDirtyModels()
+{
+    LocklessList<jo_id_t>::Element* e = s_dirtyModels.popList();
+    while(e != nullptr)
+    {
+        // the model may have been deleted since, hence the id
+        ProjectJournal* journal = Engine::projectJournal();
+        AutomatableModel* m
+                = journal != nullptr
+                          ? dynamic_cast<AutomatableModel*>(
+                                  journal->journallingObject(e->value))
+                          : nullptr;
+        if(m != nullptr)
+        {
+            m->m_dirty = false;
+            emit m->dataChanged();
+        }
+
+        LocklessList<jo_id_t>::Element* next = e->next;
+        s_dirtyModels.free(e);
+        e = next;
+    }
+}
+
 void AutomatableModel::resetPeriodCounter()
 {
     s_periodCounter = 0;
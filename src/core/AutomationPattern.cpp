@@ -573,7 +573,16 @@ real_t AutomationPattern::valueAt(const MidiTime& _time) const
 }
 
 real_t AutomationPattern::valueAt(timeMap::const_iterator v,
-                                  tick_t                  offset,
+                                  int                     offset,
+                                  bool                    xruns) const
+{
+    return valueAt(m_timeMap, m_tangents, v, offset, xruns);
+}
+
+real_t AutomationPattern::valueAt(const timeMap&          _map,
+                                  const timeMap&          _tangents,
+                                  timeMap::const_iterator v,
+                                  real_t                  offset,
                                   bool                    xruns) const
 {
     real_t r = 0.;
@@ -582,7 +591,7 @@ real_t AutomationPattern::valueAt(timeMap::const_iterator v,
     if(xruns && pt != DiscreteProgression)
         pt = LinearProgression;
 
-    if(v == m_timeMap.end())  //|| offset == 0 )
+    if(v == _map.end())  //|| offset == 0 )
         r = v.value();
     else
         switch(m_progressionType)
@@ -610,8 +619,8 @@ real_t AutomationPattern::valueAt(timeMap::const_iterator v,
                     const int    numValues = ((v + 1).key() - v.key());
                     const real_t t = (real_t)offset / (real_t)numValues;
                     const real_t m1
-                            = (m_tangents[v.key()]) * numValues * m_tension;
-                    const real_t m2 = (m_tangents[(v + 1).key()]) * numValues
+                            = (_tangents[v.key()]) * numValues * m_tension;
+                    const real_t m2 = (_tangents[(v + 1).key()]) * numValues
                                       * m_tension;
 
                     const real_t t3 = pow(t, 3);
@@ -632,7 +641,7 @@ real_t AutomationPattern::valueAt(timeMap::const_iterator v,
                 x2 = v2.key();
                 y1 = v.value();
                 y2 = v2.value();
-                if(v == m_timeMap.begin())
+                if(v == _map.begin())
                 {
                     x0 = 2 * x1 - x2;
                     y0 = 2 * y1 - y2;
@@ -643,7 +652,7 @@ real_t AutomationPattern::valueAt(timeMap::const_iterator v,
                     x0                         = v0.key();
                     y0                         = v0.value();
                 }
-                if(v2 == m_timeMap.end())
+                if(v2 == _map.end())
                 {
                     x3 = 2 * x2 - x1;
                     y3 = 2 * y2 - y1;
@@ -691,7 +700,7 @@ real_t AutomationPattern::valueAt(timeMap::const_iterator v,
             r += abs((1. - m_waveRatio) * dy + m_waveRatio * my) * m_waveSkew
                  * w0 * m_waveAmplitude;
         }
-        else if(v != m_timeMap.end())
+        else if(v != _map.end())
         {
             real_t rx = (v + 1).key() - v.key();
             if(rx > 0.)
@@ -1455,6 +1464,90 @@ void AutomationPattern::automatedValuesAt(const MidiTime&    _time,
     });
 }
 
+void AutomationPattern::automatedSourcesAt(const MidiTime&     _time,
+                                           AutomatedSourceMap& _map)
+{
+    const AutomatedSource source = {this, _time.ticks()};
+    m_objects.map([&_map, &source](AutomatableModel* model) {
+        _map.insert(model, source);
+    });
+}
+
+void AutomationPattern::renderValues(real_t  _time,
+                                     real_t  _step,
+                                     real_t* _values,
+                                     fpp_t   _frames) const
+{
+    if(!m_cursorMap.isSharedWith(m_timeMap)
+       || !m_cursorTangents.isSharedWith(m_tangents))
+    {
+        // edited since the last call
+        m_cursorMap      = m_timeMap;
+        m_cursorTangents = m_tangents;
+        m_cursor         = m_cursorMap.constEnd();
+    }
+
+    if(m_cursorMap.isEmpty())
+    {
+        memset(_values, 0, sizeof(real_t) * _frames);
+        return;
+    }
+
+    const bool   xruns = Engine::mixer()->criticalXRuns();
+    const real_t ul    = autoRepeat() ? real_t(unitLength()) : 0.;
+
+    for(fpp_t f = 0; f < _frames; ++f)
+    {
+        real_t time = _time + f * _step;
+        if(ul > 0.)
+            time = fmod(time, ul);
+        _values[f] = cursorValueAt(time, xruns);
+    }
+}
+
+real_t AutomationPattern::cursorValueAt(real_t _time, bool _xruns) const
+{
+    const timeMap::const_iterator end = m_cursorMap.constEnd();
+
+    timeMap::const_iterator v = m_cursor;
+    if(v != end && _time >= v.key())
+    {
+        // still in the segment or in one of the next two
+        for(int i = 0; i < 2; ++i)
+        {
+            timeMap::const_iterator next = v + 1;
+            if(next == end || _time < next.key())
+                break;
+            v = next;
+        }
+        if(v + 1 != end && _time >= (v + 1).key())
+            v = end;
+    }
+    else
+    {
+        v = end;
+    }
+
+    if(v == end)
+    {
+        // keys are integers, first key > floor(t) is first key > t
+        v = m_cursorMap.upperBound(tick_t(floor(_time)));
+        if(v == m_cursorMap.constBegin())
+        {
+            m_cursor = end;
+            return 0.;
+        }
+        --v;
+    }
+
+    m_cursor = v;
+    if(v + 1 == end)
+        return v.value();
+
+    return valueAt(m_cursorMap, m_cursorTangents, v, _time - v.key(),
+                   _xruns);
+}
+
 void AutomationPattern::cleanObjects()
 {
     /*
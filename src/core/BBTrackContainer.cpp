@@ -437,6 +437,14 @@ void BBTrackContainer::automatedValuesAt(MidiTime           _start,
             _start + (MidiTime::ticksPerTact() * _tcoNum), _tcoNum, _map);
 }
 
+void BBTrackContainer::automatedSourcesAt(MidiTime            _start,
+                                          int                 _tcoNum,
+                                          AutomatedSourceMap& _map) const
+{
+    TrackContainer::automatedSourcesAt(
+            _start + (MidiTime::ticksPerTact() * _tcoNum), _tcoNum, _map);
+}
+
 BBTracks BBTrackContainer::bbTracks() const
 {
     BBTracks r;
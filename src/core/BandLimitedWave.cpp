@@ -25,12 +25,29 @@
 
 #include "BandLimitedWave.h"
 
+#include <QCoreApplication>
 #include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStandardPaths>
 
-WaveMipMap BandLimitedWave::s_waveforms[4] = {  };
+std::atomic<WaveMipMap*> BandLimitedWave::s_waveforms[4] = { { nullptr }, { nullptr }, { nullptr }, { nullptr } };
 bool BandLimitedWave::s_wavesGenerated = false;
 QString BandLimitedWave::s_wavetableDir = "";
 
+static const char* WAVE_NAMES[BandLimitedWave::NumBLWaveforms] = { "saw", "sqr", "tri", "moog" };
+// part of the name of the cache files, to be increased when their layout
+// or the generated tables change
+static const int CACHE_VERSION = 1;
+
+// recursive, the moog wave is made of the saw and triangle ones
+static QMutex s_mutex( QMutex::Recursive );
+// kept open, closing the file would unmap the tables
+static QFile* s_mappedFiles[BandLimitedWave::NumBLWaveforms] = { nullptr, nullptr, nullptr, nullptr };
+
 
 QDataStream& operator<< ( QDataStream &out, WaveMipMap &waveMipMap )
 {
@@ -59,33 +76,84 @@ QDataStream& operator>> ( QDataStream &in, WaveMipMap &waveMipMap )
 }
 
 
-void BandLimitedWave::generateWaves()
+// the tables do not depend on the sample rate but on the type of the
+// samples and on the version of the format
+static QString cacheFile( BandLimitedWave::Waveforms _wave )
 {
-// don't generate if they already exist
-	if( s_wavesGenerated ) return;
+	return QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) +
+		QString( "/wavetables/%1.v%2.f%3" ).arg( WAVE_NAMES[_wave] ).arg( CACHE_VERSION ).arg( 8 * sizeof( sample_t ) );
+}
 
-	int i;
 
-// set wavetable directory
-	s_wavetableDir = "data:wavetables/";
+// read only and shared by all the processes, the pages are only read when
+// a table is played
+static WaveMipMap* mapCacheFile( BandLimitedWave::Waveforms _wave )
+{
+	QFile* f = new QFile( cacheFile( _wave ) );
+	if( f->size() != qint64( sizeof( WaveMipMap ) ) || !f->open( QIODevice::ReadOnly ) )
+	{
+		delete f;
+		return nullptr;
+	}
 
-// set wavetable files
-	QFile saw_file( s_wavetableDir + "saw.bin" );
-	QFile sqr_file( s_wavetableDir + "sqr.bin" );
-	QFile tri_file( s_wavetableDir + "tri.bin" );
-	QFile moog_file( s_wavetableDir + "moog.bin" );
+	uchar* p = f->map( 0, sizeof( WaveMipMap ) );
+	if( p == nullptr )
+	{
+		delete f;
+		return nullptr;
+	}
 
-// saw wave - BLSaw
-// check for file and use it if exists
-	if( saw_file.exists() )
+	s_mappedFiles[_wave] = f;
+	return reinterpret_cast<WaveMipMap*>( p );
+}
+
+
+static bool storeCacheFile( BandLimitedWave::Waveforms _wave, const WaveMipMap& _table )
+{
+	const QString path = cacheFile( _wave );
+	if( !QDir().mkpath( QFileInfo( path ).absolutePath() ) )
 	{
-		saw_file.open( QIODevice::ReadOnly );
-		QDataStream in( &saw_file );
-		in >> s_waveforms[ BandLimitedWave::BLSaw ];
-		saw_file.close();
+		return false;
 	}
-	else
+
+	// several processes may store the same table
+	QFile out( QString( "%1.%2.part" ).arg( path ).arg( QCoreApplication::applicationPid() ) );
+	if( !out.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+	{
+		return false;
+	}
+
+	const qint64 n = sizeof( WaveMipMap );
+	const bool ok = ( out.write( reinterpret_cast<const char*>( &_table ), n ) == n );
+	out.close();
+
+	if( !ok || QFileInfo( path ).exists() || !out.rename( path ) )
 	{
+		out.remove();
+		return QFileInfo( path ).exists();
+	}
+	return true;
+}
+
+
+static void generate( BandLimitedWave::Waveforms _wave, WaveMipMap& _table )
+{
+	int i;
+
+// check for the file provided with LMMS and use it if exists
+	QFile file( BandLimitedWave::s_wavetableDir + WAVE_NAMES[_wave] + ".bin" );
+	if( file.exists() && file.open( QIODevice::ReadOnly ) )
+	{
+		QDataStream in( &file );
+		in >> _table;
+		file.close();
+		return;
+	}
+
+	switch( _wave )
+	{
+// saw wave - BLSaw
+	case BandLimitedWave::BLSaw:
 		for( i = 0; i <= MAXTBL; i++ )
 		{
 			const int len = TLENS[i];
@@ -105,29 +173,20 @@ void BandLimitedWave::generateWaves()
 					s += amp * /*a2 **/sin( static_cast<double>( ph * harm ) / static_cast<double>( len ) * D_2PI );
 					harm++;
 				} while( hlen > 2. );
-				s_waveforms[ BandLimitedWave::BLSaw ].setSampleAt( i, ph, s );
+				_table.setSampleAt( i, ph, s );
 				max = qMax( max, qAbs( s ) );
 			}
 			// normalize
 			for( int ph = 0; ph < len; ph++ )
 			{
-				sample_t s = s_waveforms[ BandLimitedWave::BLSaw ].sampleAt( i, ph ) / max;
-				s_waveforms[ BandLimitedWave::BLSaw ].setSampleAt( i, ph, s );
+				sample_t s = _table.sampleAt( i, ph ) / max;
+				_table.setSampleAt( i, ph, s );
 			}
 		}
-	}
+		break;
 
 // square wave - BLSquare
-// check for file and use it if exists
-	if( sqr_file.exists() )
-	{
-		sqr_file.open( QIODevice::ReadOnly );
-		QDataStream in( &sqr_file );
-		in >> s_waveforms[ BandLimitedWave::BLSquare ];
-		sqr_file.close();
-	}
-	else
-	{
+	case BandLimitedWave::BLSquare:
 		for( i = 0; i <= MAXTBL; i++ )
 		{
 			const int len = TLENS[i];
@@ -147,28 +206,20 @@ void BandLimitedWave::generateWaves()
 					s += amp * /*a2 **/ sin( static_cast<double>( ph * harm ) / static_cast<double>( len ) * D_2PI );
 					harm += 2;
 				} while( hlen > 2. );
-				s_waveforms[ BandLimitedWave::BLSquare ].setSampleAt( i, ph, s );
+				_table.setSampleAt( i, ph, s );
 				max = qMax( max, qAbs( s ) );
 			}
 			// normalize
 			for( int ph = 0; ph < len; ph++ )
 			{
-				sample_t s = s_waveforms[ BandLimitedWave::BLSquare ].sampleAt( i, ph ) / max;
-				s_waveforms[ BandLimitedWave::BLSquare ].setSampleAt( i, ph, s );
+				sample_t s = _table.sampleAt( i, ph ) / max;
+				_table.setSampleAt( i, ph, s );
 			}
 		}
-	}
+		break;
 
 // triangle wave - BLTriangle
-	if( tri_file.exists() )
-	{
-		tri_file.open( QIODevice::ReadOnly );
-		QDataStream in( &tri_file );
-		in >> s_waveforms[ BandLimitedWave::BLTriangle ];
-		tri_file.close();
-	}
-	else
-	{
+	case BandLimitedWave::BLTriangle:
 		for( i = 0; i <= MAXTBL; i++ )
 		{
 			const int len = TLENS[i];
@@ -189,29 +240,24 @@ void BandLimitedWave::generateWaves()
 							( ( harm + 1 ) % 4 == 0 ? 0.5 : 0. ) ) * D_2PI );
 					harm += 2;
 				} while( hlen > 2.0 );
-				s_waveforms[ BandLimitedWave::BLTriangle ].setSampleAt( i, ph, s );
+				_table.setSampleAt( i, ph, s );
 				max = qMax( max, qAbs( s ) );
 			}
 			// normalize
 			for( int ph = 0; ph < len; ph++ )
 			{
-				sample_t s = s_waveforms[ BandLimitedWave::BLTriangle ].sampleAt( i, ph ) / max;
-				s_waveforms[ BandLimitedWave::BLTriangle ].setSampleAt( i, ph, s );
+				sample_t s = _table.sampleAt( i, ph ) / max;
+				_table.setSampleAt( i, ph, s );
 			}
 		}
-	}
+		break;
 
 // moog saw wave - BLMoog
 // basically, just add in triangle + 270-phase saw
-	if( moog_file.exists() )
-	{
-		moog_file.open( QIODevice::ReadOnly );
-		QDataStream in( &moog_file );
-		in >> s_waveforms[ BandLimitedWave::BLMoog ];
-		moog_file.close();
-	}
-	else
+	case BandLimitedWave::BLMoog:
 	{
+		WaveMipMap* sawTable = BandLimitedWave::waveform( BandLimitedWave::BLSaw );
+		WaveMipMap* triTable = BandLimitedWave::waveform( BandLimitedWave::BLTriangle );
 		for( i = 0; i <= MAXTBL; i++ )
 		{
 			const int len = TLENS[i];
@@ -219,54 +265,63 @@ void BandLimitedWave::generateWaves()
 			for( int ph = 0; ph < len; ph++ )
 			{
 				const int sawph = ( ph + static_cast<int>( len * 0.75 ) ) % len;
-				const sample_t saw = s_waveforms[ BandLimitedWave::BLSaw ].sampleAt( i, sawph );
-				const sample_t tri = s_waveforms[ BandLimitedWave::BLTriangle ].sampleAt( i, ph );
-				s_waveforms[ BandLimitedWave::BLMoog ].setSampleAt( i, ph, ( saw + tri ) * 0.5 );
+				const sample_t saw = sawTable->sampleAt( i, sawph );
+				const sample_t tri = triTable->sampleAt( i, ph );
+				_table.setSampleAt( i, ph, ( saw + tri ) * 0.5 );
 			}
 		}
+		break;
 	}
 
-// set the generated flag so we don't load/generate them again needlessly
-	s_wavesGenerated = true;
-
-
-// generate files, serialize mipmaps as QDataStreams and save them on disk
-//
-// normally these are now provided with LMMS as pre-generated so we don't have to do this,
-// but I'm leaving the code here in case it's needed in the future
-// (maybe we add more waveforms or change the generation code or mipmap format, etc.)
+	default:
+		break;
+	}
+}
 
-/*
 
-// if you want to generate the files, you need to set the filenames and paths here -
-// can't use the usual wavetable directory here as it can require permissions on
-// some systems...
+WaveMipMap* BandLimitedWave::loadWaveform( Waveforms _wave )
+{
+	QMutexLocker locker( &s_mutex );
+	WaveMipMap* current = s_waveforms[_wave].load( std::memory_order_acquire );
+	if( current != nullptr )
+	{
+		return current;
+	}
 
-QFile sawfile( "path-to-wavetables/saw.bin" );
-QFile sqrfile( "path-to-wavetables/sqr.bin" );
-QFile trifile( "path-to-wavetables/tri.bin" );
-QFile moogfile( "path-to-wavetables/moog.bin" );
+	WaveMipMap* table = mapCacheFile( _wave );
+	if( table == nullptr )
+	{
+		// 160 KB, only kept if the cache can not be written
+		WaveMipMap* generated = new WaveMipMap;
+		generate( _wave, *generated );
 
-sawfile.open( QIODevice::WriteOnly );
-QDataStream sawout( &sawfile );
-sawout << s_waveforms[ BandLimitedWave::BLSaw ];
-sawfile.close();
+		if( storeCacheFile( _wave, *generated ) )
+		{
+			table = mapCacheFile( _wave );
+		}
+		if( table == nullptr )
+		{
+			qWarning( "BandLimitedWave: %s not cached", WAVE_NAMES[_wave] );
+			table = generated;
+		}
+		else
+		{
+			delete generated;
+		}
+	}
 
-sqrfile.open( QIODevice::WriteOnly );
-QDataStream sqrout( &sqrfile );
-sqrout << s_waveforms[ BandLimitedWave::BLSquare ];
-sqrfile.close();
+	s_waveforms[_wave].store( table, std::memory_order_release );
+	return table;
+}
 
-trifile.open( QIODevice::WriteOnly );
-QDataStream triout( &trifile );
-triout << s_waveforms[ BandLimitedWave::BLTriangle ];
-trifile.close();
 
-moogfile.open( QIODevice::WriteOnly );
-QDataStream moogout( &moogfile );
-moogout << s_waveforms[ BandLimitedWave::BLMoog ];
-moogfile.close();
+void BandLimitedWave::generateWaves()
+{
+// the tables are mapped or generated when first used
+	if( s_wavesGenerated ) return;
 
-*/
+// set wavetable directory
+	s_wavetableDir = "data:wavetables/";
 
+	s_wavesGenerated = true;
 }
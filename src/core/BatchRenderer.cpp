@@ -0,0 +1,344 @@
+/*
+ * BatchRenderer.cpp - renders the jobs of a manifest in parallel
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "BatchRenderer.h"
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegExp>
+#include <QThread>
+
+#include <cstdio>
+
+BatchRenderer::BatchRenderer(const QString& _manifest,
+                             int            _jobs,
+                             const QString& _report,
+                             QObject*       _parent) :
+      QObject(_parent),
+      m_manifest(_manifest), m_maxRunning(_jobs), m_reportFile(_report),
+      m_next(0), m_running(0), m_failed(0)
+{
+    if(m_maxRunning <= 0)
+        m_maxRunning = qMax(1, QThread::idealThreadCount() / 2);
+}
+
+BatchRenderer::~BatchRenderer()
+{
+    for(Job* job: m_jobs)
+    {
+        if(job->process != nullptr)
+        {
+            job->process->kill();
+            job->process->waitForFinished();
+        }
+        delete job;
+    }
+}
+
+bool BatchRenderer::load()
+{
+    QFile f(m_manifest);
+    if(!f.open(QIODevice::ReadOnly))
+    {
+        qCritical("Error: can not read the manifest %s",
+                  qPrintable(m_manifest));
+        return false;
+    }
+
+    const QByteArray data = f.readAll();
+    const bool       ok   = data.trimmed().startsWith('[')
+                              ? loadJson(data)
+                              : loadCsv(data);
+    if(ok)
+        qInfo("BatchRenderer: %d jobs, %d at once", m_jobs.size(),
+              m_maxRunning);
+    return ok;
+}
+
+bool BatchRenderer::loadJson(const QByteArray& _data)
+{
+    QJsonParseError     error;
+    const QJsonDocument doc = QJsonDocument::fromJson(_data, &error);
+    if(!doc.isArray())
+    {
+        qCritical("Error: manifest %s: %s", qPrintable(m_manifest),
+                  qPrintable(error.errorString()));
+        return false;
+    }
+
+    for(const QJsonValue& v: doc.array())
+    {
+        const QJsonObject o = v.toObject();
+
+        // numbers are accepted as well as strings
+        auto field = [&o](const char* _name) {
+            const QJsonValue f = o.value(_name);
+            return f.isDouble() ? QString::number(f.toInt()) : f.toString();
+        };
+
+        Job job;
+        job.project       = field("project");
+        job.output        = field("output");
+        job.format        = field("format");
+        job.samplerate    = field("samplerate");
+        job.interpolation = field("interpolation");
+        job.oversampling  = field("oversampling");
+        job.bitrate       = field("bitrate");
+        job.mode          = field("mode");
+        job.range         = field("range");
+        if(!addJob(job))
+            return false;
+    }
+    return true;
+}
+
+bool BatchRenderer::loadCsv(const QByteArray& _data)
+{
+    QStringList lines = QString::fromUtf8(_data).split(
+            QRegExp("[\r\n]+"), QString::SkipEmptyParts);
+    if(lines.isEmpty())
+        return true;
+
+    const QStringList header = lines.takeFirst().split(',');
+    for(const QString& line: lines)
+    {
+        if(line.startsWith('#'))
+            continue;
+
+        const QStringList cells = line.split(',');
+
+        Job job;
+        for(int i = 0; i < header.size() && i < cells.size(); ++i)
+        {
+            const QString name  = header.at(i).trimmed().toLower();
+            const QString value = cells.at(i).trimmed();
+            if(name == "project")
+                job.project = value;
+            else if(name == "output")
+                job.output = value;
+            else if(name == "format")
+                job.format = value;
+            else if(name == "samplerate")
+                job.samplerate = value;
+            else if(name == "interpolation")
+                job.interpolation = value;
+            else if(name == "oversampling")
+                job.oversampling = value;
+            else if(name == "bitrate")
+                job.bitrate = value;
+            else if(name == "mode")
+                job.mode = value;
+            else if(name == "range")
+                job.range = value;
+            else
+                qWarning("BatchRenderer: unknown column %s",
+                         qPrintable(name));
+        }
+        if(!addJob(job))
+            return false;
+    }
+    return true;
+}
+
+bool BatchRenderer::addJob(const Job& _job)
+{
+    if(_job.project.isEmpty() || _job.output.isEmpty())
+    {
+        qCritical("Error: manifest %s: job #%d needs a project and an "
+                  "output",
+                  qPrintable(m_manifest), m_jobs.size() + 1);
+        return false;
+    }
+
+    // checked here, the child would take an unknown flag for a file
+    static const QStringList MODES  = {"song", "tracks", "channels", "stems"};
+    static const QStringList RANGES = {"song", "loop"};
+    if(!_job.mode.isEmpty() && !MODES.contains(_job.mode))
+    {
+        qCritical("Error: manifest %s: job #%d has an unknown mode %s "
+                  "(%s)",
+                  qPrintable(m_manifest), m_jobs.size() + 1,
+                  qPrintable(_job.mode), qPrintable(MODES.join(", ")));
+        return false;
+    }
+    if(!_job.range.isEmpty() && !RANGES.contains(_job.range))
+    {
+        qCritical("Error: manifest %s: job #%d has an unknown range %s "
+                  "(%s)",
+                  qPrintable(m_manifest), m_jobs.size() + 1,
+                  qPrintable(_job.range), qPrintable(RANGES.join(", ")));
+        return false;
+    }
+
+    Job* job     = new Job(_job);
+    job->process = nullptr;
+    m_jobs.append(job);
+    return true;
+}
+
+QStringList BatchRenderer::arguments(const Job& _job) const
+{
+    QStringList r;
+    r << "--render" << _job.project << "--output" << _job.output;
+    if(!_job.format.isEmpty())
+        r << "--format" << _job.format;
+    if(!_job.samplerate.isEmpty())
+        r << "--samplerate" << _job.samplerate;
+    if(!_job.interpolation.isEmpty())
+        r << "--interpolation" << _job.interpolation;
+    if(!_job.oversampling.isEmpty())
+        r << "--oversampling" << _job.oversampling;
+    if(!_job.bitrate.isEmpty())
+        r << "--bitrate" << _job.bitrate;
+    if(!_job.mode.isEmpty() && _job.mode != "song")
+        r << "--" + _job.mode;
+    if(_job.range == "loop")
+        r << "--loop";
+    return r;
+}
+
+void BatchRenderer::start()
+{
+    if(!m_reportFile.isEmpty())
+    {
+        m_report.setFileName(m_reportFile);
+        if(!m_report.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            qWarning("BatchRenderer: can not write the report %s",
+                     qPrintable(m_reportFile));
+    }
+    if(!m_report.isOpen())
+        m_report.open(stdout, QIODevice::WriteOnly);
+
+    m_timer.start();
+    startNextJobs();
+}
+
+void BatchRenderer::startNextJobs()
+{
+    while(m_running < m_maxRunning && m_next < m_jobs.size())
+    {
+        Job* job = m_jobs.at(m_next);
+
+        job->process = new QProcess(this);
+        job->process->setProperty("job", m_next);
+        // several progress bars on the same terminal are useless
+        job->process->setStandardErrorFile(job->output + ".log");
+        connect(job->process,
+                SIGNAL(finished(int, QProcess::ExitStatus)), this,
+                SLOT(onJobFinished(int, QProcess::ExitStatus)));
+        // a job which can not start never finishes
+        connect(job->process, SIGNAL(errorOccurred(QProcess::ProcessError)),
+                this, SLOT(onJobError(QProcess::ProcessError)));
+
+        qInfo("BatchRenderer: start #%d %s", m_next + 1,
+              qPrintable(job->project));
+        ++m_next;
+        ++m_running;
+        job->timer.start();
+        job->process->start(QCoreApplication::applicationFilePath(),
+                            arguments(*job));
+    }
+
+    if(m_running == 0)
+    {
+        qInfo("BatchRenderer: %d jobs done in %.1fs, %d failed",
+              m_jobs.size(), m_timer.elapsed() / 1000., m_failed);
+        m_report.flush();
+        emit finished();
+    }
+}
+
+void BatchRenderer::onJobFinished(int _exitCode, QProcess::ExitStatus _status)
+{
+    QProcess* p = qobject_cast<QProcess*>(sender());
+    if(p == nullptr)
+        return;
+
+    Job* job = m_jobs.at(p->property("job").toInt());
+    if(_status != QProcess::NormalExit && _exitCode == 0)
+        _exitCode = -1;
+
+    report(*job, _exitCode);
+    if(_exitCode != 0)
+        ++m_failed;
+
+    job->process = nullptr;
+    p->deleteLater();
+
+    --m_running;
+    startNextJobs();
+}
+
+void BatchRenderer::onJobError(QProcess::ProcessError _error)
+{
+    // the other errors end with finished()
+    if(_error != QProcess::FailedToStart)
+        return;
+
+    QProcess* p = qobject_cast<QProcess*>(sender());
+    if(p == nullptr)
+        return;
+
+    const int n   = p->property("job").toInt();
+    Job*      job = m_jobs.at(n);
+    qCritical("BatchRenderer: #%d can not start: %s", n + 1,
+              qPrintable(p->errorString()));
+
+    report(*job, -1);
+    ++m_failed;
+
+    job->process = nullptr;
+    p->deleteLater();
+
+    --m_running;
+    // may be emitted by start(), inside startNextJobs()
+    QMetaObject::invokeMethod(this, "startNextJobs", Qt::QueuedConnection);
+}
+
+void BatchRenderer::report(const Job& _job, int _exitCode)
+{
+    const qint64 wallMs  = _job.timer.elapsed();
+    double       audioMs = 0.;
+
+    // the child prints "render-stats audio_ms=<ms>" on stdout
+    const QString out = QString::fromUtf8(_job.process->readAllStandardOutput());
+    QRegExp       rx("render-stats audio_ms=([0-9.]+)");
+    if(rx.indexIn(out) >= 0)
+        audioMs = rx.cap(1).toDouble();
+
+    QJsonObject o;
+    o.insert("project", _job.project);
+    o.insert("output", _job.output);
+    o.insert("exit", _exitCode);
+    o.insert("wall_ms", double(wallMs));
+    o.insert("audio_ms", audioMs);
+    o.insert("realtime_factor", wallMs > 0 ? audioMs / wallMs : 0.);
+    if(QFileInfo(_job.output).isFile())
+        o.insert("bytes", double(QFileInfo(_job.output).size()));
+
+    m_report.write(QJsonDocument(o).toJson(QJsonDocument::Compact));
+    m_report.write("\n");
+    m_report.flush();
+}
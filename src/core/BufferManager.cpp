@@ -28,15 +28,216 @@
 
 //#include "Engine.h"
 //#include "Mixer.h"
+#include "Backtrace.h"
+#include "Configuration.h"
 #include "MemoryManager.h"
 
+#include <QThread>
+
+#include <atomic>
+
 fpp_t BufferManager::s_framesPerPeriod = 0;
 
-static int buffer_cnt=0;
+// The period buffers come from a pool:
+// - each thread keeps a few free buffers for itself (no atomic operation)
+// - the threads share a lock-free stack of free buffers, the head holds
+//   the index of the top buffer and an ABA tag in a single 64 bits word
+// - when the stack runs low, a background thread adds a chunk of buffers
+//   so the audio threads never call the allocator once the pool is warm
+// Every buffer is preceded by one cache line holding its index, so the
+// buffers are aligned on cache lines and on any SIMD width.
+
+static const int     LINE_SIZE   = 64;
+static const int     CHUNK_SIZE  = 64;  // buffers per chunk
+static const int     MAX_CHUNKS  = 256;
+static const int     MAX_BUFFERS = CHUNK_SIZE * MAX_CHUNKS;
+static const int     CACHE_SIZE  = 16;  // per thread
+static const quint32 MAGIC       = 0x4c534d4d;
+
+struct BufferHeader
+{
+    quint32 magic;
+    qint32  index;  // -1 when allocated outside of the pool
+    char*   raw;
+};
+
+static size_t s_stride = 0;  // header + buffer, in bytes
+
+static char*             s_chunks[MAX_CHUNKS];
+static std::atomic<int>  s_numChunks(0);
+static std::atomic<int>  s_next[MAX_BUFFERS];
+static std::atomic<quint64> s_head(0);  // tag << 32 | (index + 1)
+
+static std::atomic<int>  s_free(0);
+static std::atomic<int>  s_hits(0);
+static std::atomic<int>  s_misses(0);
+static std::atomic<int>  s_inUse(0);
+static std::atomic<int>  s_highWater(0);
+static std::atomic<bool> s_growRequested(false);
+
+static INLINE char* alignLine(char* _p)
+{
+    return _p + (LINE_SIZE - ((size_t)_p & (LINE_SIZE - 1))) % LINE_SIZE;
+}
+
+static INLINE sampleFrame* bufferAt(int _index)
+{
+    char* h = s_chunks[_index / CHUNK_SIZE] + (_index % CHUNK_SIZE) * s_stride;
+    return (sampleFrame*)(h + LINE_SIZE);
+}
+
+static INLINE BufferHeader* headerOf(sampleFrame* _buf)
+{
+    return (BufferHeader*)((char*)_buf - LINE_SIZE);
+}
+
+static void push(int _index)
+{
+    quint64 head = s_head.load(std::memory_order_acquire);
+    for(;;)
+    {
+        s_next[_index].store(int(head & 0xFFFFFFFFU) - 1,
+                             std::memory_order_relaxed);
+        const quint64 top = (((head >> 32) + 1) << 32) | quint64(_index + 1);
+        if(s_head.compare_exchange_weak(head, top, std::memory_order_release,
+                                        std::memory_order_acquire))
+            break;
+    }
+    s_free.fetch_add(1, std::memory_order_relaxed);
+}
+
+static int pop()
+{
+    quint64 head = s_head.load(std::memory_order_acquire);
+    for(;;)
+    {
+        const int index = int(head & 0xFFFFFFFFU) - 1;
+        if(index < 0)
+            return -1;
+
+        const int     next = s_next[index].load(std::memory_order_relaxed);
+        const quint64 top  = (((head >> 32) + 1) << 32) | quint64(next + 1);
+        if(s_head.compare_exchange_weak(head, top, std::memory_order_acquire,
+                                        std::memory_order_acquire))
+        {
+            s_free.fetch_sub(1, std::memory_order_relaxed);
+            return index;
+        }
+    }
+}
+
+// not real-time safe, called by init() and by the grower thread
+static bool grow()
+{
+    const int c = s_numChunks.load(std::memory_order_acquire);
+    if(c >= MAX_CHUNKS)
+    {
+        qWarning("BufferManager: pool is full (%d buffers)", MAX_BUFFERS);
+        return false;
+    }
+
+    // never released, buffers may live until the very end
+    s_chunks[c] = alignLine(new char[s_stride * CHUNK_SIZE + LINE_SIZE]);
+    s_numChunks.store(c + 1, std::memory_order_release);
+
+    for(int i = 0; i < CHUNK_SIZE; ++i)
+    {
+        const int     index = c * CHUNK_SIZE + i;
+        BufferHeader* h     = headerOf(bufferAt(index));
+        h->magic            = MAGIC;
+        h->index            = index;
+        h->raw              = nullptr;
+        push(index);
+    }
+    return true;
+}
+
+// buffer given when the pool is empty, released to the allocator
+static sampleFrame* allocateSpare()
+{
+    char*         raw = new char[s_stride + LINE_SIZE];
+    BufferHeader* h   = (BufferHeader*)alignLine(raw);
+    h->magic          = MAGIC;
+    h->index          = -1;
+    h->raw            = raw;
+    return (sampleFrame*)((char*)h + LINE_SIZE);
+}
+
+struct ThreadCache
+{
+    int count;
+    int items[CACHE_SIZE];
+
+    ThreadCache() : count(0)
+    {
+    }
+
+    ~ThreadCache()
+    {
+        // give the buffers back when the thread exits
+        while(count > 0)
+            push(items[--count]);
+    }
+};
+
+static thread_local ThreadCache s_cache;
+
+class BufferGrower : public QThread
+{
+  public:
+    BufferGrower()
+    {
+        setObjectName("BufferManager grower");
+    }
+
+  protected:
+    virtual void run()
+    {
+        while(!isInterruptionRequested())
+        {
+            if(s_growRequested.exchange(false))
+                while(s_free.load() < CHUNK_SIZE && grow())
+                    ;
+            msleep(10);
+        }
+    }
+};
+
+static BufferGrower* s_grower = nullptr;
 
 void BufferManager::init(fpp_t framesPerPeriod)
 {
+    if(s_framesPerPeriod > 0)
+    {
+        if(framesPerPeriod != s_framesPerPeriod)
+            qFatal("BufferManager::init period size can not change");
+        return;
+    }
+
     s_framesPerPeriod = framesPerPeriod;
+    s_stride          = LINE_SIZE
+               + ((sizeof(sampleFrame) * framesPerPeriod + LINE_SIZE - 1)
+                  / LINE_SIZE * LINE_SIZE);
+
+    // enough buffers for the expected number of voices
+    const int n = qMax(CONFIG_GET_INT("mixer.prewarmbuffers"), CHUNK_SIZE);
+    while(s_numChunks.load() * CHUNK_SIZE < n && grow())
+        ;
+
+    s_grower = new BufferGrower();
+    s_grower->start(QThread::LowPriority);
+}
+
+void BufferManager::cleanup()
+{
+    if(s_grower != nullptr)
+    {
+        s_grower->requestInterruption();
+        s_grower->wait();
+        delete s_grower;
+        s_grower = nullptr;
+    }
+    printStats();
 }
 
 sampleFrame* BufferManager::acquire()
@@ -44,9 +245,31 @@ sampleFrame* BufferManager::acquire()
     if(s_framesPerPeriod <= 0)
         qFatal("invalid framesPerPeriod %s:%d", __FILE__, __LINE__);
 
-    sampleFrame* r = MM_ALLOC(sampleFrame, s_framesPerPeriod);
+    ThreadCache& cache = s_cache;
+    const int    index = cache.count > 0 ? cache.items[--cache.count] : pop();
+
+    sampleFrame* r;
+    if(index >= 0)
+    {
+        r = bufferAt(index);
+        s_hits.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        r = allocateSpare();
+        s_misses.fetch_add(1, std::memory_order_relaxed);
+        s_growRequested.store(true);
+    }
+
+    if(s_free.load(std::memory_order_relaxed) < CHUNK_SIZE / 2)
+        s_growRequested.store(true);
+
+    const int n  = s_inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+    int       hw = s_highWater.load(std::memory_order_relaxed);
+    while(n > hw && !s_highWater.compare_exchange_weak(hw, n))
+        ;
+
     clear(r);
-    buffer_cnt++;
     return r;
 }
 
@@ -84,10 +307,30 @@ void BufferManager::clear(surroundSampleFrame* ab,
 
 void BufferManager::release(sampleFrame* buf)
 {
-    MM_FREE(buf);
-    buffer_cnt--;
-    if(buffer_cnt%100==0)
-        qInfo("BufferManager: %d",buffer_cnt);
+    if(buf == nullptr)
+        return;
+
+    BufferHeader* h = headerOf(buf);
+    if(h->magic != MAGIC)
+    {
+        BACKTRACE
+        qCritical("BufferManager::release %p was not acquired", buf);
+        return;
+    }
+
+    s_inUse.fetch_sub(1, std::memory_order_relaxed);
+
+    if(h->index < 0)
+    {
+        delete[] h->raw;
+        return;
+    }
+
+    ThreadCache& cache = s_cache;
+    if(cache.count < CACHE_SIZE)
+        cache.items[cache.count++] = h->index;
+    else
+        push(h->index);
 }
 
 void BufferManager::refresh()  // non-threadsafe, hence it's called
@@ -95,3 +338,22 @@ void BufferManager::refresh()  // non-threadsafe, hence it's called
                                // other threads can interfere
 {
 }
+
+BufferManager::Stats BufferManager::stats()
+{
+    Stats r;
+    r.hits      = s_hits.load();
+    r.misses    = s_misses.load();
+    r.inUse     = s_inUse.load();
+    r.highWater = s_highWater.load();
+    r.capacity  = s_numChunks.load() * CHUNK_SIZE;
+    return r;
+}
+
+void BufferManager::printStats()
+{
+    const Stats r = stats();
+    qInfo("BufferManager: hits=%d misses=%d in use=%d high water=%d "
+          "capacity=%d",
+          r.hits, r.misses, r.inUse, r.highWater, r.capacity);
+}
@@ -0,0 +1,145 @@
+/*
+ * CompensationDelay.cpp - delay line aligning the paths of the mixer
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "CompensationDelay.h"
+
+#include "BufferManager.h"
+
+#include <cstring>
+
+const f_cnt_t CompensationDelay::SIZE;
+const f_cnt_t CompensationDelay::MAX_DELAY;
+const f_cnt_t CompensationDelay::FADE_FRAMES;
+
+CompensationDelay::CompensationDelay() :
+      m_delay(0), m_fadeDelay(0), m_fade(0), m_valid(SIZE), m_pos(0),
+      m_tail(0), m_ring(MM_ALLOC(sampleFrame, SIZE)), m_out(nullptr)
+{
+    memset(m_ring, 0, SIZE * sizeof(sampleFrame));
+}
+
+CompensationDelay::~CompensationDelay()
+{
+    MM_FREE(m_ring);
+    if(m_out != nullptr)
+        BufferManager::release(m_out);
+}
+
+void CompensationDelay::setDelay(f_cnt_t _delay)
+{
+    _delay = qBound(f_cnt_t(0), _delay, MAX_DELAY);
+    if(_delay == m_delay)
+        return;
+
+    // the frames older than the history are what was left by a previous
+    // run: silence them, the new delay reads them first
+    const f_cnt_t mask = SIZE - 1;
+    for(f_cnt_t k = m_valid + 1; k <= _delay; ++k)
+        memset(m_ring[(m_pos - k) & mask], 0, sizeof(sampleFrame));
+    m_valid = qMax(m_valid, _delay);
+
+    m_fadeDelay = m_delay;
+    m_fade      = FADE_FRAMES;
+    m_delay     = _delay;
+}
+
+void CompensationDelay::clear()
+{
+    memset(m_ring, 0, SIZE * sizeof(sampleFrame));
+    m_fade  = 0;
+    m_valid = SIZE;
+    m_pos   = 0;
+    m_tail  = 0;
+}
+
+void CompensationDelay::process(sampleFrame* _buf,
+                                fpp_t        _frames,
+                                bool         _hasInput)
+{
+    if(m_delay == 0 && m_fade == 0)
+    {
+        // the line is not written
+        m_valid = 0;
+        m_tail  = 0;
+        return;
+    }
+
+    const f_cnt_t span = qMax(m_delay, m_fade > 0 ? m_fadeDelay : f_cnt_t(0));
+
+    // nothing was written while the line was silent, only the frames
+    // drained since the last input are left
+    if(m_tail == 0)
+        m_valid = qMin(m_valid, span);
+
+    const f_cnt_t mask = SIZE - 1;
+    f_cnt_t       pos  = m_pos;
+    for(fpp_t f = 0; f < _frames; ++f)
+    {
+        // written first, so a delay of 0 reads the input back
+        sampleFrame& w = m_ring[pos];
+        for(ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+            w[ch] = _buf[f][ch];
+
+        const sampleFrame& r = m_ring[(pos - m_delay) & mask];
+        if(m_fade > 0)
+        {
+            const sampleFrame& o = m_ring[(pos - m_fadeDelay) & mask];
+            const real_t       g = real_t(m_fade) / FADE_FRAMES;
+            for(ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+                _buf[f][ch] = r[ch] + (o[ch] - r[ch]) * g;
+            --m_fade;
+        }
+        else
+        {
+            for(ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+                _buf[f][ch] = r[ch];
+        }
+        pos = (pos + 1) & mask;
+    }
+    m_pos   = pos;
+    m_valid = qMin(m_valid + _frames, SIZE);
+
+    if(_hasInput)
+        m_tail = span;
+    else
+        m_tail = qMax(m_tail - _frames, f_cnt_t(0));
+}
+
+const sampleFrame* CompensationDelay::process(const sampleFrame* _src,
+                                              fpp_t              _frames,
+                                              bool               _hasInput)
+{
+    if(m_delay == 0 && m_fade == 0)
+    {
+        m_valid = 0;
+        m_tail  = 0;
+        return _src;
+    }
+
+    // from the pool, nothing is allocated here
+    if(m_out == nullptr)
+        m_out = BufferManager::acquire();
+
+    memcpy(m_out, _src, _frames * sizeof(sampleFrame));
+    process(m_out, _frames, _hasInput);
+    return m_out;
+}
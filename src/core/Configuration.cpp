@@ -58,6 +58,11 @@ void lmms_default_configuration()
     DEFAULT_BOOL("mixer.hqaudio", false);
     DEFAULT_STRING("mixer.audiodev", "");
     DEFAULT_STRING("mixer.mididev", "");
+    DEFAULT_BOOL("mixer.workeraffinity", false);
+    DEFAULT_INT("mixer.prewarmbuffers", 256);
+    // capacity of the play handle registries, allocated at startup
+    DEFAULT_INT("mixer.maxplayhandles", 4096);
+    DEFAULT_INT("mixer.maxplayhandlesperport", 1024);
 
     DEFAULT_BOOL("midi.mtc_enabled", false);
     DEFAULT_BOOL("midi.mtc_extra_port", true);
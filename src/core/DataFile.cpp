@@ -40,14 +40,191 @@
 #include "embed.h"
 #include "lmmsversion.h"
 
+#include <QDataStream>
 #include <QFile>
 #include <QFileInfo>
 #include <QLocale>
 #include <QMessageBox>
 #include <QTextStream>
+#include <QtConcurrent>
 
 static void findIds(const QDomElement& elem, QList<jo_id_t>& idList);
 
+// magic, number of chunks, (offset, packed size, size) per chunk, chunks
+static const char BINARY_MAGIC[]    = "LSMMB01\n";
+static const int  BINARY_MAGIC_SIZE = 8;
+static const int  BINARY_ENTRY_SIZE = 16;
+// where a chunk is cut from the skeleton
+static const char BINARY_CHUNK_TAG[] = "lsmmb-chunk";
+
+// the tracks, and the other sections of the content
+static void binaryChunks(const QDomElement& _content, QList<QDomElement>& _r)
+{
+    for(QDomElement e = _content.firstChildElement(); !e.isNull();
+        e             = e.nextSiblingElement())
+    {
+        if(e.tagName() == "trackcontainer")
+        {
+            for(QDomElement t = e.firstChildElement("track"); !t.isNull();
+                t             = t.nextSiblingElement("track"))
+                _r.append(t);
+        }
+        else
+        {
+            _r.append(e);
+        }
+    }
+}
+
+static QByteArray packChunk(const QByteArray& _xml)
+{
+    return qCompress(_xml);
+}
+
+static QDomDocument parseChunk(const QByteArray& _packed)
+{
+    QDomDocument doc;
+    doc.setContent(qUncompress(_packed));
+    return doc;
+}
+
+bool DataFile::isBinary(const QByteArray& _data)
+{
+    return _data.startsWith(QByteArray(BINARY_MAGIC, BINARY_MAGIC_SIZE));
+}
+
+QByteArray DataFile::toBinary()
+{
+    if(type() == SongProject || type() == SongProjectTemplate
+       || type() == InstrumentTrackSettings)
+        cleanMetaNodes(documentElement());
+
+    QList<QDomElement> elements;
+    binaryChunks(m_content, elements);
+
+    // the sections are cut from the document while the skeleton is saved
+    QList<QByteArray>  chunks;
+    QList<QDomElement> placeholders;
+    chunks.append(QByteArray());
+    for(int i = 0; i < elements.size(); ++i)
+    {
+        QString     xml;
+        QTextStream ts(&xml);
+        elements.at(i).save(ts, -1);
+        ts.flush();
+        chunks.append(xml.toUtf8());
+
+        QDomElement p = createElement(BINARY_CHUNK_TAG);
+        p.setAttribute("index", i + 1);
+        elements.at(i).parentNode().replaceChild(p, elements.at(i));
+        placeholders.append(p);
+    }
+
+    {
+        QString     xml;
+        QTextStream ts(&xml);
+        save(ts, -1);
+        ts.flush();
+        chunks[0] = xml.toUtf8();
+    }
+
+    for(int i = 0; i < elements.size(); ++i)
+        placeholders.at(i).parentNode().replaceChild(elements.at(i),
+                                                     placeholders.at(i));
+
+    const QList<QByteArray> packed
+            = QtConcurrent::blockingMapped(chunks, packChunk);
+
+    QByteArray  r;
+    QDataStream out(&r, QIODevice::WriteOnly);
+    out.writeRawData(BINARY_MAGIC, BINARY_MAGIC_SIZE);
+    out << quint32(packed.size());
+    quint64 offset = 0;
+    for(int i = 0; i < packed.size(); ++i)
+    {
+        out << offset << quint32(packed.at(i).size())
+            << quint32(chunks.at(i).size());
+        offset += packed.at(i).size();
+    }
+    for(const QByteArray& p: packed)
+        out.writeRawData(p.constData(), p.size());
+
+    return r;
+}
+
+bool DataFile::loadBinary(const QByteArray& _data, const QString& _sourceFile)
+{
+    QDataStream in(_data);
+    in.skipRawData(BINARY_MAGIC_SIZE);
+
+    quint32 n = 0;
+    in >> n;
+    const qint64 base
+            = BINARY_MAGIC_SIZE + 4 + qint64(n) * BINARY_ENTRY_SIZE;
+    if(n == 0 || base > _data.size())
+    {
+        qWarning("Warning: %s: bad chunk index", qPrintable(_sourceFile));
+        return false;
+    }
+
+    QList<QByteArray> packed;
+    for(quint32 i = 0; i < n; ++i)
+    {
+        quint64 offset;
+        quint32 packedSize, size;
+        in >> offset >> packedSize >> size;
+        if(in.status() != QDataStream::Ok
+           || base + qint64(offset) + packedSize > _data.size())
+        {
+            qWarning("Warning: %s: bad chunk %d", qPrintable(_sourceFile),
+                     int(i));
+            return false;
+        }
+        // no copy, the data may be a mapping
+        packed.append(QByteArray::fromRawData(
+                _data.constData() + base + offset, int(packedSize)));
+    }
+
+    // the sections are parsed by the pool while the skeleton is parsed here
+    const QList<QByteArray> sections = packed.mid(1);
+    QFuture<QDomDocument>   parsed
+            = QtConcurrent::mapped(sections, parseChunk);
+
+    QString errorMsg;
+    int     line = -1, col = -1;
+    if(!setContent(qUncompress(packed.at(0)), &errorMsg, &line, &col))
+    {
+        parsed.waitForFinished();
+        qWarning("Warning: %s: skeleton#%d:%d: %s", qPrintable(_sourceFile),
+                 line, col, qPrintable(errorMsg));
+        return false;
+    }
+
+    parsed.waitForFinished();
+    const QDomNodeList nodes = elementsByTagName(BINARY_CHUNK_TAG);
+    QList<QDomElement> placeholders;
+    for(int i = 0; i < nodes.count(); ++i)
+        placeholders.append(nodes.at(i).toElement());
+
+    for(const QDomElement& p: placeholders)
+    {
+        const int index = p.attribute("index").toInt();
+        const QDomElement section
+                = (index >= 1 && index <= sections.size())
+                          ? parsed.resultAt(index - 1).documentElement()
+                          : QDomElement();
+        if(section.isNull())
+        {
+            qWarning("Warning: %s: bad chunk %d", qPrintable(_sourceFile),
+                     index);
+            return false;
+        }
+        p.parentNode().replaceChild(importNode(section, true), p);
+    }
+
+    return true;
+}
+
 DataFile::typeDescStruct DataFile::s_types[DataFile::TypeCount]
         = {{DataFile::UnknownType, "unknown"},
            {DataFile::SongProject, "song"},
@@ -130,6 +307,8 @@ DataFile::DataFile(const QString& _fileName) :
             inFile.setFileName(_fileName + ".mmpz");
         if(!inFile.exists())
             inFile.setFileName(_fileName + ".mpt");
+        if(!inFile.exists())
+            inFile.setFileName(_fileName + ".lsmmb");
     }
 
     if(!inFile.open(QIODevice::ReadOnly))
@@ -149,7 +328,17 @@ DataFile::DataFile(const QString& _fileName) :
         return;
     }
 
-    loadData(inFile.readAll(), _fileName);
+    // the chunks of the binary projects are unpacked from the mapping
+    const qint64 size   = inFile.size();
+    uchar*       mapped = (inFile.fileName().endsWith(".lsmmb") && size > 0)
+                            ? inFile.map(0, size)
+                            : nullptr;
+    if(mapped != nullptr)
+        loadData(QByteArray::fromRawData(
+                         reinterpret_cast<const char*>(mapped), int(size)),
+                 _fileName);
+    else
+        loadData(inFile.readAll(), _fileName);
 }
 
 DataFile::DataFile(const QByteArray& _data) :
@@ -176,7 +365,8 @@ bool DataFile::validate(QString extension)
     switch(m_type)
     {
         case Type::SongProject:
-            if(extension == "mmp" || extension == "mmpz")
+            if(extension == "mmp" || extension == "mmpz"
+               || extension == "lsmmb")
             {
                 return true;
             }
@@ -195,7 +385,8 @@ bool DataFile::validate(QString extension)
             break;
         case Type::UnknownType:
             if(!(extension == "mmp" || extension == "mpt"
-                 || extension == "mmpz" || extension == "xpf"
+                 || extension == "mmpz" || extension == "lsmmb"
+                 || extension == "xpf"
                  || extension == "xml"
                  || (extension == "xiz"
                      && !pluginFactory->pluginSupportingExtension(extension)
@@ -222,7 +413,8 @@ QString DataFile::nameWithExtension(const QString& _fn) const
     {
         case SongProject:
             if(_fn.section('.', -1) != "mmp" && _fn.section('.', -1) != "mpt"
-               && _fn.section('.', -1) != "mmpz")
+               && _fn.section('.', -1) != "mmpz"
+               && _fn.section('.', -1) != "lsmmb")
             {
                 if(ConfigManager::inst()->value("app", "nommpz").toInt() == 0)
                 {
@@ -285,7 +477,11 @@ bool DataFile::writeFile(const QString& filename)
         return false;
     }
 
-    if(fullName.section('.', -1) == "mmpz")
+    if(fullName.section('.', -1) == "lsmmb")
+    {
+        outfile.write(toBinary());
+    }
+    else if(fullName.section('.', -1) == "mmpz")
     {
         QString     xml;
         QTextStream ts(&xml);
@@ -1034,7 +1230,23 @@ void DataFile::loadData(const QByteArray& _data, const QString& _sourceFile)
 {
     QString errorMsg;
     int     line = -1, col = -1;
-    if(!setContent(_data, &errorMsg, &line, &col))
+    if(isBinary(_data))
+    {
+        if(!loadBinary(_data, _sourceFile))
+        {
+            if(gui)
+            {
+                QMessageBox::critical(
+                        nullptr, SongEditor::tr("Error in file"),
+                        SongEditor::tr("The file %1 seems to contain "
+                                       "errors and therefore can't be "
+                                       "loaded.")
+                                .arg(_sourceFile));
+            }
+            return;
+        }
+    }
+    else if(!setContent(_data, &errorMsg, &line, &col))
     {
         /*
         // parsing failed? then try to uncompress data
@@ -251,6 +251,19 @@ bool EffectChain::processAudioBuffer(sampleFrame* _buf,
     return moreEffects;
 }
 
+f_cnt_t EffectChain::latency() const
+{
+    if(m_enabledModel.value() == false)
+        return 0;
+
+    f_cnt_t r = 0;
+    m_effects.map([&r](Effect* const& e) {
+        if(e->isOkay() && !e->dontRun() && e->isEnabled())
+            r += e->latency();
+    });
+    return r;
+}
+
 void EffectChain::startRunning()
 {
     if(m_enabledModel.value() == false)
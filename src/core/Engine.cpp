@@ -24,9 +24,11 @@
 
 #include "Engine.h"
 
+#include "AutomatableModel.h"
 #include "BBTrackContainer.h"
 #include "BandLimitedWave.h"
 #include "ConfigManager.h"
+#include "Configuration.h"
 #include "Controller.h"
 #include "FxMixer.h"
 #include "Ladspa2LMMS.h"
@@ -35,12 +37,15 @@
 #include "PluginFactory.h"
 #include "PresetPreviewPlayHandle.h"
 #include "ProjectJournal.h"
+#include "SampleStreamer.h"
 #include "Song.h"
 #include "lmmsconfig.h"
 //#include "Backtrace.h"
 
+#include <QElapsedTimer>
 #include <QFuture>
 #include <QPointer>
+#include <QTimer>
 #include <QtConcurrent>
 
 real_t         LmmsCore::s_framesPerTick;
@@ -54,6 +59,7 @@ static QPointer<BBTrackContainer>    s_bbTrackContainer = nullptr;
 static QPointer<ProjectJournal>      s_projectJournal   = nullptr;
 static QPointer<Ladspa2LMMS>         s_ladspaManager    = nullptr;
 static QPointer<DummyTrackContainer> s_dummyTC          = nullptr;
+static QPointer<QTimer>              s_modelTimer       = nullptr;
 
 #ifdef LMMS_HAVE_LILV
 #include "LV22LMMS.h"
@@ -121,8 +127,18 @@ LmmsCore* LmmsCore::singleton()
     return s_singleton;
 }
 
+// the startup time, stage by stage
+static void initDone(QElapsedTimer& _timer, const char* _stage)
+{
+    qInfo("Engine: %-24s %6lld ms", _stage, _timer.restart());
+}
+
 void LmmsCore::init(bool renderOnly)
 {
+    QElapsedTimer total, timer;
+    total.start();
+    timer.start();
+
     qRegisterMetaType<tact_t>("tact_t");
     qRegisterMetaType<tick_t>("tick_t");
     qRegisterMetaType<real_t>("real_t");
@@ -165,6 +181,7 @@ void LmmsCore::init(bool renderOnly)
     t1b.waitForFinished();
     emit engine->initProgress(tr("Initializing data structures"));
     t2.waitForFinished();
+    initDone(timer, "wavetables");
 
     QFuture<void> t3a = QtConcurrent::run(init3a);
     QFuture<void> t3b = QtConcurrent::run(init3b);
@@ -174,18 +191,22 @@ void LmmsCore::init(bool renderOnly)
     emit engine->initProgress(tr("Initializing Ladspa effects"));
     t3a.waitForFinished();
     t3b.waitForFinished();
+    initDone(timer, "ladspa and lv2 plugins");
 
     QFuture<void> t3c = QtConcurrent::run(init3c);
     emit          engine->initProgress(tr("Initializing Lmms effects"));
     t3c.waitForFinished();
+    initDone(timer, "lmms plugins");
 
     emit          engine->initProgress(tr("Adding effects"));
     QFuture<void> t3d = QtConcurrent::run(init3d);
     t3d.waitForFinished();
+    initDone(timer, "effects");
 
     QFuture<void> t4 = QtConcurrent::run(init4, renderOnly);
     emit          engine->initProgress(tr("Initializing Mixer"));
     t4.waitForFinished();
+    initDone(timer, "mixer");
 
     emit engine->initProgress(tr("Initializing Song"));
     init5();
@@ -199,22 +220,33 @@ void LmmsCore::init(bool renderOnly)
     QFuture<void> t7 = QtConcurrent::run(init7);
 
     t7.waitForFinished();
+    initDone(timer, "song, fx mixer and bb");
 
     s_projectJournal->setJournalling(true);
 
     emit engine->initProgress(tr("Opening audio and midi devices"));
     s_mixer->initDevices();
+    initDone(timer, "audio and midi devices");
 
     PresetPreviewPlayHandle::init();
     s_dummyTC = new DummyTrackContainer();
 
+    // the models changed by the audio threads notify their views at the
+    // display rate, from here
+    s_modelTimer = new QTimer(engine);
+    connect(s_modelTimer, &QTimer::timeout,
+            &AutomatableModel::flushDirtyModels);
+    s_modelTimer->start(1000 / qMax(1, CONFIG_GET_INT("ui.framespersecond")));
+
     emit engine->initProgress(tr("Launching mixer threads"));
     s_mixer->startProcessing();
+    initDone(timer, "mixer threads");
+    initDone(total, "total");
 }
 
 void LmmsCore::init1()
 {
-    // generate (load from file) bandlimited wavetables
+    // the bandlimited wavetables are mapped when first used
     BandLimitedWave::generateWaves();
 }
 
@@ -289,9 +321,13 @@ void LmmsCore::destroy()
     s_mixer->stopProcessing();
     qWarning("Engine::destroy processing stopped");
 
+    if(s_modelTimer != nullptr)
+        s_modelTimer->stop();
+
     PresetPreviewPlayHandle::cleanup();
 
     s_song->clearProject();
+    SampleStreamer::cleanup();
 
     DELETE_HELPER(s_bbTrackContainer);
     DELETE_HELPER(s_dummyTC);
@@ -0,0 +1,159 @@
+/*
+ * FilterCoeffsTable.cpp - precomputed coefficients of the basic filters
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FilterCoeffsTable.h"
+
+#include <QMutex>
+#include <QVector>
+
+#include <atomic>
+#include <cstring>
+
+typedef BasicFilters<1> TableFilter;
+
+// the last table used for each type, checked without locking
+static std::atomic<const FilterCoeffsTable*> s_current[TableFilter::NumFilters];
+
+static QMutex                            s_mutex;
+static QVector<const FilterCoeffsTable*> s_tables;
+
+// -1 when the type can not be tabulated
+int FilterCoeffsTable::tableType(int _type)
+{
+    if(_type == TableFilter::DoubleLowPass)
+        return TableFilter::LowPass;
+    if(_type == TableFilter::DoubleMoog)
+        return TableFilter::Moog;
+    if(_type < 0 || _type >= TableFilter::NumFilters
+       || _type == TableFilter::Peak)
+        return -1;
+    return _type;
+}
+
+const FilterCoeffsTable* FilterCoeffsTable::find(int           _type,
+                                                 sample_rate_t _sampleRate)
+{
+    _type = tableType(_type);
+    if(_type < 0)
+        return nullptr;
+
+    const FilterCoeffsTable* r
+            = s_current[_type].load(std::memory_order_acquire);
+    return (r != nullptr && r->m_sampleRate == _sampleRate) ? r : nullptr;
+}
+
+const FilterCoeffsTable* FilterCoeffsTable::get(int           _type,
+                                                sample_rate_t _sampleRate)
+{
+    const FilterCoeffsTable* r = find(_type, _sampleRate);
+    if(r != nullptr)
+        return r;
+
+    _type = tableType(_type);
+    if(_type < 0)
+        return nullptr;
+
+    QMutexLocker locker(&s_mutex);
+    r = nullptr;
+    for(const FilterCoeffsTable* t: s_tables)
+        if(t->m_type == _type && t->m_sampleRate == _sampleRate)
+        {
+            r = t;
+            break;
+        }
+
+    if(r == nullptr)
+    {
+        r = new FilterCoeffsTable(_type, _sampleRate);
+        s_tables.append(r);
+    }
+
+    s_current[_type].store(r, std::memory_order_release);
+    return r;
+}
+
+FilterCoeffsTable::FilterCoeffsTable(int _type, sample_rate_t _sampleRate) :
+      m_type(_type), m_sampleRate(_sampleRate)
+{
+    const real_t freqOctaves
+            = log2(TableFilter::maxFreq() / TableFilter::minFreq());
+    const real_t qOctaves = log2(TableFilter::maxQ() / TableFilter::minQ());
+
+    m_freqSize = int(ceil(freqOctaves * FREQ_STEPS)) + 1;
+    m_qSize    = int(ceil(qOctaves * Q_STEPS)) + 1;
+    m_freqs    = new frequency_t[m_freqSize];
+    m_qs       = new real_t[m_qSize];
+    m_cells    = new FilterCoeffs[m_freqSize * m_qSize];
+    memset(m_cells, 0, sizeof(FilterCoeffs) * m_freqSize * m_qSize);
+
+    // the last points are clamped to the maximum
+    for(int i = 0; i < m_freqSize; ++i)
+        m_freqs[i] = qMin(TableFilter::minFreq() * exp2(real_t(i) / FREQ_STEPS),
+                          TableFilter::maxFreq());
+    for(int j = 0; j < m_qSize; ++j)
+        m_qs[j] = qMin(TableFilter::minQ() * exp2(real_t(j) / Q_STEPS),
+                       TableFilter::maxQ());
+
+    TableFilter filter(_sampleRate);
+    filter.setFilterType(_type);
+    for(int i = 0; i < m_freqSize; ++i)
+    {
+        for(int j = 0; j < m_qSize; ++j)
+        {
+            filter.calcFilterCoeffs(m_freqs[i], m_qs[j], 0.);
+            filter.getCoeffs(m_cells[i * m_qSize + j]);
+        }
+    }
+
+    qInfo("FilterCoeffsTable: type %d at %d Hz, %dx%d cells", _type,
+          _sampleRate, m_freqSize, m_qSize);
+}
+
+void FilterCoeffsTable::lookup(frequency_t   _freq,
+                               real_t        _q,
+                               FilterCoeffs& _c) const
+{
+    _freq = bound(TableFilter::minFreq(), _freq, TableFilter::maxFreq());
+    _q    = bound(TableFilter::minQ(), _q, TableFilter::maxQ());
+
+    // the cells are found on a logarithmic scale but the weights are
+    // linear, exact for the coefficients proportional to q
+    const int i = qMin(
+            int(log2(_freq / TableFilter::minFreq()) * FREQ_STEPS),
+            m_freqSize - 2);
+    const int j
+            = qMin(int(log2(_q / TableFilter::minQ()) * Q_STEPS), m_qSize - 2);
+
+    const real_t x = (_freq - m_freqs[i]) / (m_freqs[i + 1] - m_freqs[i]);
+    const real_t y = (_q - m_qs[j]) / (m_qs[j + 1] - m_qs[j]);
+
+    const real_t* c00 = m_cells[i * m_qSize + j].c;
+    const real_t* c01 = m_cells[i * m_qSize + j + 1].c;
+    const real_t* c10 = m_cells[(i + 1) * m_qSize + j].c;
+    const real_t* c11 = m_cells[(i + 1) * m_qSize + j + 1].c;
+    for(int k = 0; k < 8; ++k)
+    {
+        const real_t c0 = c00[k] + (c01[k] - c00[k]) * y;
+        const real_t c1 = c10[k] + (c11[k] - c10[k]) * y;
+        _c.c[k]         = c0 + (c1 - c0) * x;
+    }
+}
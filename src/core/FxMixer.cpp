@@ -24,6 +24,7 @@
 
 #include "FxMixer.h"
 
+#include "AudioFileDevice.h"
 #include "BufferManager.h"
 #include "MixHelpers.h"
 #include "Mixer.h"
@@ -45,6 +46,8 @@
 #include <QDomElement>
 #include <QFileInfo>
 //#include <QLayout>
+
+#include <algorithm>
 //#include <QUuid>
 
 FxRoute::FxRoute(FxChannel* from, FxChannel* to, real_t amount) :
@@ -92,6 +95,7 @@ void FxRoute::updateName()
 FxChannel::FxChannel(int idx, Model* _parent) :
       Model(_parent, QString("FxChannel #%1").arg(idx)), m_fxChain(this),
       m_hasInput(false), m_stillRunning(false), m_frozenBuf(nullptr),
+      m_stemDevice(nullptr),
       m_frozenModel(false, this, tr("Frozen"), "frozen"),
       m_clippingModel(false, this, tr("Clipping"), "clipping"),
       m_eqDJ(nullptr),
@@ -99,13 +103,13 @@ FxChannel::FxChannel(int idx, Model* _parent) :
       // m_eqDJHighModel  ( 0., -70., 0., 1., _parent ),
       // m_eqDJMediumModel( 0., -70., 0., 1., _parent ),
       // m_eqDJLowModel   ( 0., -70., 0., 1., _parent ),
-      m_peakLeft(0.), m_peakRight(0.), m_buffer(BufferManager::acquire()),
+      m_peakLeft(0.), m_peakRight(0.), m_inputLatency(0),
+      m_outputLatency(0), m_buffer(BufferManager::acquire()),
       m_mutedModel(false, this, tr("Mute"), "mute"),
       m_soloModel(false, this, tr("Solo"), "solo"),
       m_volumeModel(
               1.0, 0.0, 1.0, 0.001, this, tr("Volume"), "volume"),  // max=2.
-      m_name(), m_channelIndex(idx), m_lock(), m_queued(false),
-      m_dependenciesMet(0)
+      m_name(), m_channelIndex(idx), m_lock(), m_queued(false)
 {
     if(idx > 0)
     {
@@ -310,13 +314,14 @@ void FxChannel::processed()
 
 void FxChannel::resetDeps()
 {
-    m_dependenciesMet = 0;
+    // one extra dependency, released by FxMixer::releaseGraph() once all
+    // the inputs of the period are known
+    setDependencies(m_receives.size() + 1);
 }
 
 void FxChannel::incrementDeps()
 {
-    int i = m_dependenciesMet.fetchAndAddOrdered(1) + 1;
-    if(i >= m_receives.size() && !m_queued)
+    if(dependencyDone())
     {
         m_queued = true;
         MixerWorkerThread::addJob(this);
@@ -403,6 +408,7 @@ void FxChannel::doProcessing()
             }
         }
 
+        writeStem();
         processed();
         return;
     }
@@ -417,7 +423,10 @@ void FxChannel::doProcessing()
                 qFatal("Error: no send model found from %d to %d",
                        senderRoute->senderIndex(), m_channelIndex);
 
-            if(sender->m_hasInput || sender->m_stillRunning)
+            // the delay keeps running until its content is out
+            CompensationDelay& delay = senderRoute->compensation();
+            const bool active = sender->m_hasInput || sender->m_stillRunning;
+            if(active || delay.isPending())
             {
                 m_hasInput = true;
 
@@ -426,8 +435,10 @@ void FxChannel::doProcessing()
                 const ValueBuffer* volBuf
                         = sender->m_volumeModel.valueBuffer();
 
-                // mix it's output with this one's output
-                sampleFrame* ch_buf = sender->m_buffer;
+                // mix it's output with this one's output, aligned with
+                // the other inputs
+                const sampleFrame* ch_buf
+                        = delay.process(sender->m_buffer, fpp, active);
 
                 // use sample-exact mixing if sample-exact values are
                 // available
@@ -575,13 +586,27 @@ void FxChannel::doProcessing()
     //        m_peakRight=m_peakLeft=0.;
     //}
 
+    writeStem();
     // increment dependency counter of all receivers
     processed();
 }
 
+void FxChannel::writeStem()
+{
+    if(m_stemDevice == nullptr)
+        return;
+
+    const fpp_t fpp = Engine::mixer()->framesPerPeriod();
+    if(m_mutedModel.value())
+        m_stemDevice->writeCaptured(nullptr, fpp);
+    else
+        m_stemDevice->writeCaptured(m_buffer, fpp, m_volumeModel.value(),
+                                    m_volumeModel.valueBuffer());
+}
+
 FxMixer::FxMixer() :
       Model(nullptr, "FxMixer"), JournallingObject(), m_fxRoutes(),
-      m_fxChannels()
+      m_fxChannels(), m_graphOrder(), m_graphOrderDirty(1), m_latency(0)
 {
     // create master channel
     createChannel();
@@ -613,6 +638,7 @@ int FxMixer::createChannel()
     const int index = m_fxChannels.size();
     // create new channel
     m_fxChannels.append(new FxChannel(index, this));
+    invalidateGraphOrder();
 
     // qInfo("FxMixer::createChannel 2");
     // reset channel state
@@ -724,6 +750,7 @@ void FxMixer::deleteChannel(int _index)
     qInfo("FxMixer::deleteChannel index=%d 2", _index);
     // actually delete the channel
     m_fxChannels.remove(_index);
+    invalidateGraphOrder();
     qInfo("FxMixer::deleteChannel index=%d 3", _index);
     delete ch;
     qInfo("FxMixer::deleteChannel index=%d 4", _index);
@@ -870,6 +897,7 @@ FxRoute* FxMixer::createRoute(FxChannel* from, FxChannel* to, real_t amount)
 
     // add us to fxmixer's list
     Engine::fxMixer()->m_fxRoutes.append(route);
+    Engine::fxMixer()->invalidateGraphOrder();
     // Engine::mixer()->doneChangeInModel();
 
     return route;
@@ -935,6 +963,7 @@ void FxMixer::deleteChannelSend(FxRoute* route)
     // Engine::fxMixer()->m_fxRoutes.remove(
     //  Engine::fxMixer()->m_fxRoutes.indexOf(route));
     m_fxRoutes.removeOne(route);
+    invalidateGraphOrder();
     // delete route;
     // Engine::mixer()->doneChangeInModel();
 }
@@ -1042,60 +1071,185 @@ void FxMixer::prepareMasterMix()
     // m_fxChannels[0]->m_lock.unlock();
 }
 
-void FxMixer::masterMix(sampleFrame* _buf)
+void FxMixer::computeGraphOrder()
 {
-    const int fpp = Engine::mixer()->framesPerPeriod();
-
-    // add the channels that have no dependencies (no incoming senders, ie.
-    // no receives) to the jobqueue. The channels that have receives get
-    // added when their senders get processed, which is detected by
-    // dependency counting.
-    // also instantly add all muted channels as they don't need to care
-    // about their senders, and can just increment the deps of their
-    // recipients right away.
-    MixerWorkerThread::
-            resetJobQueue();  // MixerWorkerThread::JobQueue::Dynamic);
-    for(FxChannel* ch: m_fxChannels)
+    // height = length of the longest chain of sends starting at the
+    // channel. A sender is always higher than its receivers, so sorting
+    // by decreasing height gives a topological order where the channels
+    // on the critical path come first.
+    const int    n = m_fxChannels.size();
+    QVector<int> height(n, -1);
+    QVector<int> stack;
+    stack.reserve(n);
+
+    for(int i = 0; i < n; ++i)
     {
-        /*
-        bool old=ch->m_muted;
-        ch->m_muted = ch->m_mutedModel.value();
-        if(old && (old!=ch->m_muted))
-                BufferManager::clear(ch->m_buffer);
-        */
+        if(height[i] >= 0)
+            continue;
 
-        /*
-        if( ch->m_muted ) // instantly "process" muted channels
+        // iterative depth-first search, -2 marks the channels on the stack
+        stack.append(i);
+        while(!stack.isEmpty())
         {
-                ch->processed();
-                ch->done();
-        }
-        else*/
-        if(ch->receives().size() == 0)
-        {
-            ch->setQueued(true);
-            MixerWorkerThread::addJob(ch);
+            const int c = stack.last();
+            if(height[c] >= 0)
+            {
+                // pushed twice, already done
+                stack.removeLast();
+                continue;
+            }
+
+            FxChannel* ch      = m_fxChannels[c];
+            bool       pending = false;
+            int        h       = 0;
+
+            height[c] = -2;
+            for(const FxRoute* route: ch->sends())
+            {
+                const FxChannel* r = route->receiver();
+                if(r == nullptr)
+                    continue;
+
+                const int ri = r->channelIndex();
+                if(ri < 0 || ri >= n || height[ri] == -2)
+                {
+                    qWarning("FxMixer::computeGraphOrder invalid route "
+                             "%d -> %d",
+                             c, ri);
+                    continue;
+                }
+                if(height[ri] < 0)
+                {
+                    stack.append(ri);
+                    pending = true;
+                }
+                else
+                    h = qMax(h, height[ri] + 1);
+            }
+
+            // visited again once its receivers are done
+            if(pending)
+                continue;
+
+            height[c] = h;
+            stack.removeLast();
         }
     }
-    while(m_fxChannels[0]->state() != ThreadableJob::Done)
+
+    m_graphOrder.resize(0);
+    for(FxChannel* ch: m_fxChannels)
+        m_graphOrder.append(ch);
+    std::stable_sort(m_graphOrder.begin(), m_graphOrder.end(),
+                     [&height](const FxChannel* a, const FxChannel* b) {
+                         return height[a->channelIndex()]
+                                > height[b->channelIndex()];
+                     });
+}
+
+void FxMixer::prepareGraph()
+{
+    // the routes are only changed between two periods
+    if(m_graphOrderDirty.fetchAndStoreAcquire(0) != 0)
+        computeGraphOrder();
+
+    for(FxChannel* ch: m_graphOrder)
     {
-        bool found = false;
-        for(FxChannel* ch: m_fxChannels)
+        ch->setQueued(false);
+        ch->resetDeps();
+        ch->m_inputLatency = 0;
+    }
+}
+
+void FxMixer::addGraphInput(ThreadableJob* _input,
+                            fx_ch_t        _ch,
+                            f_cnt_t        _latency)
+{
+    if(_ch < 0 || _ch >= m_fxChannels.size())
+    {
+        _input->setDependent(nullptr);
+        return;
+    }
+
+    FxChannel* ch = m_fxChannels[_ch];
+    ch->addDependency();
+    ch->m_inputLatency = qMax(ch->m_inputLatency, _latency);
+    _input->setDependent(ch);
+}
+
+void FxMixer::updateLatencies()
+{
+    // senders before receivers, so the output latency of all the senders
+    // of a channel is known when the channel is visited
+    for(FxChannel* ch: m_graphOrder)
+    {
+        for(const FxRoute* route: ch->m_receives)
         {
-            int s = ch->state();
-            if(s == ThreadableJob::Queued || s == ThreadableJob::InProgress)
-            {
-                found = true;
-                break;
-            }
+            const FxChannel* sender = route->sender();
+            if(sender != nullptr)
+                ch->m_inputLatency
+                        = qMax(ch->m_inputLatency, sender->m_outputLatency);
         }
-        if(!found)
+
+        f_cnt_t l = ch->m_inputLatency + ch->m_fxChain.latency();
+        if(ch->m_eqDJ && ch->m_eqDJEnableModel.value())
+            l += ch->m_eqDJ->latency();
+        ch->m_outputLatency = l;
+
+        for(FxRoute* route: ch->m_receives)
         {
-            break;
+            const FxChannel* sender = route->sender();
+            if(sender != nullptr)
+                route->compensation().setDelay(ch->m_inputLatency
+                                               - sender->m_outputLatency);
         }
-        MixerWorkerThread::startAndWaitForJobs();
     }
 
+    const f_cnt_t l = m_fxChannels[0]->m_outputLatency;
+    if(l != m_latency)
+    {
+        qInfo("FxMixer: latency %d frames", l);
+        m_latency = l;
+    }
+}
+
+f_cnt_t FxMixer::inputLatency(fx_ch_t _ch) const
+{
+    if(_ch < 0 || _ch >= m_fxChannels.size())
+        return 0;
+
+    return m_fxChannels[_ch]->m_inputLatency;
+}
+
+FxChannel* FxMixer::channelOf(Model* _m) const
+{
+    for(Model* m = _m; m != nullptr; m = m->parentModel())
+    {
+        FxChannel* ch = dynamic_cast<FxChannel*>(m);
+        if(ch != nullptr)
+            return m_fxChannels.contains(ch) ? ch : nullptr;
+    }
+    return nullptr;
+}
+
+void FxMixer::releaseGraph()
+{
+    // the channels that have no input left (no incoming senders, ie. no
+    // receives, and no audio port still processing) are queued right away.
+    // The other ones get queued when their last input is done, which is
+    // detected by dependency counting.
+    // Released from the lowest to the highest channel: the worker deques
+    // are LIFO, so the longest chains of sends are started first.
+    for(int i = m_graphOrder.size() - 1; i >= 0; --i)
+        m_graphOrder[i]->incrementDeps();
+}
+
+void FxMixer::masterMix(sampleFrame* _buf)
+{
+    const int fpp = Engine::mixer()->framesPerPeriod();
+
+    // all channels, including master, have been processed in the job
+    // graph of the mixer at this point
+
     /*
     // handle sample-exact data in master volume fader
     ValueBuffer * volBuf = m_fxChannels[0]->m_volumeModel.valueBuffer();
@@ -1152,7 +1306,6 @@ void FxMixer::masterMix(sampleFrame* _buf)
         m_fxChannels[i]->reset();
         m_fxChannels[i]->setQueued(false);
         m_fxChannels[i]->setHasInput(false);
-        m_fxChannels[i]->resetDeps();
     }
 }
 
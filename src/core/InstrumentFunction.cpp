@@ -406,7 +406,7 @@ bool InstrumentFunctionNoteStacking::processNote(NotePlayHandle* _n)
                             subnote, _n, -1,
                             NotePlayHandle::OriginNoteStacking,
                             _n->generation() + 1);
-                    Engine::mixer()->emit playHandleToAdd(nph->pointer());
+                    Engine::mixer()->addPlayHandle(nph->pointer());
                 }
             }
         }
@@ -719,7 +719,7 @@ bool InstrumentFunctionArpeggio::processNote(NotePlayHandle* _n)
                     _n->instrumentTrack(), frames_processed, gated_frames,
                     subnote, _n, -1, NotePlayHandle::OriginArpeggio,
                     _n->generation() + 1);
-            Engine::mixer()->emit playHandleToAdd(nph->pointer());
+            Engine::mixer()->addPlayHandle(nph->pointer());
         }
 
         // update counters
@@ -1713,7 +1713,7 @@ bool InstrumentFunctionGlissando::processNote(NotePlayHandle* _n)
                     _n->instrumentTrack(), frames_processed, gated_frames,
                     subnote, _n, -1, NotePlayHandle::OriginGlissando,
                     _n->generation() + 1);
-            Engine::mixer()->emit playHandleToAdd(nph->pointer());
+            Engine::mixer()->addPlayHandle(nph->pointer());
         }
 
         // update counters
@@ -1753,7 +1753,7 @@ bool InstrumentFunctionGlissando::processNote(NotePlayHandle* _n)
                 _n->instrumentTrack(), frames_processed,
                 _n->frames() - total_frames, note, nullptr, -1,
                 NotePlayHandle::OriginGlissando, _n->generation());
-        Engine::mixer()->emit playHandleToAdd(nph->pointer());
+        Engine::mixer()->addPlayHandle(nph->pointer());
     }
 
     return false;
@@ -1976,7 +1976,7 @@ void InstrumentFunctionNotePlaying::onGateChanged()
     // nph->incrRefCount();
     m_currentPH  = nph->pointer();
     m_currentNPH = nph;
-    Engine::mixer()->emit playHandleToAdd(m_currentPH);
+    Engine::mixer()->addPlayHandle(m_currentPH);
 }
 
 void InstrumentFunctionNotePlaying::saveSettings(QDomDocument& _doc,
@@ -26,6 +26,7 @@
 #include "BasicFilters.h"
 #include "Engine.h"
 #include "EnvelopeAndLfo.h"
+#include "FilterCoeffsTable.h"
 #include "Instrument.h"
 #include "InstrumentPlayHandle.h"
 #include "InstrumentTrack.h"
@@ -39,6 +40,41 @@ const real_t CUT_FREQ_MULTIPLIER = 6000.;
 const real_t RES_MULTIPLIER      = 2.;
 const real_t RES_PRECISION       = 1000.;
 
+// the coefficients from the tables are interpolated between control points
+const fpp_t CONTROL_FRAMES = 16;
+
+// envelope levels of the worker thread, one buffer per target
+struct ShapingScratch
+{
+    fpp_t   size;
+    real_t* levels;
+
+    ShapingScratch() : size(0), levels(nullptr)
+    {
+    }
+
+    ~ShapingScratch()
+    {
+        delete[] levels;
+    }
+
+    void reserve(const fpp_t _frames)
+    {
+        if(_frames <= size)
+            return;
+        delete[] levels;
+        size   = _frames;
+        levels = new real_t[size * InstrumentSoundShaping::NumTargets];
+    }
+
+    real_t* buffer(const int _target)
+    {
+        return levels + _target * size;
+    }
+};
+
+static thread_local ShapingScratch s_scratch;
+
 // names for env- and lfo-targets - first is name being displayed to user
 // and second one is used internally, e.g. for saving/restoring settings
 const QString InstrumentSoundShaping::targetNames
@@ -208,6 +244,15 @@ InstrumentSoundShaping::InstrumentSoundShaping(
     m_filter2TypeModel.addItem(tr("Brown"), new PixmapLoader("filter_lp"));
     m_filter2TypeModel.addItem(tr("Pink"), new PixmapLoader("filter_lp"));
     m_filter2TypeModel.addItem(tr("Peak"), new PixmapLoader("filter_bp"));
+
+    // build the coefficient tables before the filters are played
+    connect(&m_filter1EnabledModel, SIGNAL(dataChanged()), this,
+            SLOT(updateFilterTables()));
+    connect(&m_filter1TypeModel, SIGNAL(dataChanged()), this,
+            SLOT(updateFilterTables()));
+    connect(Engine::mixer(), SIGNAL(sampleRateChanged()), this,
+            SLOT(updateFilterTables()));
+    updateFilterTables();
 }
 
 InstrumentSoundShaping::~InstrumentSoundShaping()
@@ -219,6 +264,14 @@ InstrumentSoundShaping::~InstrumentSoundShaping()
     // qInfo("InstrumentSoundShaping::~InstrumentSoundShaping END");
 }
 
+void InstrumentSoundShaping::updateFilterTables()
+{
+    // only the first filter follows the envelopes
+    if(m_filter1EnabledModel.value())
+        FilterCoeffsTable::get(m_filter1TypeModel.value(),
+                               Engine::mixer()->processingSampleRate());
+}
+
 real_t InstrumentSoundShaping::volumeLevel(NotePlayHandle* n,
                                            const f_cnt_t   frame)
 {
@@ -288,10 +341,12 @@ void InstrumentSoundShaping::processAudioBuffer(sampleFrame*    buffer,
 
     // only use filter, if it is really needed
 
+    s_scratch.reserve(frames);
+
     if(filter1 != nullptr && m_filter1EnabledModel.value())
     {
-        real_t* cutBuffer = MM_ALLOC(real_t, frames);
-        real_t* resBuffer = MM_ALLOC(real_t, frames);
+        real_t* cutBuffer = s_scratch.buffer(Cut);
+        real_t* resBuffer = s_scratch.buffer(Resonance);
 
         int old_filter_cut = 0;
         int old_filter_res = 0;
@@ -319,8 +374,52 @@ void InstrumentSoundShaping::processAudioBuffer(sampleFrame*    buffer,
         const real_t frv = m_filter1ResModel.value();
         const real_t fgv = m_filter1GainModel.value();
 
-        if(m_envLfo[Cut]->isUsed()
-           && m_envLfo[Resonance]->isUsed())
+        const bool cutUsed = m_envLfo[Cut]->isUsed();
+        const bool resUsed = m_envLfo[Resonance]->isUsed();
+
+        // nullptr for Peak, which depends on the gain, and until
+        // updateFilterTables() has built the table: the coefficients
+        // are then computed directly below
+        const FilterCoeffsTable* table
+                = (cutUsed || resUsed)
+                          ? FilterCoeffsTable::find(filter1->type(),
+                                                    filter1->sampleRate())
+                          : nullptr;
+
+        if(table != nullptr)
+        {
+            auto cutAt = [=](const fpp_t _frame) {
+                return cutUsed ? EnvelopeAndLfo::expKnobVal(cutBuffer[_frame])
+                                                 * CUT_FREQ_MULTIPLIER
+                                         + fcv
+                               : fcv;
+            };
+            auto resAt = [=](const fpp_t _frame) {
+                return resUsed ? frv + RES_MULTIPLIER * resBuffer[_frame]
+                               : frv;
+            };
+
+            FilterCoeffs from, to, coeffs;
+            table->lookup(cutAt(0), resAt(0), from);
+            for(fpp_t f0 = 0; f0 < frames; f0 += CONTROL_FRAMES)
+            {
+                const fpp_t n    = qMin<fpp_t>(CONTROL_FRAMES, frames - f0);
+                const fpp_t next = qMin<fpp_t>(f0 + n, frames - 1);
+                table->lookup(cutAt(next), resAt(next), to);
+
+                for(fpp_t f = 0; f < n; ++f)
+                {
+                    const real_t t = real_t(f) / n;
+                    for(int k = 0; k < 8; ++k)
+                        coeffs.c[k] = from.c[k] + (to.c[k] - from.c[k]) * t;
+                    filter1->setCoeffs(coeffs);
+                    filter1->update(buffer[f0 + f]);
+                }
+                from = to;
+            }
+        }
+        else if(m_envLfo[Cut]->isUsed()
+                && m_envLfo[Resonance]->isUsed())
         {
             for(fpp_t frame = 0; frame < frames; ++frame)
             {
@@ -415,9 +514,6 @@ void InstrumentSoundShaping::processAudioBuffer(sampleFrame*    buffer,
             }
         }
 
-        MM_FREE(resBuffer);
-        MM_FREE(cutBuffer);
-
         real_t resp = m_filter1ResponseModel.value();
         if(resp != 0.)
         {
@@ -490,7 +586,7 @@ void InstrumentSoundShaping::processAudioBuffer(sampleFrame*    buffer,
 
     if(m_envLfo[Volume]->isUsed())
     {
-        real_t volBuffer[frames];
+        real_t* volBuffer = s_scratch.buffer(Volume);
         m_envLfo[Volume]->fillLevel(volBuffer, envTotalFrames,
                                               envReleaseBegin, frames,
                                               _legato, _marcato, _staccato);
@@ -32,16 +32,31 @@
 #include <QApplication>
 //#include <QCoreApplication>
 //#include <QDebug>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QLibrary>
+#include <QMutexLocker>
+#include <QSet>
+#include <QStandardPaths>
 
 #include <cmath>
 
+static const quint32 CACHE_VERSION = 1;
+
 LadspaManager::LadspaManager()
 {
     // Make sure plugin search paths are set up
     PluginFactory::instance();
 
+    QElapsedTimer timer;
+    timer.start();
+    readCache();
+    QSet<QString> seen;
+    bool          cacheChanged = false;
+    int           nbLoaded = 0, nbCached = 0;
+
     QStringList ladspaDirectories
             = QString(getenv("LADSPA_PATH")).split(LADSPA_PATH_SEPARATOR);
     ladspaDirectories += ConfigManager::inst()->ladspaDir().split(',');
@@ -87,6 +102,22 @@ LadspaManager::LadspaManager()
                 continue;
             }
 
+            seen.insert(path);
+
+            // the libraries not changed since the last run are loaded
+            // when one of their plugins is used
+            const qint64 time = f.lastModified().toMSecsSinceEpoch();
+            if(m_cache.contains(path) && m_cache.value(path).size == f.size()
+               && m_cache.value(path).time == time)
+            {
+                addCachedPlugins(f);
+                ++nbCached;
+                continue;
+            }
+
+            cacheChanged = true;
+            m_cache.remove(path);
+
             QLibrary plugin_lib(path);
 
             if(plugin_lib.load())
@@ -96,7 +127,11 @@ LadspaManager::LadspaManager()
                                 "ladspa_descriptor");
                 if(descriptorFunction != nullptr)
                 {
+                    CachedLibrary& lib = m_cache[path];
+                    lib.size           = f.size();
+                    lib.time           = time;
                     addPlugins(descriptorFunction, f);  //.fileName());
+                    ++nbLoaded;
                 }
             }
             else
@@ -106,6 +141,19 @@ LadspaManager::LadspaManager()
         }
     }
 
+    for(const QString& path: m_cache.keys())
+        if(!seen.contains(path))
+        {
+            m_cache.remove(path);
+            cacheChanged = true;
+        }
+    if(cacheChanged)
+        writeCache();
+
+    qInfo("Ladspa: %d plugins, %d libraries from the cache, %d loaded, "
+          "%lld ms",
+          m_ladspaManagerMap.size(), nbCached, nbLoaded, timer.elapsed());
+
     l_ladspa_key_t keys = m_ladspaManagerMap.keys();
     for(l_ladspa_key_t::iterator it = keys.begin(); it != keys.end(); ++it)
     {
@@ -165,6 +213,10 @@ void LadspaManager::addPlugins(LADSPA_Descriptor_Function _descriptor_func,
         plugIn->index                    = pluginIndex;
         plugIn->inputChannels            = getPluginInputs(descriptor);
         plugIn->outputChannels           = getPluginOutputs(descriptor);
+        plugIn->path                     = _file.absoluteFilePath();
+        plugIn->label                    = label;
+        plugIn->name                     = descriptor->Name;
+        plugIn->properties               = descriptor->Properties;
 
         static const char* TYPES[]
                 = {"Instrument", "Effect", "Sink", "Utility"};
@@ -191,7 +243,134 @@ void LadspaManager::addPlugins(LADSPA_Descriptor_Function _descriptor_func,
 
         // m_ladspaManagerMap[key] = plugIn;
         m_ladspaManagerMap.insert(key, plugIn);  //[key] = plugIn;
+        m_cache[plugIn->path].plugins.append(*plugIn);
+    }
+}
+
+void LadspaManager::addCachedPlugins(const QFileInfo& _file)
+{
+    for(const ladspaManagerDescription& d:
+        m_cache.value(_file.absoluteFilePath()).plugins)
+    {
+        ladspa_key_t key(_file.fileName(), d.label);
+        if(m_ladspaManagerMap.contains(key))
+            continue;
+
+        ladspaManagerDescription* plugIn = new ladspaManagerDescription(d);
+        plugIn->descriptorFunction       = nullptr;
+        m_ladspaManagerMap.insert(key, plugIn);
+    }
+}
+
+LADSPA_Descriptor_Function
+        LadspaManager::loadDescriptorFunction(const ladspa_key_t& _plugin)
+{
+    ladspaManagerDescription* d = m_ladspaManagerMap.value(_plugin, nullptr);
+    if(d == nullptr)
+        return nullptr;
+
+    LADSPA_Descriptor_Function r
+            = d->descriptorFunction.load(std::memory_order_acquire);
+    if(r != nullptr)
+        return r;
+
+    QMutexLocker locker(&m_loadMutex);
+    r = d->descriptorFunction.load(std::memory_order_acquire);
+    if(r == nullptr)
+    {
+        QLibrary                   lib(d->path);
+        LADSPA_Descriptor_Function f
+                = lib.load() ? (LADSPA_Descriptor_Function)lib.resolve(
+                          "ladspa_descriptor")
+                             : nullptr;
+        if(f == nullptr)
+        {
+            qCritical("Ladspa: fail to load %s: %s", qPrintable(d->path),
+                      qPrintable(lib.errorString()));
+            return nullptr;
+        }
+
+        qInfo("Ladspa: loaded %s", qPrintable(d->path));
+        // the other plugins of the library are loaded too
+        for(ladspaManagerDescription* o: m_ladspaManagerMap)
+            if(o->path == d->path)
+                o->descriptorFunction.store(f, std::memory_order_release);
+        r = f;
     }
+    return r;
+}
+
+QString LadspaManager::cacheFile()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+           + "/ladspa.cache";
+}
+
+void LadspaManager::readCache()
+{
+    QFile f(cacheFile());
+    if(!f.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream in(&f);
+    quint32     version = 0, n = 0;
+    in >> version >> n;
+    if(version != CACHE_VERSION)
+        return;
+
+    for(quint32 i = 0; i < n && in.status() == QDataStream::Ok; ++i)
+    {
+        QString       path;
+        CachedLibrary lib;
+        quint32       count = 0;
+        in >> path >> lib.size >> lib.time >> count;
+        for(quint32 j = 0; j < count && in.status() == QDataStream::Ok; ++j)
+        {
+            ladspaManagerDescription d;
+            qint32                   type = OTHER;
+            in >> d.label >> d.name >> d.index >> type >> d.inputChannels
+                    >> d.outputChannels >> d.properties;
+            d.descriptorFunction = nullptr;
+            d.type               = ladspaPluginType(type);
+            d.path               = path;
+            lib.plugins.append(d);
+        }
+        m_cache.insert(path, lib);
+    }
+
+    // rebuilt from the libraries if unreadable
+    if(in.status() != QDataStream::Ok)
+    {
+        qWarning("Ladspa: bad cache %s", qPrintable(f.fileName()));
+        m_cache.clear();
+    }
+}
+
+void LadspaManager::writeCache()
+{
+    const QString file = cacheFile();
+    if(!QDir().mkpath(QFileInfo(file).absolutePath()))
+        return;
+
+    QFile f(file + ".part");
+    if(!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return;
+
+    QDataStream out(&f);
+    out << CACHE_VERSION << quint32(m_cache.size());
+    for(auto it = m_cache.constBegin(); it != m_cache.constEnd(); ++it)
+    {
+        out << it.key() << it.value().size << it.value().time
+            << quint32(it.value().plugins.size());
+        for(const ladspaManagerDescription& d: it.value().plugins)
+            out << d.label << d.name << d.index << qint32(d.type)
+                << d.inputChannels << d.outputChannels << d.properties;
+    }
+    f.close();
+
+    QFile::remove(file);
+    if(!f.rename(file))
+        f.remove();
 }
 
 uint16_t LadspaManager::getPluginInputs(const LADSPA_Descriptor* _descriptor)
@@ -239,28 +418,15 @@ l_sortable_plugin_t LadspaManager::getSortedPlugins()
 
 QString LadspaManager::getLabel(const ladspa_key_t& _plugin)
 {
-    if(m_ladspaManagerMap.contains(_plugin))
-    {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
-        return QString(descriptor->Label);
-    }
-    else
-    {
-        return QString("");
-    }
+    ladspaManagerDescription* d = m_ladspaManagerMap.value(_plugin, nullptr);
+    return d != nullptr ? d->label : QString("");
 }
 
 bool LadspaManager::hasRealTimeDependency(const ladspa_key_t& _plugin)
 {
-    if(m_ladspaManagerMap.contains(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         return (LADSPA_IS_REALTIME(descriptor->Properties));
     }
     else
@@ -271,12 +437,9 @@ bool LadspaManager::hasRealTimeDependency(const ladspa_key_t& _plugin)
 
 bool LadspaManager::isInplaceBroken(const ladspa_key_t& _plugin)
 {
-    if(m_ladspaManagerMap.contains(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         return (LADSPA_IS_INPLACE_BROKEN(descriptor->Properties));
     }
     else
@@ -287,44 +450,22 @@ bool LadspaManager::isInplaceBroken(const ladspa_key_t& _plugin)
 
 bool LadspaManager::isRealTimeCapable(const ladspa_key_t& _plugin)
 {
-    if(m_ladspaManagerMap.contains(_plugin))
-    {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
-        return (LADSPA_IS_HARD_RT_CAPABLE(descriptor->Properties));
-    }
-    else
-    {
-        return false;
-    }
+    ladspaManagerDescription* d = m_ladspaManagerMap.value(_plugin, nullptr);
+    return d != nullptr && LADSPA_IS_HARD_RT_CAPABLE(d->properties);
 }
 
 QString LadspaManager::getName(const ladspa_key_t& _plugin)
 {
-    if(m_ladspaManagerMap.contains(_plugin))
-    {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
-        return (QString(descriptor->Name));
-    }
-    else
-    {
-        return (QString(""));
-    }
+    // cached, the library is not loaded for the lists of plugins
+    ladspaManagerDescription* d = m_ladspaManagerMap.value(_plugin, nullptr);
+    return d != nullptr ? d->name : QString("");
 }
 
 QString LadspaManager::getMaker(const ladspa_key_t& _plugin)
 {
-    if(m_ladspaManagerMap.contains(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         return (QString(descriptor->Maker));
     }
     else
@@ -335,12 +476,9 @@ QString LadspaManager::getMaker(const ladspa_key_t& _plugin)
 
 QString LadspaManager::getCopyright(const ladspa_key_t& _plugin)
 {
-    if(m_ladspaManagerMap.contains(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         return (QString(descriptor->Copyright));
     }
     else
@@ -351,12 +489,9 @@ QString LadspaManager::getCopyright(const ladspa_key_t& _plugin)
 
 uint32_t LadspaManager::getPortCount(const ladspa_key_t& _plugin)
 {
-    if(m_ladspaManagerMap.contains(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         return (descriptor->PortCount);
     }
     else
@@ -367,13 +502,9 @@ uint32_t LadspaManager::getPortCount(const ladspa_key_t& _plugin)
 
 bool LadspaManager::isPortInput(const ladspa_key_t& _plugin, uint32_t _port)
 {
-    if(m_ladspaManagerMap.contains(_plugin) && _port < getPortCount(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr && _port < descriptor->PortCount)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
-
         return (LADSPA_IS_PORT_INPUT(descriptor->PortDescriptors[_port]));
     }
     else
@@ -384,13 +515,9 @@ bool LadspaManager::isPortInput(const ladspa_key_t& _plugin, uint32_t _port)
 
 bool LadspaManager::isPortOutput(const ladspa_key_t& _plugin, uint32_t _port)
 {
-    if(m_ladspaManagerMap.contains(_plugin) && _port < getPortCount(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr && _port < descriptor->PortCount)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
-
         return (LADSPA_IS_PORT_OUTPUT(descriptor->PortDescriptors[_port]));
     }
     else
@@ -401,13 +528,9 @@ bool LadspaManager::isPortOutput(const ladspa_key_t& _plugin, uint32_t _port)
 
 bool LadspaManager::isPortAudio(const ladspa_key_t& _plugin, uint32_t _port)
 {
-    if(m_ladspaManagerMap.contains(_plugin) && _port < getPortCount(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr && _port < descriptor->PortCount)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
-
         return (LADSPA_IS_PORT_AUDIO(descriptor->PortDescriptors[_port]));
     }
     else
@@ -418,13 +541,9 @@ bool LadspaManager::isPortAudio(const ladspa_key_t& _plugin, uint32_t _port)
 
 bool LadspaManager::isPortControl(const ladspa_key_t& _plugin, uint32_t _port)
 {
-    if(m_ladspaManagerMap.contains(_plugin) && _port < getPortCount(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr && _port < descriptor->PortCount)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
-
         return (LADSPA_IS_PORT_CONTROL(descriptor->PortDescriptors[_port]));
     }
     else
@@ -436,12 +555,9 @@ bool LadspaManager::isPortControl(const ladspa_key_t& _plugin, uint32_t _port)
 bool LadspaManager::areHintsSampleRateDependent(const ladspa_key_t& _plugin,
                                                 uint32_t            _port)
 {
-    if(m_ladspaManagerMap.contains(_plugin) && _port < getPortCount(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr && _port < descriptor->PortCount)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         LADSPA_PortRangeHintDescriptor hintDescriptor
                 = descriptor->PortRangeHints[_port].HintDescriptor;
         return (LADSPA_IS_HINT_SAMPLE_RATE(hintDescriptor));
@@ -455,12 +571,9 @@ bool LadspaManager::areHintsSampleRateDependent(const ladspa_key_t& _plugin,
 float LadspaManager::getLowerBound(const ladspa_key_t& _plugin,
                                    uint32_t            _port)
 {
-    if(m_ladspaManagerMap.contains(_plugin) && _port < getPortCount(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr && _port < descriptor->PortCount)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         LADSPA_PortRangeHintDescriptor hintDescriptor
                 = descriptor->PortRangeHints[_port].HintDescriptor;
         if(LADSPA_IS_HINT_BOUNDED_BELOW(hintDescriptor))
@@ -481,12 +594,9 @@ float LadspaManager::getLowerBound(const ladspa_key_t& _plugin,
 float LadspaManager::getUpperBound(const ladspa_key_t& _plugin,
                                    uint32_t            _port)
 {
-    if(m_ladspaManagerMap.contains(_plugin) && _port < getPortCount(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr && _port < descriptor->PortCount)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         LADSPA_PortRangeHintDescriptor hintDescriptor
                 = descriptor->PortRangeHints[_port].HintDescriptor;
         if(LADSPA_IS_HINT_BOUNDED_ABOVE(hintDescriptor))
@@ -506,12 +616,9 @@ float LadspaManager::getUpperBound(const ladspa_key_t& _plugin,
 
 bool LadspaManager::isPortToggled(const ladspa_key_t& _plugin, uint32_t _port)
 {
-    if(m_ladspaManagerMap.contains(_plugin) && _port < getPortCount(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr && _port < descriptor->PortCount)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         LADSPA_PortRangeHintDescriptor hintDescriptor
                 = descriptor->PortRangeHints[_port].HintDescriptor;
         return (LADSPA_IS_HINT_TOGGLED(hintDescriptor));
@@ -525,12 +632,9 @@ bool LadspaManager::isPortToggled(const ladspa_key_t& _plugin, uint32_t _port)
 float LadspaManager::getDefaultSetting(const ladspa_key_t& _plugin,
                                        uint32_t            _port)
 {
-    if(m_ladspaManagerMap.contains(_plugin) && _port < getPortCount(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr && _port < descriptor->PortCount)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         LADSPA_PortRangeHintDescriptor hintDescriptor
                 = descriptor->PortRangeHints[_port].HintDescriptor;
         switch(hintDescriptor & LADSPA_HINT_DEFAULT_MASK)
@@ -609,12 +713,9 @@ float LadspaManager::getDefaultSetting(const ladspa_key_t& _plugin,
 
 bool LadspaManager::isLogarithmic(const ladspa_key_t& _plugin, uint32_t _port)
 {
-    if(m_ladspaManagerMap.contains(_plugin) && _port < getPortCount(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr && _port < descriptor->PortCount)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         LADSPA_PortRangeHintDescriptor hintDescriptor
                 = descriptor->PortRangeHints[_port].HintDescriptor;
         return (LADSPA_IS_HINT_LOGARITHMIC(hintDescriptor));
@@ -627,12 +728,9 @@ bool LadspaManager::isLogarithmic(const ladspa_key_t& _plugin, uint32_t _port)
 
 bool LadspaManager::isInteger(const ladspa_key_t& _plugin, uint32_t _port)
 {
-    if(m_ladspaManagerMap.contains(_plugin) && _port < getPortCount(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr && _port < descriptor->PortCount)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         LADSPA_PortRangeHintDescriptor hintDescriptor
                 = descriptor->PortRangeHints[_port].HintDescriptor;
         return (LADSPA_IS_HINT_INTEGER(hintDescriptor));
@@ -646,13 +744,9 @@ bool LadspaManager::isInteger(const ladspa_key_t& _plugin, uint32_t _port)
 QString LadspaManager::getPortName(const ladspa_key_t& _plugin,
                                    uint32_t            _port)
 {
-    if(m_ladspaManagerMap.contains(_plugin) && _port < getPortCount(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr && _port < descriptor->PortCount)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
-
         return (QString(descriptor->PortNames[_port]));
     }
     else
@@ -663,12 +757,9 @@ QString LadspaManager::getPortName(const ladspa_key_t& _plugin,
 
 const void* LadspaManager::getImplementationData(const ladspa_key_t& _plugin)
 {
-    if(m_ladspaManagerMap.contains(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         return (descriptor->ImplementationData);
     }
     else
@@ -677,32 +768,24 @@ const void* LadspaManager::getImplementationData(const ladspa_key_t& _plugin)
     }
 }
 
+// nullptr if the plugin is unknown or its library can not be loaded
 const LADSPA_Descriptor*
         LadspaManager::getDescriptor(const ladspa_key_t& _plugin)
 {
-    if(m_ladspaManagerMap.contains(_plugin))
-    {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
-        return (descriptor);
-    }
-    else
-    {
-        return (nullptr);
-    }
+    LADSPA_Descriptor_Function descriptorFunction
+            = loadDescriptorFunction(_plugin);
+    if(descriptorFunction == nullptr)
+        return nullptr;
+
+    return descriptorFunction(m_ladspaManagerMap.value(_plugin)->index);
 }
 
 LADSPA_Handle LadspaManager::instantiate(const ladspa_key_t& _plugin,
                                          uint32_t            _sample_rate)
 {
-    if(m_ladspaManagerMap.contains(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         return ((descriptor->instantiate)(descriptor, _sample_rate));
     }
     else
@@ -716,12 +799,9 @@ bool LadspaManager::connectPort(const ladspa_key_t& _plugin,
                                 uint32_t            _port,
                                 LADSPA_Data*        _data_location)
 {
-    if(m_ladspaManagerMap.contains(_plugin) && _port < getPortCount(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr && _port < descriptor->PortCount)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         if(descriptor->connect_port != nullptr)
         {
             (descriptor->connect_port)(_instance, _port, _data_location);
@@ -734,12 +814,9 @@ bool LadspaManager::connectPort(const ladspa_key_t& _plugin,
 bool LadspaManager::activate(const ladspa_key_t& _plugin,
                              LADSPA_Handle       _instance)
 {
-    if(m_ladspaManagerMap.contains(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         if(descriptor->activate != nullptr)
         {
             (descriptor->activate)(_instance);
@@ -753,12 +830,9 @@ bool LadspaManager::run(const ladspa_key_t& _plugin,
                         LADSPA_Handle       _instance,
                         uint32_t            _sample_count)
 {
-    if(m_ladspaManagerMap.contains(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         if(descriptor->run != nullptr)
         {
             (descriptor->run)(_instance, _sample_count);
@@ -772,12 +846,9 @@ bool LadspaManager::runAdding(const ladspa_key_t& _plugin,
                               LADSPA_Handle       _instance,
                               uint32_t            _sample_count)
 {
-    if(m_ladspaManagerMap.contains(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         if(descriptor->run_adding != nullptr
            && descriptor->set_run_adding_gain != nullptr)
         {
@@ -792,12 +863,9 @@ bool LadspaManager::setRunAddingGain(const ladspa_key_t& _plugin,
                                      LADSPA_Handle       _instance,
                                      LADSPA_Data         _gain)
 {
-    if(m_ladspaManagerMap.contains(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         if(descriptor->run_adding != nullptr
            && descriptor->set_run_adding_gain != nullptr)
         {
@@ -811,13 +879,10 @@ bool LadspaManager::setRunAddingGain(const ladspa_key_t& _plugin,
 bool LadspaManager::deactivate(const ladspa_key_t& _plugin,
                                LADSPA_Handle       _instance)
 {
-    if(m_ladspaManagerMap.contains(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr)
     {
         BACKTRACE
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         if(descriptor->deactivate != nullptr)
         {
             (descriptor->deactivate)(_instance);
@@ -830,12 +895,9 @@ bool LadspaManager::deactivate(const ladspa_key_t& _plugin,
 bool LadspaManager::cleanup(const ladspa_key_t& _plugin,
                             LADSPA_Handle       _instance)
 {
-    if(m_ladspaManagerMap.contains(_plugin))
+    const LADSPA_Descriptor* descriptor = getDescriptor(_plugin);
+    if(descriptor != nullptr)
     {
-        LADSPA_Descriptor_Function descriptorFunction
-                = m_ladspaManagerMap[_plugin]->descriptorFunction;
-        const LADSPA_Descriptor* descriptor
-                = descriptorFunction(m_ladspaManagerMap[_plugin]->index);
         if(descriptor->cleanup != nullptr)
         {
             (descriptor->cleanup)(_instance);
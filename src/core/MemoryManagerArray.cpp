@@ -25,34 +25,16 @@
 #include "Backtrace.h"
 #include "lmms_basics.h"  // REQUIRED
 
-bool MemoryManagerArray::s_active = false;
+#include <QVector>
 
-/*
-MemoryManagerArray MemoryManagerArray::S4   (  512,   4);
-MemoryManagerArray MemoryManagerArray::S8   (   64,   8);
-MemoryManagerArray MemoryManagerArray::S16  (  256,  16);
-MemoryManagerArray MemoryManagerArray::S32  (  512,
-32,"SampleBuffer::handleState"); MemoryManagerArray MemoryManagerArray::S80  (
-4096,  80,"NotePlayHandle"); MemoryManagerArray MemoryManagerArray::S112 (
-128, 112); MemoryManagerArray MemoryManagerArray::S128 (   64, 128);
-MemoryManagerArray MemoryManagerArray::S192 (  256, 192);
-//200 drumsynth
-MemoryManagerArray MemoryManagerArray::S224 ( 4096, 224,"DetuningHelper");
-MemoryManagerArray MemoryManagerArray::S264 ( 2048, 264,"NotePlayHandle");
-MemoryManagerArray MemoryManagerArray::S480 ( 1024, 480,"BasicFilters");
-MemoryManagerArray MemoryManagerArray::S496 (   64, 496);
-MemoryManagerArray MemoryManagerArray::S512 ( 2048, 512,"tmp");
-MemoryManagerArray MemoryManagerArray::S552 ( 4096, 552);
-//968
-MemoryManagerArray MemoryManagerArray::S1024(  256,1024);
-MemoryManagerArray MemoryManagerArray::S1056(  768,1056);
-MemoryManagerArray MemoryManagerArray::S1392(  128,1392);
-MemoryManagerArray MemoryManagerArray::S2048(  256,2048,"Buffer");
-MemoryManagerArray MemoryManagerArray::S2464(   64,2464);
-//2760
-//4096
-MemoryManagerArray MemoryManagerArray::S4128( 256,4128);
-*/
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef LMMS_BUILD_WIN32
+#include <malloc.h>
+#endif
+
+bool MemoryManagerArray::s_active = false;
 
 int                 L2[32768];
 int                 P2[16];
@@ -67,13 +49,177 @@ MemoryManagerArray* MMA[16];
 #define MMA_STD_FREE(ptr) ::free(ptr)
 
 #define C2ULI (unsigned long int)
+
+// slab table: address >> SlabShift -> class << 16 | slab number
+static const int              SLAB_TABLE_SIZE = 16384;
+static std::atomic<quintptr>  s_slabKeys[SLAB_TABLE_SIZE];
+static std::atomic<int>       s_slabValues[SLAB_TABLE_SIZE];
+
+static inline int slabHash(quintptr _key)
+{
+    return int((quint64(_key) * 0x9E3779B97F4A7C15ULL) >> 50)
+           & (SLAB_TABLE_SIZE - 1);
+}
+
+static QMutex s_slabTableMutex;
+
+// called when a class grows only, lookups do not lock
+static bool registerSlab(char* _slab, int _value)
+{
+    QMutexLocker locker(&s_slabTableMutex);
+
+    const quintptr key = quintptr(_slab) >> MemoryManagerArray::SlabShift;
+    for(int n = 0, h = slabHash(key); n < SLAB_TABLE_SIZE;
+        ++n, h = (h + 1) & (SLAB_TABLE_SIZE - 1))
+    {
+        if(s_slabKeys[h].load(std::memory_order_relaxed) == 0)
+        {
+            s_slabValues[h].store(_value, std::memory_order_relaxed);
+            s_slabKeys[h].store(key, std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+static int findSlab(const void* _ptr)
+{
+    const quintptr key = quintptr(_ptr) >> MemoryManagerArray::SlabShift;
+    for(int n = 0, h = slabHash(key); n < SLAB_TABLE_SIZE;
+        ++n, h = (h + 1) & (SLAB_TABLE_SIZE - 1))
+    {
+        const quintptr k = s_slabKeys[h].load(std::memory_order_acquire);
+        if(k == key)
+            return s_slabValues[h].load(std::memory_order_relaxed);
+        if(k == 0)
+            break;
+    }
+    return -1;
+}
+
+static char* allocateSlab()
+{
+    void* r = nullptr;
+#ifdef LMMS_BUILD_WIN32
+    r = _aligned_malloc(MemoryManagerArray::SlabSize,
+                        MemoryManagerArray::SlabSize);
+#else
+    if(posix_memalign(&r, MemoryManagerArray::SlabSize,
+                      MemoryManagerArray::SlabSize)
+       != 0)
+        r = nullptr;
+#endif
+    return static_cast<char*>(r);
+}
+
+// allocations per call site
+struct CallSite
+{
+    std::atomic<quint64>   key;
+    const char*            file;
+    long                   line;
+    std::atomic<long>      count;
+    std::atomic<long long> bytes;
+};
+
+static const int CALL_SITES_SIZE = 4096;
+static CallSite  s_callSites[CALL_SITES_SIZE];
+// one allocation out of CALL_SITE_SAMPLING is recorded per thread
+static const int CALL_SITE_SAMPLING = 64;
+
+static void recordCallSite(const char* _file, long _line, size_t _size)
+{
+    const quint64 key = ((quint64(quintptr(_file)) << 16) ^ quint64(_line)
+                         ^ (quint64(_line) << 48))
+                        | 1;
+    for(int n = 0, h = int((key * 0x9E3779B97F4A7C15ULL) >> 52)
+                       & (CALL_SITES_SIZE - 1);
+        n < CALL_SITES_SIZE; ++n, h = (h + 1) & (CALL_SITES_SIZE - 1))
+    {
+        CallSite& cs = s_callSites[h];
+        quint64   k  = cs.key.load(std::memory_order_acquire);
+        if(k == 0)
+        {
+            if(cs.key.compare_exchange_strong(k, key,
+                                              std::memory_order_acq_rel))
+            {
+                cs.file = _file;
+                cs.line = _line;
+                k       = key;
+            }
+        }
+        if(k == key)
+        {
+            cs.count.fetch_add(1, std::memory_order_relaxed);
+            cs.bytes.fetch_add(_size, std::memory_order_relaxed);
+            return;
+        }
+    }
+    // table full, the site is not reported
+}
+
+// only the owner thread writes, no read-modify-write is needed
+template <typename T>
+static inline void increment(std::atomic<T>& _a, T _n)
+{
+    _a.store(_a.load(std::memory_order_relaxed) + _n,
+             std::memory_order_relaxed);
+}
+
+struct MemoryManagerArrayMagazines;
+static QMutex                                s_threadsMutex;
+static QVector<MemoryManagerArrayMagazines*> s_threads;
+
+// the magazines and the counts of the current thread. The magazines are
+// flushed and the counts added to the classes when the thread exits.
+struct MemoryManagerArrayMagazines
+{
+    MemoryManagerArray::Magazine m[16];
+    MemoryManagerArray::Stats    s[16];
+    int                          sample;
+
+    MemoryManagerArrayMagazines() : sample(1)
+    {
+        for(int i = 0; i < 16; i++)
+        {
+            m[i].count = 0;
+            s[i].allocs.store(0, std::memory_order_relaxed);
+            s[i].frees.store(0, std::memory_order_relaxed);
+            s[i].wasted.store(0, std::memory_order_relaxed);
+        }
+
+        QMutexLocker locker(&s_threadsMutex);
+        s_threads.append(this);
+    }
+
+    ~MemoryManagerArrayMagazines()
+    {
+        QMutexLocker locker(&s_threadsMutex);
+        s_threads.removeOne(this);
+        for(int i = 0; i < 16; i++)
+        {
+            MemoryManagerArray* a = MMA[i];
+            if(a == nullptr)
+                continue;
+            if(m[i].count > 0)
+                a->flush(m[i], m[i].count);
+            a->m_allocs.fetch_add(s[i].allocs.load());
+            a->m_frees.fetch_add(s[i].frees.load());
+            a->m_wasted.fetch_add(s[i].wasted.load());
+        }
+    }
+};
+
+static thread_local MemoryManagerArrayMagazines s_magazines;
+
 bool MemoryManagerArray::init()
 {
     s_active = false;
     for(int i = 0; i < 16; i++)
     {
         P2[i]  = 1 << i;
-        MMA[i] = new MemoryManagerArray(ASZ[i], P2[i]);
+        // the free list is stored in the elements, 8 bytes minimum
+        MMA[i] = new MemoryManagerArray(i, qMax(P2[i], 8), ASZ[i]);
     }
     int i = 0;
     int s = 1;
@@ -92,45 +238,13 @@ bool MemoryManagerArray::init()
 void MemoryManagerArray::cleanup()
 {
     s_active = false;
-    for(int i = 0; i < 16; i++)
-    {
-        MemoryManagerArray* old = MMA[i];
-
-        MMA[i] = nullptr;
-        delete old;
-    }
+    report();
+    // the slabs are kept: static objects and exiting threads may still
+    // release elements after this point
 }
 
 bool MemoryManagerArray::safe(size_t size, const char* file, long line)
 {
-    // qWarning("MemoryManagerArray::safe %lu %s:%ld",C2ULI size,file,line);
-
-    /*
-    if(s_active)
-    {
-            if(size<=   4) return !   S4.full();
-            if(size<=   8) return !   S8.full();
-            if(size<=  16) return !  S16.full();
-            if(size<=  32) return !  S32.full();
-            if(size<=  80) return !  S80.full();
-            if(size<= 112) return ! S112.full();
-            if(size<= 128) return ! S128.full();
-            if(size<= 192) return ! S192.full();
-            if(size<= 224) return ! S224.full();
-            if(size<= 264) return ! S264.full();
-            if(size<= 480) return ! S480.full();
-            if(size<= 496) return ! S496.full();
-            if(size<= 512) return ! S512.full();
-            if(size<= 552) return ! S552.full();
-            if(size<=1024) return !S1024.full();
-            if(size<=1056) return !S1056.full();
-            if(size<=1392) return !S1392.full();
-            if(size<=2048) return !S2048.full();
-            if(size<=2464) return !S2464.full();
-            if(size<=4128) return !S4128.full();
-    }
-    */
-
     return true;
 }
 
@@ -140,30 +254,9 @@ void* MemoryManagerArray::alloc(size_t size, const char* file, long line)
 
     if(s_active && size < 32768)
     {
-        int i = L2[size];
-        return MMA[i]->allocate(size, file, line);
-        /*
-        if(size<=   4) return    S4.allocate(size,file,line);
-        if(size<=   8) return    S8.allocate(size,file,line);
-        if(size<=  16) return   S16.allocate(size,file,line);
-        if(size<=  32) return   S32.allocate(size,file,line);
-        if(size<=  80) return   S80.allocate(size,file,line);
-        if(size<= 112) return  S112.allocate(size,file,line);
-        if(size<= 128) return  S128.allocate(size,file,line);
-        if(size<= 192) return  S192.allocate(size,file,line);
-        if(size<= 224) return  S224.allocate(size,file,line);
-        if(size<= 264) return  S264.allocate(size,file,line);
-        if(size<= 480) return  S480.allocate(size,file,line);
-        if(size<= 496) return  S496.allocate(size,file,line);
-        if(size<= 512) return  S512.allocate(size,file,line);
-        if(size<= 552) return  S552.allocate(size,file,line);
-        if(size<=1024) return S1024.allocate(size,file,line);
-        if(size<=1056) return S1056.allocate(size,file,line);
-        if(size<=1392) return S1392.allocate(size,file,line);
-        if(size<=2048) return S2048.allocate(size,file,line);
-        if(size<=2464) return S2464.allocate(size,file,line);
-        if(size<=4128) return S4128.allocate(size,file,line);
-        */
+        void* r = MMA[L2[size]]->allocate(size, file, line);
+        if(r != nullptr)
+            return r;
     }
 
     void* r = MMA_STD_ALLOC(size);
@@ -179,38 +272,18 @@ void MemoryManagerArray::free(void* ptr, const char* file, long line)
                  // handled
     }
 
-    for(int i = 0; i < 16; i++)
-        if(MMA[i] != nullptr && MMA[i]->deallocate(ptr, file, line))
-            return;
-
-    /*
-    if(!   S4.deallocate(ptr,file,line))
-    if(!   S8.deallocate(ptr,file,line))
-    if(!  S16.deallocate(ptr,file,line))
-    if(!  S32.deallocate(ptr,file,line))
-    if(!  S80.deallocate(ptr,file,line))
-    if(! S112.deallocate(ptr,file,line))
-    if(! S128.deallocate(ptr,file,line))
-    if(! S192.deallocate(ptr,file,line))
-    if(! S224.deallocate(ptr,file,line))
-    if(! S264.deallocate(ptr,file,line))
-    if(! S480.deallocate(ptr,file,line))
-    if(! S496.deallocate(ptr,file,line))
-    if(! S512.deallocate(ptr,file,line))
-    if(! S552.deallocate(ptr,file,line))
-    if(!S1024.deallocate(ptr,file,line))
-    if(!S1056.deallocate(ptr,file,line))
-    if(!S1392.deallocate(ptr,file,line))
-    if(!S2048.deallocate(ptr,file,line))
-    if(!S2464.deallocate(ptr,file,line))
-    if(!S4128.deallocate(ptr,file,line))
-    */
+    const int v = findSlab(ptr);
+    if(v >= 0)
     {
-        // if(s_active) qWarning("std free %p in %s#%ld",ptr,file,line);
-        MMA_STD_FREE(ptr);
+        MemoryManagerArray* mma = MMA[v >> 16];
+        if(mma != nullptr)
+            mma->deallocate(v & 0xFFFF, ptr, file, line);
+        return;
     }
-}
 
+    // if(s_active) qWarning("std free %p in %s#%ld",ptr,file,line);
+    MMA_STD_FREE(ptr);
+}
 void* MemoryManagerArray::alignedAlloc(size_t      size,
                                        const char* file,
                                        long        line)
@@ -250,195 +323,241 @@ void MemoryManagerArray::setActive(bool active)
     s_active = active;
 }
 
-MemoryManagerArray::MemoryManagerArray(const int    nbe,
+MemoryManagerArray::MemoryManagerArray(const int    sizeClass,
                                        const size_t size,
+                                       const int    prewarm,
                                        const char*  ref) :
-      m_mutex(),  // QMutex::Recursive),
-      m_nbe(nbe), m_size(size), m_data(nullptr), m_lastfree(0), m_count(0),
-      m_max(0), m_wasted(0), m_ref(ref), m_available(nbe, true)
+      m_class(sizeClass),
+      m_size(size), m_perSlab(SlabSize / size),
+      m_magazineSize(qBound(2, int(16384 / size), int(MaxMagazineSize))),
+      m_ref(ref), m_growMutex(), m_numSlabs(0), m_bump(0), m_head(0),
+      m_allocs(0), m_frees(0), m_wasted(0), m_refills(0), m_taken(0),
+      m_max(0)
 {
-    if(nbe > 32 * 1024)
-        qFatal("MemoryManagerArray: too big %d (32768 elements max)", nbe);
-    if(nbe * size > 32 * 1024 * 8192)
-        qFatal("MemoryManagerArray: too big %lu (268435456 bytes max)",
-               C2ULI(nbe * size));
-
-    m_data = (char*)MMA_STD_ALLOC(nbe * size);
-    // (char*)::calloc(nbe, size);
-    // memset(available,0xFF,sizeof(unsigned int)*1024);
+    if(size > SlabSize)
+        qFatal("MemoryManagerArray: too big %lu (%d bytes max)", C2ULI size,
+               SlabSize);
+
+    for(int s = 0; s < MaxSlabs; s++)
+        m_slabs[s] = nullptr;
+
+    // the pages are not touched before the elements are used
+    m_growMutex.lock();
+    do
+    {
+        if(!grow())
+            break;
+    } while(m_numSlabs.load() * m_perSlab < prewarm);
+    m_growMutex.unlock();
 }
 
 MemoryManagerArray::~MemoryManagerArray()
 {
-    qWarning(
-            "~MemoryManagerArray %8lu : cnt=%8d : max=%8lu %s wasted=%8lu %s",
-            C2ULI m_size, m_count, C2ULI m_max,
-            (char*)(m_nbe == m_max ? "!!!" : "   "), C2ULI m_wasted, m_ref);
-    MMA_STD_FREE(m_data);
-    //::free(m_data);
-    //::free(m_available);
-
-    QHashIterator<size_t, long> i(m_stats);
-    while(i.hasNext())
+    // slabs are never released, see cleanup()
+}
+
+bool MemoryManagerArray::grow()
+{
+    const int n = m_numSlabs.load(std::memory_order_relaxed);
+    if(n >= MaxSlabs)
+        return false;
+
+    char* slab = allocateSlab();
+    if(slab == nullptr)
+        return false;
+
+    if(!registerSlab(slab, (m_class << 16) | n))
     {
-        i.next();
-        qWarning(
-                "                    %8lu : bytes=%8lu cnt=%8ld"
-                "            %8ld",
-                C2ULI m_size, C2ULI i.key(), i.value(),
-                C2ULI(m_size - i.key()) * i.value());
+        qWarning("MemoryManagerArray: slab table is full");
+        return false;
     }
+
+    m_slabs[n] = slab;
+    m_numSlabs.store(n + 1, std::memory_order_release);
+    return true;
 }
 
-/*
-bool MemoryManagerArray::full()
+void MemoryManagerArray::push(int _index)
 {
-    m_mutex.lock();
-    bool r=m_count >= m_nbe;
-    m_mutex.unlock();
-    return r;
+    char*   e    = address(_index);
+    quint64 head = m_head.load(std::memory_order_acquire);
+    for(;;)
+    {
+        *reinterpret_cast<int*>(e) = int(head & 0xFFFFFFFFU) - 1;
+        const quint64 top = (((head >> 32) + 1) << 32) | quint64(_index + 1);
+        if(m_head.compare_exchange_weak(head, top, std::memory_order_release,
+                                        std::memory_order_acquire))
+            return;
+    }
 }
-*/
 
-void* MemoryManagerArray::allocate(size_t size, const char* file, long line)
+int MemoryManagerArray::pop()
 {
-    if(size > m_size)  //!=
+    quint64 head = m_head.load(std::memory_order_acquire);
+    for(;;)
     {
-        void* r = MMA_STD_ALLOC(size);
-        qWarning("invalid size %lu %p in %lu: %s#%ld", C2ULI size, r,
-                 C2ULI m_size, file, line);
-        return r;
+        const int index = int(head & 0xFFFFFFFFU) - 1;
+        if(index < 0)
+            return -1;
+
+        // may read an element in use when the CAS is going to fail,
+        // slabs are never released so the read is always valid
+        const int next = *reinterpret_cast<volatile int*>(address(index));
+        const quint64 top = (((head >> 32) + 1) << 32) | quint64(next + 1);
+        if(m_head.compare_exchange_weak(head, top, std::memory_order_acquire,
+                                        std::memory_order_acquire))
+            return index;
     }
+}
 
-    int i;
-    m_mutex.lock();
+int MemoryManagerArray::carve()
+{
+    const int index = m_bump.fetch_add(1, std::memory_order_relaxed);
+    if(index < m_numSlabs.load(std::memory_order_acquire) * m_perSlab)
+        return index;
 
-    if(m_count >= m_nbe)
+    // class exhausted, add slabs
+    QMutexLocker locker(&m_growMutex);
+    while(index >= m_numSlabs.load(std::memory_order_relaxed) * m_perSlab)
     {
-        m_mutex.unlock();
-        void* r = MMA_STD_ALLOC(size);
-        BACKTRACE
-        qWarning("block %lu full %d (asking %lu bytes): %s#%ld", C2ULI m_size,
-                 m_count, C2ULI size, file, line);
-        return r;
+        if(!grow())
+        {
+            qWarning("MemoryManagerArray: block %lu can not grow",
+                     C2ULI m_size);
+            return -1;
+        }
     }
+    return index;
+}
 
-    // development phase
-    if(size < m_size)
+void MemoryManagerArray::refill(Magazine& _m)
+{
+    m_refills.fetch_add(1, std::memory_order_relaxed);
+    const int n     = qMax(m_magazineSize / 2, 1);
+    const int start = _m.count;
+    while(_m.count < n)
     {
-        m_wasted += (m_size - size);
-        m_stats[size] += 1;
-        // qWarning("MemoryManagerArray::sup-allocate %lu %lu",C2ULI
-        // size,C2ULI m_size);
+        int index = pop();
+        if(index < 0)
+            index = carve();
+        if(index < 0)
+            break;
+        _m.items[_m.count++] = index;
     }
 
-    // development phase
-    if((m_count >= (m_nbe * 90l) / 100) && (m_nbe >= 100)
-       && ((m_count % (m_nbe / 100)) == 0))
-        qWarning("block %lu saturating %d (asking %lu bytes): %s#%ld",
-                 C2ULI m_size, m_count, C2ULI size, file, line);
+    // counted once per refill, not per allocation
+    const int got   = _m.count - start;
+    const int taken = m_taken.fetch_add(got, std::memory_order_relaxed) + got;
+    int       max   = m_max.load(std::memory_order_relaxed);
+    while(taken > max && !m_max.compare_exchange_weak(max, taken))
+        ;
+}
 
-    if((m_lastfree >= 0) && (m_lastfree < m_nbe)
-       && m_available.bit(m_lastfree))  // m_available[m_lastfree])
+void MemoryManagerArray::flush(Magazine& _m, int _n)
+{
+    int given = 0;
+    while(_n-- > 0 && _m.count > 0)
     {
-        i = m_lastfree;
-        m_available.unset(i);  // m_available[i]=false;
-        m_count++;
-        if(m_max < m_count)
-            m_max++;
-        m_lastfree = -1;
+        push(_m.items[--_m.count]);
+        ++given;
     }
-    else
+    m_taken.fetch_sub(given, std::memory_order_relaxed);
+}
+
+void* MemoryManagerArray::allocate(size_t size, const char* file, long line)
+{
+    if(size > m_size)  //!=
     {
-        i = m_available.nextSet(0);  // from start
-        if((i < 0) || (i >= m_nbe))
-            i = m_nbe;
-        else
-        {
-            m_available.unset(i);
-            m_count++;
-            if(m_max < m_count)
-                m_max++;
-        }
-        /*
-          for(i=0;i<m_nbe;i++)
-          if(m_available[i])
-          {
-           m_available[i]=false;
-           m_count++;
-           if(m_max<m_count) m_max++;
-           break;
-           }
-        */
+        qWarning("invalid size %lu in %lu: %s#%ld", C2ULI size, C2ULI m_size,
+                 file, line);
+        return nullptr;
     }
 
-    if((i + 1 < m_nbe) && m_available.bit(i + 1))  // m_available[i+1])
-        m_lastfree = i + 1;
-
-    m_mutex.unlock();
+    MemoryManagerArrayMagazines& t = s_magazines;
+    Magazine&                    m = t.m[m_class];
+    if(m.count == 0)
+        refill(m);
+    if(m.count == 0)
+        return nullptr;
 
-    if(i >= m_nbe)
+    increment(t.s[m_class].allocs, 1L);
+    increment(t.s[m_class].wasted, (long long)(m_size - size));
+    if(--t.sample <= 0)
     {
-        qWarning("block %lu suprizingly full %d %s#%ld", C2ULI m_size,
-                 m_count, file, line);
-        return MMA_STD_ALLOC(size);
+        t.sample = CALL_SITE_SAMPLING;
+        recordCallSite(file, line, size);
     }
 
-    // qWarning("allocate n°%d %d/%d in %ld
-    // %s#%ld",i,m_count,m_nbe,m_size,file,line);
-    return m_data + i * m_size;
+    return address(m.items[--m.count]);
 }
 
-bool MemoryManagerArray::deallocate(void* ptr, const char* file, long line)
+void MemoryManagerArray::deallocate(int         slab,
+                                    void*       ptr,
+                                    const char* file,
+                                    long        line)
 {
-    if((ptr < m_data) || (ptr >= m_data + m_nbe * m_size))
-    {
-        // qWarning("free pointer out %p",ptr);
-        // MMA_STD_FREE(ptr);
-        return false;
-    }
-
-    const size_t s = ((char*)ptr) - m_data;
+    const size_t s = ((char*)ptr) - m_slabs[slab];
     if((s % m_size) != 0)
     {
         BACKTRACE
         qCritical("error: MemoryManagerArray::free: invalid ptr %s#%ld", file,
                   line);
+        return;
     }
 
-    const int i = s / m_size;
-    m_mutex.lock();
-    if((i < 0) || (i >= m_nbe))
-    {
-        BACKTRACE
-        qCritical("error: i out of range: %d in %lu: %s#%ld", i, C2ULI m_size,
-                  file, line);
-    }
+    MemoryManagerArrayMagazines& t = s_magazines;
+    increment(t.s[m_class].frees, 1L);
 
-    if(m_available.bit(i))
-    {
-        BACKTRACE
-        qWarning("error: should be taken n°%d in %lu: %s#%ld", i,
-                 C2ULI m_size, file, line);
-        // BAD
-        m_available.set(i);
-        m_lastfree = i;
-        m_mutex.unlock();
-        return true;
-    }
+    Magazine& m = t.m[m_class];
+    if(m.count >= m_magazineSize)
+        flush(m, m_magazineSize / 2);
+    m.items[m.count++] = slab * m_perSlab + int(s / m_size);
+}
 
-    m_available.set(i);
-    m_lastfree = i;
-    m_count--;
-    if(m_count < 0)
+void MemoryManagerArray::report()
+{
+    qWarning("MemoryManagerArray report");
+    QMutexLocker locker(&s_threadsMutex);
+    for(int i = 0; i < 16; i++)
     {
-        BACKTRACE
-        qWarning("error: negative count in %lu: %s#%ld", C2ULI m_size, file,
-                 line);
-    }
-    m_mutex.unlock();
+        const MemoryManagerArray* a = MMA[i];
+        if(a == nullptr)
+            continue;
+
+        // the running threads and the ones which exited
+        long      allocs = a->m_allocs.load();
+        long      frees  = a->m_frees.load();
+        long long wasted = a->m_wasted.load();
+        for(const MemoryManagerArrayMagazines* t: s_threads)
+        {
+            allocs += t->s[i].allocs.load(std::memory_order_relaxed);
+            frees += t->s[i].frees.load(std::memory_order_relaxed);
+            wasted += t->s[i].wasted.load(std::memory_order_relaxed);
+        }
 
-    // qWarning("deallocate n°%d %d/%d in %lu %s#%ld",i,m_count,m_nbe,C2ULI
-    // m_size,file,line);
-    return true;
+        qWarning("  %8lu : cnt=%8ld max=%8d used=%8d slabs=%4d allocs=%10ld "
+                 "refills=%9ld wasted=%10lld %s",
+                 C2ULI a->m_size, allocs - frees, a->m_max.load(),
+                 qMin(a->m_bump.load(), a->m_numSlabs.load() * a->m_perSlab),
+                 a->m_numSlabs.load(), allocs, a->m_refills.load(), wasted,
+                 a->m_ref);
+    }
+    locker.unlock();
+
+    QVector<const CallSite*> sites;
+    for(int h = 0; h < CALL_SITES_SIZE; h++)
+        if(s_callSites[h].key.load() != 0 && s_callSites[h].file != nullptr)
+            sites.append(&s_callSites[h]);
+    std::sort(sites.begin(), sites.end(),
+              [](const CallSite* a, const CallSite* b) {
+                  return a->bytes.load() > b->bytes.load();
+              });
+
+    qWarning("  call sites: %d, estimated from 1 allocation out of %d",
+             sites.size(), CALL_SITE_SAMPLING);
+    for(int i = 0; i < qMin(sites.size(), 30); i++)
+        qWarning("  %12lld bytes %10ld allocs : %s#%ld",
+                 sites[i]->bytes.load() * CALL_SITE_SAMPLING,
+                 sites[i]->count.load() * CALL_SITE_SAMPLING,
+                 sites[i]->file, sites[i]->line);
 }
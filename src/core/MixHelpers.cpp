@@ -27,36 +27,70 @@
 #include "ValueBuffer.h"
 #include "lmms_math.h"  // REQUIRED
 
-namespace MixHelpers
-{
+#include <QtGlobal>
+
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+// The vector kernels rely on the GCC vector extensions and on
+// "#pragma GCC target". This file is compiled with -ffp-contract=off and
+// -fno-associative-math: fused or reordered operations would round
+// differently in the scalar and in the vector kernels.
+#if defined(__GNUC__) && !defined(__clang__) \
+        && (defined(__x86_64__) || defined(__i386__))
+#define MIXHELPERS_SIMD
+#endif
 
-/*! \brief Function for applying MIXOP on all sample frames */
-template <typename MIXOP>
-static inline void run(sampleFrame*       dst,
-                       const sampleFrame* src,
-                       int                frames,
-                       const MIXOP&       OP)
+namespace MixHelpers
 {
-    for(int i = 0; i < frames; ++i)
-    {
-        OP(dst[i], src[i]);
-    }
-}
 
-/*! \brief Function for applying MIXOP on all sample frames - split source */
-template <typename MIXOP>
-static inline void run(sampleFrame*    dst,
-                       const sample_t* srcLeft,
-                       const sample_t* srcRight,
-                       int             frames,
-                       const MIXOP&    OP)
-{
-    for(int i = 0; i < frames; ++i)
-    {
-        const sampleFrame src = {srcLeft[i], srcRight[i]};
-        OP(dst[i], src);
-    }
-}
+// integer of the size of a sample, for the lane masks
+typedef std::conditional<sizeof(sample_t) == 8, int64_t, int32_t>::type
+        mask_t;
+
+// one implementation of the kernels
+struct Kernels
+{
+    bool (*isClipping)(const sampleFrame*, const f_cnt_t);
+    bool (*sanitize)(sampleFrame*, const f_cnt_t);
+    bool (*unclip)(sampleFrame*, const f_cnt_t);
+    void (*add)(sampleFrame*, const sampleFrame*, int);
+    void (*addSanitized)(sampleFrame*, const sampleFrame*, f_cnt_t);
+    void (*addMultiplied)(sampleFrame*, const sampleFrame*, real_t, int);
+    void (*addMultipliedByValues)(sampleFrame*,
+                                  const sampleFrame*,
+                                  const real_t*,
+                                  f_cnt_t);
+    void (*addSwappedMultiplied)(sampleFrame*,
+                                 const sampleFrame*,
+                                 real_t,
+                                 int);
+    void (*addMultipliedByBuffer)(
+            sampleFrame*, const sampleFrame*, real_t, const real_t*, int);
+    void (*addMultipliedByBuffers)(sampleFrame*,
+                                   const sampleFrame*,
+                                   const real_t*,
+                                   const real_t*,
+                                   int);
+    void (*addSanitizedMultiplied)(sampleFrame*,
+                                   const sampleFrame*,
+                                   real_t,
+                                   int);
+    void (*addSanitizedMultipliedByBuffer)(
+            sampleFrame*, const sampleFrame*, real_t, const real_t*, int);
+    void (*addSanitizedMultipliedByBuffers)(sampleFrame*,
+                                            const sampleFrame*,
+                                            const real_t*,
+                                            const real_t*,
+                                            int);
+    void (*addMultipliedStereo)(
+            sampleFrame*, const sampleFrame*, real_t, real_t, int);
+    void (*multiplyAndAddMultiplied)(
+            sampleFrame*, const sampleFrame*, real_t, real_t, int);
+    void (*multiplyAndAddMultipliedJoined)(
+            sampleFrame*, const sample_t*, const sample_t*, real_t, real_t, int);
+};
 
 int16_t convertToS16(FLOAT _v)
 {
@@ -181,8 +215,41 @@ bool isSilent(const sampleFrame* _src, const f_cnt_t _frames)
     return true;
 }
 
+// reference implementation, also used for the frames left by the vector
+// kernels
+namespace Scalar
+{
+
+/*! \brief Function for applying MIXOP on all sample frames */
+template <typename MIXOP>
+static inline void run(sampleFrame*       dst,
+                       const sampleFrame* src,
+                       int                frames,
+                       const MIXOP&       OP)
+{
+    for(int i = 0; i < frames; ++i)
+    {
+        OP(dst[i], src[i]);
+    }
+}
+
+/*! \brief Function for applying MIXOP on all sample frames - split source */
+template <typename MIXOP>
+static inline void run(sampleFrame*    dst,
+                       const sample_t* srcLeft,
+                       const sample_t* srcRight,
+                       int             frames,
+                       const MIXOP&    OP)
+{
+    for(int i = 0; i < frames; ++i)
+    {
+        const sampleFrame src = {srcLeft[i], srcRight[i]};
+        OP(dst[i], src);
+    }
+}
+
 /*! \brief Function for detecting clipping - returns true if found */
-bool isClipping(const sampleFrame* _src, const f_cnt_t _frames)
+static bool isClipping(const sampleFrame* _src, const f_cnt_t _frames)
 {
     for(f_cnt_t f = _frames - 1; f >= 0; --f)
     {
@@ -194,7 +261,7 @@ bool isClipping(const sampleFrame* _src, const f_cnt_t _frames)
 
 /*! \brief Function for sanitizing a buffer of infs/nans - returns true if
  * modified */
-bool sanitize(sampleFrame* _src, const f_cnt_t _frames)
+static bool sanitize(sampleFrame* _src, const f_cnt_t _frames)
 {
     bool found = false;
     for(f_cnt_t f = _frames - 1; f >= 0; --f)
@@ -225,7 +292,7 @@ bool sanitize(sampleFrame* _src, const f_cnt_t _frames)
 }
 
 /*! \brief Function for unclipping a buffer - returns true if modified */
-bool unclip(sampleFrame* _src, const f_cnt_t _frames)
+static bool unclip(sampleFrame* _src, const f_cnt_t _frames)
 {
     bool found = false;
     for(f_cnt_t f = _frames - 1; f >= 0; --f)
@@ -255,16 +322,15 @@ bool unclip(sampleFrame* _src, const f_cnt_t _frames)
     return found;
 }
 
-void addMultiplied(sampleFrame*       _dst,
-                   const sampleFrame* _src,
-                   const ValueBuffer* _coeffSrcBuf,
-                   const f_cnt_t      _frames)
+static void addMultipliedByValues(sampleFrame*       _dst,
+                                         const sampleFrame* _src,
+                                         const real_t*      _coeffs,
+                                         f_cnt_t            _frames)
 {
-    // const real_t* const values = _coeffSrcBuf->values();
     for(f_cnt_t f = _frames - 1; f >= 0; --f)
     {
-        _dst[f][0] += _src[f][0] * _coeffSrcBuf->value(f);  // values[f];
-        _dst[f][1] += _src[f][1] * _coeffSrcBuf->value(f);  // values[f];
+        _dst[f][0] += _src[f][0] * _coeffs[f];
+        _dst[f][1] += _src[f][1] * _coeffs[f];
     }
 }
 
@@ -277,7 +343,7 @@ struct AddOp
     }
 };
 
-void add(sampleFrame* dst, const sampleFrame* src, int frames)
+static void add(sampleFrame* dst, const sampleFrame* src, int frames)
 {
     run<>(dst, src, frames, AddOp());
 }
@@ -297,10 +363,10 @@ struct AddMultipliedOp
     const real_t m_coeff;
 };
 
-void addMultiplied(sampleFrame*       dst,
-                   const sampleFrame* src,
-                   real_t             coeffSrc,
-                   int                frames)
+static void addMultiplied(sampleFrame*       dst,
+                          const sampleFrame* src,
+                          real_t             coeffSrc,
+                          int                frames)
 {
     run<>(dst, src, frames, AddMultipliedOp(coeffSrc));
 }
@@ -320,48 +386,45 @@ struct AddSwappedMultipliedOp
     const real_t m_coeff;
 };
 
-void addSwappedMultiplied(sampleFrame*       dst,
-                          const sampleFrame* src,
-                          real_t             coeffSrc,
-                          int                frames)
+static void addSwappedMultiplied(sampleFrame*       dst,
+                                 const sampleFrame* src,
+                                 real_t             coeffSrc,
+                                 int                frames)
 {
     run<>(dst, src, frames, AddSwappedMultipliedOp(coeffSrc));
 }
 
-void addMultipliedByBuffer(sampleFrame*       dst,
-                           const sampleFrame* src,
-                           real_t             coeffSrc,
-                           const ValueBuffer* coeffSrcBuf,
-                           int                frames)
+static void addMultipliedByBuffer(sampleFrame*       dst,
+                                         const sampleFrame* src,
+                                         real_t             coeffSrc,
+                                         const real_t*      coeffs,
+                                         int                frames)
 {
-    // const real_t* const values = coeffSrcBuf->values();
     for(int f = 0; f < frames; ++f)
     {
-        const real_t c = coeffSrc * coeffSrcBuf->value(f);  // s[f];
+        const real_t c = coeffSrc * coeffs[f];
         dst[f][0] += src[f][0] * c;
         dst[f][1] += src[f][1] * c;
     }
 }
 
-void addMultipliedByBuffers(sampleFrame*       dst,
-                            const sampleFrame* src,
-                            const ValueBuffer* coeffSrcBuf1,
-                            const ValueBuffer* coeffSrcBuf2,
-                            int                frames)
+static void addMultipliedByBuffers(sampleFrame*       dst,
+                                          const sampleFrame* src,
+                                          const real_t*      coeffs1,
+                                          const real_t*      coeffs2,
+                                          int                frames)
 {
-    // const real_t* const values = _coeffSrcBuf->values();
     for(int f = 0; f < frames; ++f)
     {
-        const real_t c = coeffSrcBuf1->value(f)     // s()[f]
-                         * coeffSrcBuf2->value(f);  // s()[f];
+        const real_t c = coeffs1[f] * coeffs2[f];
         dst[f][0] += src[f][0] * c;
         dst[f][1] += src[f][1] * c;
     }
 }
 
-void addSanitized(sampleFrame*       _dst,
-                  const sampleFrame* _src,
-                  const f_cnt_t      _frames)
+static void addSanitized(sampleFrame*       _dst,
+                         const sampleFrame* _src,
+                         const f_cnt_t      _frames)
 {
     for(f_cnt_t f = 0; f < _frames; ++f)
     {
@@ -372,15 +435,15 @@ void addSanitized(sampleFrame*       _dst,
     }
 }
 
-void addSanitizedMultipliedByBuffer(sampleFrame*       dst,
-                                    const sampleFrame* src,
-                                    real_t             coeffSrc,
-                                    const ValueBuffer* coeffSrcBuf,
-                                    int                frames)
+static void addSanitizedMultipliedByBuffer(sampleFrame*       dst,
+                                                  const sampleFrame* src,
+                                                  real_t             coeffSrc,
+                                                  const real_t*      coeffs,
+                                                  int                frames)
 {
     for(int f = 0; f < frames; ++f)
     {
-        const real_t c = coeffSrc * coeffSrcBuf->value(f);  // s[f];
+        const real_t c = coeffSrc * coeffs[f];
         dst[f][0] += (isinf(src[f][0]) || isnan(src[f][0])) ? 0.
                                                             : src[f][0] * c;
         dst[f][1] += (isinf(src[f][1]) || isnan(src[f][1])) ? 0.
@@ -388,16 +451,15 @@ void addSanitizedMultipliedByBuffer(sampleFrame*       dst,
     }
 }
 
-void addSanitizedMultipliedByBuffers(sampleFrame*       dst,
-                                     const sampleFrame* src,
-                                     const ValueBuffer* coeffSrcBuf1,
-                                     const ValueBuffer* coeffSrcBuf2,
-                                     int                frames)
+static void addSanitizedMultipliedByBuffers(sampleFrame*       dst,
+                                                   const sampleFrame* src,
+                                                   const real_t*      coeffs1,
+                                                   const real_t*      coeffs2,
+                                                   int                frames)
 {
     for(int f = 0; f < frames; ++f)
     {
-        const real_t c = coeffSrcBuf1->value(f)     // s()[f]
-                         * coeffSrcBuf2->value(f);  // s()[f];
+        const real_t c = coeffs1[f] * coeffs2[f];
         dst[f][0] += (isinf(src[f][0]) || isnan(src[f][0])) ? 0.
                                                             : src[f][0] * c;
         dst[f][1] += (isinf(src[f][1]) || isnan(src[f][1])) ? 0.
@@ -420,10 +482,10 @@ struct AddSanitizedMultipliedOp
     const real_t m_coeff;
 };
 
-void addSanitizedMultiplied(sampleFrame*       dst,
-                            const sampleFrame* src,
-                            real_t             coeffSrc,
-                            int                frames)
+static void addSanitizedMultiplied(sampleFrame*       dst,
+                                   const sampleFrame* src,
+                                   real_t             coeffSrc,
+                                   int                frames)
 {
     run<>(dst, src, frames, AddSanitizedMultipliedOp(coeffSrc));
 }
@@ -445,11 +507,11 @@ struct AddMultipliedStereoOp
     real_t m_coeffs[2];
 };
 
-void addMultipliedStereo(sampleFrame*       dst,
-                         const sampleFrame* src,
-                         real_t             coeffSrcLeft,
-                         real_t             coeffSrcRight,
-                         int                frames)
+static void addMultipliedStereo(sampleFrame*       dst,
+                                const sampleFrame* src,
+                                real_t             coeffSrcLeft,
+                                real_t             coeffSrcRight,
+                                int                frames)
 {
 
     run<>(dst, src, frames,
@@ -473,13 +535,285 @@ struct MultiplyAndAddMultipliedOp
     real_t m_coeffs[2];
 };
 
+static void multiplyAndAddMultiplied(sampleFrame*       dst,
+                                     const sampleFrame* src,
+                                     real_t             coeffDst,
+                                     real_t             coeffSrc,
+                                     int                frames)
+{
+    run<>(dst, src, frames, MultiplyAndAddMultipliedOp(coeffDst, coeffSrc));
+}
+
+static void multiplyAndAddMultipliedJoined(sampleFrame*    dst,
+                                           const sample_t* srcLeft,
+                                           const sample_t* srcRight,
+                                           real_t          coeffDst,
+                                           real_t          coeffSrc,
+                                           int             frames)
+{
+    run<>(dst, srcLeft, srcRight, frames,
+          MultiplyAndAddMultipliedOp(coeffDst, coeffSrc));
+}
+
+static const Kernels KERNELS = {isClipping,
+                                sanitize,
+                                unclip,
+                                add,
+                                addSanitized,
+                                addMultiplied,
+                                addMultipliedByValues,
+                                addSwappedMultiplied,
+                                addMultipliedByBuffer,
+                                addMultipliedByBuffers,
+                                addSanitizedMultiplied,
+                                addSanitizedMultipliedByBuffer,
+                                addSanitizedMultipliedByBuffers,
+                                addMultipliedStereo,
+                                multiplyAndAddMultiplied,
+                                multiplyAndAddMultipliedJoined};
+
+}  // namespace Scalar
+
+#ifdef MIXHELPERS_SIMD
+
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#define MIXHELPERS_ISA SSE2
+#define MIXHELPERS_LANES (16 / sizeof(sample_t))
+#include "MixHelpersKernels.h"
+#undef MIXHELPERS_LANES
+#undef MIXHELPERS_ISA
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#define MIXHELPERS_ISA AVX2
+#define MIXHELPERS_LANES (32 / sizeof(sample_t))
+#include "MixHelpersKernels.h"
+#undef MIXHELPERS_LANES
+#undef MIXHELPERS_ISA
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#define MIXHELPERS_ISA AVX512
+#define MIXHELPERS_LANES (64 / sizeof(sample_t))
+#include "MixHelpersKernels.h"
+#undef MIXHELPERS_LANES
+#undef MIXHELPERS_ISA
+#pragma GCC pop_options
+
+#endif
+
+static const Kernels* s_kernels = &Scalar::KERNELS;
+static Isa            s_isa     = Isa_Scalar;
+
+static Isa bestIsa()
+{
+    for(int i = Isa_AVX512; i > Isa_Scalar; --i)
+        if(isaSupported(Isa(i)))
+            return Isa(i);
+    return Isa_Scalar;
+}
+
+// selected once at startup
+static const bool s_isaSelected = setIsa(bestIsa());
+
+Isa isa()
+{
+    return s_isa;
+}
+
+const char* isaName(Isa _isa)
+{
+    switch(_isa)
+    {
+        case Isa_Scalar:
+            return "scalar";
+        case Isa_SSE2:
+            return "sse2";
+        case Isa_AVX2:
+            return "avx2";
+        case Isa_AVX512:
+            return "avx512";
+    }
+    return "unknown";
+}
+
+bool isaSupported(Isa _isa)
+{
+    if(_isa == Isa_Scalar)
+        return true;
+
+#ifdef MIXHELPERS_SIMD
+    // may be called by a static constructor
+    __builtin_cpu_init();
+    switch(_isa)
+    {
+        case Isa_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case Isa_AVX2:
+            return __builtin_cpu_supports("avx2");
+        case Isa_AVX512:
+            return __builtin_cpu_supports("avx512f");
+        default:
+            break;
+    }
+#endif
+    return false;
+}
+
+bool setIsa(Isa _isa)
+{
+    if(!isaSupported(_isa))
+        return false;
+
+    switch(_isa)
+    {
+#ifdef MIXHELPERS_SIMD
+        case Isa_SSE2:
+            s_kernels = &SSE2::KERNELS;
+            break;
+        case Isa_AVX2:
+            s_kernels = &AVX2::KERNELS;
+            break;
+        case Isa_AVX512:
+            s_kernels = &AVX512::KERNELS;
+            break;
+#endif
+        default:
+            s_kernels = &Scalar::KERNELS;
+            break;
+    }
+    s_isa = _isa;
+    return true;
+}
+
+bool isClipping(const sampleFrame* _src, const f_cnt_t _frames)
+{
+    return s_kernels->isClipping(_src, _frames);
+}
+
+bool sanitize(sampleFrame* _src, const f_cnt_t _frames)
+{
+    return s_kernels->sanitize(_src, _frames);
+}
+
+bool unclip(sampleFrame* _src, const f_cnt_t _frames)
+{
+    return s_kernels->unclip(_src, _frames);
+}
+
+void addMultiplied(sampleFrame*       _dst,
+                   const sampleFrame* _src,
+                   const ValueBuffer* _coeffSrcBuf,
+                   const f_cnt_t      _frames)
+{
+    Q_ASSERT(_frames <= _coeffSrcBuf->length());
+    s_kernels->addMultipliedByValues(_dst, _src, _coeffSrcBuf->values(),
+                                     _frames);
+}
+
+void add(sampleFrame* dst, const sampleFrame* src, int frames)
+{
+    s_kernels->add(dst, src, frames);
+}
+
+void addSanitized(sampleFrame*       _dst,
+                  const sampleFrame* _src,
+                  const f_cnt_t      _frames)
+{
+    s_kernels->addSanitized(_dst, _src, _frames);
+}
+
+void addMultiplied(sampleFrame*       dst,
+                   const sampleFrame* src,
+                   real_t             coeffSrc,
+                   int                frames)
+{
+    s_kernels->addMultiplied(dst, src, coeffSrc, frames);
+}
+
+void addSwappedMultiplied(sampleFrame*       dst,
+                          const sampleFrame* src,
+                          real_t             coeffSrc,
+                          int                frames)
+{
+    s_kernels->addSwappedMultiplied(dst, src, coeffSrc, frames);
+}
+
+void addMultipliedByBuffer(sampleFrame*       dst,
+                           const sampleFrame* src,
+                           real_t             coeffSrc,
+                           const ValueBuffer* coeffSrcBuf,
+                           int                frames)
+{
+    Q_ASSERT(frames <= coeffSrcBuf->length());
+    s_kernels->addMultipliedByBuffer(dst, src, coeffSrc,
+                                     coeffSrcBuf->values(), frames);
+}
+
+void addMultipliedByBuffers(sampleFrame*       dst,
+                            const sampleFrame* src,
+                            const ValueBuffer* coeffSrcBuf1,
+                            const ValueBuffer* coeffSrcBuf2,
+                            int                frames)
+{
+    Q_ASSERT(frames <= coeffSrcBuf1->length());
+    Q_ASSERT(frames <= coeffSrcBuf2->length());
+    s_kernels->addMultipliedByBuffers(dst, src, coeffSrcBuf1->values(),
+                                      coeffSrcBuf2->values(), frames);
+}
+
+void addSanitizedMultiplied(sampleFrame*       dst,
+                            const sampleFrame* src,
+                            real_t             coeffSrc,
+                            int                frames)
+{
+    s_kernels->addSanitizedMultiplied(dst, src, coeffSrc, frames);
+}
+
+void addSanitizedMultipliedByBuffer(sampleFrame*       dst,
+                                    const sampleFrame* src,
+                                    real_t             coeffSrc,
+                                    const ValueBuffer* coeffSrcBuf,
+                                    int                frames)
+{
+    Q_ASSERT(frames <= coeffSrcBuf->length());
+    s_kernels->addSanitizedMultipliedByBuffer(dst, src, coeffSrc,
+                                              coeffSrcBuf->values(), frames);
+}
+
+void addSanitizedMultipliedByBuffers(sampleFrame*       dst,
+                                     const sampleFrame* src,
+                                     const ValueBuffer* coeffSrcBuf1,
+                                     const ValueBuffer* coeffSrcBuf2,
+                                     int                frames)
+{
+    Q_ASSERT(frames <= coeffSrcBuf1->length());
+    Q_ASSERT(frames <= coeffSrcBuf2->length());
+    s_kernels->addSanitizedMultipliedByBuffers(
+            dst, src, coeffSrcBuf1->values(), coeffSrcBuf2->values(), frames);
+}
+
+void addMultipliedStereo(sampleFrame*       dst,
+                         const sampleFrame* src,
+                         real_t             coeffSrcLeft,
+                         real_t             coeffSrcRight,
+                         int                frames)
+{
+    s_kernels->addMultipliedStereo(dst, src, coeffSrcLeft, coeffSrcRight,
+                                   frames);
+}
+
 void multiplyAndAddMultiplied(sampleFrame*       dst,
                               const sampleFrame* src,
                               real_t             coeffDst,
                               real_t             coeffSrc,
                               int                frames)
 {
-    run<>(dst, src, frames, MultiplyAndAddMultipliedOp(coeffDst, coeffSrc));
+    s_kernels->multiplyAndAddMultiplied(dst, src, coeffDst, coeffSrc,
+                                        frames);
 }
 
 void multiplyAndAddMultipliedJoined(sampleFrame*    dst,
@@ -489,8 +823,8 @@ void multiplyAndAddMultipliedJoined(sampleFrame*    dst,
                                     real_t          coeffSrc,
                                     int             frames)
 {
-    run<>(dst, srcLeft, srcRight, frames,
-          MultiplyAndAddMultipliedOp(coeffDst, coeffSrc));
+    s_kernels->multiplyAndAddMultipliedJoined(dst, srcLeft, srcRight,
+                                              coeffDst, coeffSrc, frames);
 }
 
 }  // namespace MixHelpers
@@ -75,6 +75,13 @@
 
 static __thread bool s_renderingThread;
 
+// capacity of the registries of the mixer, from the settings
+static int maxPlayHandles()
+{
+    return qMax(int(PlayHandle::MaxNumber) * 4,
+                CONFIG_GET_INT("mixer.maxplayhandles"));
+}
+
 Mixer::Mixer(bool renderOnly) :
       m_renderOnly(renderOnly), m_audioPorts(true),
       m_framesPerPeriod(DEFAULT_BUFFER_SIZE),
@@ -82,8 +89,12 @@ Mixer::Mixer(bool renderOnly) :
       m_inputBufferRead(0), m_inputBufferWrite(1), m_readBuf(nullptr),
       m_writeBuf(nullptr), m_displayRing(nullptr), m_workers(),
       m_numWorkers(QThread::idealThreadCount() * 2 - 1),  // tmp GDX
-      m_playHandles(true), m_playHandlesToAdd(true),
-      m_playHandlesToRemove(true),
+      m_playHandles(PlayHandle::MixerHook, maxPlayHandles()),
+      m_playHandlesToAdd(PlayHandle::MixerToAddHook, maxPlayHandles()),
+      // the handles which could not be added are removed too
+      m_playHandlesToRemove(PlayHandle::MixerToRemoveHook,
+                            maxPlayHandles() * 2),
+      m_newPlayHandles(maxPlayHandles()),
       m_qualitySettings(qualitySettings::Mode_Draft), m_masterVolumeGain(1.),
       m_masterPanningGain(0.), m_isProcessing(false), m_audioDev(nullptr),
       m_oldAudioDev(nullptr), m_audioDevStartFailed(false),
@@ -176,6 +187,8 @@ Mixer::~Mixer()
     m_handleManager->wait(500);
     delete m_handleManager;
     m_handleManager = nullptr;
+    // the removals handled in the last events
+    deleteRemovedPlayHandles1();
 
     qInfo("Mixer::~Mixer 2");
 
@@ -228,6 +241,8 @@ Mixer::~Mixer()
     if(m_displayRing != nullptr)
         delete m_displayRing;
 
+    BufferManager::cleanup();
+
     qInfo("Mixer::~Mixer 6");
 }
 
@@ -545,15 +560,28 @@ const surroundSampleFrame* Mixer::renderNextBuffer()
 
     requestChangeInModel();
 
+    // take the handles created by the song and by the other threads
+    // since the last period
+    addNewPlayHandles();
+
     // add all play-handles that have to be added
     // while(!m_playHandlesToAdd.isEmpty())
     //   m_playHandles.append(m_playHandlesToAdd.takeLast());
     m_playHandlesToAdd.map(
             [this](PlayHandlePointer ph) {
-                if(!ph->isFinished())
-                    this->m_playHandles.appendUnique(ph);
-                else
+                if(ph->isFinished())
+                {
+                    this->m_playHandlesToRemove.appendUnique(ph);
+                }
+                else if(!this->m_playHandles.appendUnique(ph))
+                {
+                    // full, finished like the handles the queue drops
+                    qWarning("Mixer: play handles full (%d), handle "
+                             "type=%d dropped",
+                             this->m_playHandles.capacity(), ph->type());
+                    ph->setFinished();
                     this->m_playHandlesToRemove.appendUnique(ph);
+                }
             },
             true);
 
@@ -581,11 +609,9 @@ const surroundSampleFrame* Mixer::renderNextBuffer()
 
     // doneChangeInModel();
 
-    // STAGE 1: run and render all play handles
-    MixerWorkerThread::fillJobQueue<PlayHandlePointer>(m_playHandles);
-    MixerWorkerThread::startAndWaitForJobs();
-
-    // requestChangeInModel();
+    // STAGE 1: run and render all play handles, process the effects of
+    // the audio ports and mix the fx channels in a single job graph
+    processJobGraph();
 
     // removed all play handles which are done
     m_playHandles.map([this](PlayHandlePointer ph) {
@@ -609,16 +635,9 @@ const surroundSampleFrame* Mixer::renderNextBuffer()
             },
             true);
 
-    // doneChangeInModel();
-    // requestChangeInModel();
-
-    // STAGE 2: process effects of all instrument- and sampletracks
-    MixerWorkerThread::fillJobQueue<AudioPortPointer>(m_audioPorts);
-    MixerWorkerThread::startAndWaitForJobs();
-
     doneChangeInModel();
 
-    // STAGE 3: do master mix in FX mixer
+    // STAGE 2: do master mix in FX mixer
     fxMixer->masterMix(m_writeBuf);
 
     /*
@@ -653,6 +672,76 @@ const surroundSampleFrame* Mixer::renderNextBuffer()
     return m_readBuf;
 }
 
+void Mixer::processJobGraph()
+{
+    // play handle -> audio port -> fx channel -> sends -> master
+    // A job is queued as soon as all its inputs are done: the effects of
+    // a port start when its own handles are rendered and a channel starts
+    // when its ports and senders are processed. There is no barrier
+    // between the stages anymore.
+    FxMixer* fxMixer = Engine::fxMixer();
+
+    // the handle manager does not delete any handle of the snapshot
+    // before the end of the period
+    PlayHandleRegistry::ReadSection section(m_playHandles);
+
+    m_graphHandles.resize(0);
+    m_graphPorts.resize(0);
+    m_playHandles.map(
+            [this](PlayHandlePointer ph) { m_graphHandles.append(ph); });
+    m_audioPorts.map(
+            [this](AudioPortPointer ap) { m_graphPorts.append(ap); });
+
+    // every port and channel gets one extra dependency, released once the
+    // whole graph is known, so nothing starts with a partial count
+    fxMixer->prepareGraph();
+    for(AudioPortPointer& ap: m_graphPorts)
+    {
+        ap->setDependencies(1);
+        ap->updateLatency();
+        fxMixer->addGraphInput(ap.data(), ap->nextFxChannel(),
+                               ap->latency());
+    }
+
+    // delay compensation, set before any job starts
+    fxMixer->updateLatencies();
+    for(AudioPortPointer& ap: m_graphPorts)
+        ap->setCompensation(fxMixer->inputLatency(ap->nextFxChannel())
+                            - ap->latency());
+
+    for(PlayHandlePointer& ph: m_graphHandles)
+    {
+        // ports added after the snapshot are not waiting for anything
+        AudioPort* ap = ph->mixingPort();
+        if(ap != nullptr && ap->hasPendingDependencies())
+        {
+            ap->addDependency();
+            ph->setDependent(ap);
+        }
+        else
+        {
+            ph->setDependent(nullptr);
+        }
+    }
+
+    MixerWorkerThread::resetJobQueue(MixerWorkerThread::JobQueue::Dynamic);
+    // sized before any job is queued, so the deques do not grow while
+    // the period is rendered
+    MixerWorkerThread::reserveJobs(m_graphHandles.size() + m_graphPorts.size()
+                                   + fxMixer->numChannels());
+    for(PlayHandlePointer& ph: m_graphHandles)
+        MixerWorkerThread::addJob(ph.data());
+    for(AudioPortPointer& ap: m_graphPorts)
+        if(ap->dependencyDone())
+            MixerWorkerThread::addJob(ap.data());
+    fxMixer->releaseGraph();
+
+    MixerWorkerThread::startAndWaitForJobs();
+
+    m_graphHandles.resize(0);
+    m_graphPorts.resize(0);
+}
+
 void Mixer::clear()
 {
     // qInfo("Mixer::clear");
@@ -907,7 +996,7 @@ void Mixer::addPlayHandle1(PlayHandlePointer _ph)
         return;  // false;
     }
 
-    if(QThread::currentThread() != m_handleManager)
+    if(QThread::currentThread() != m_handleManager && !s_renderingThread)
     {
         // BACKTRACE
         qWarning("Warning: %s#%d: addPlayHandle wrong thread (NOT HM)",
@@ -940,15 +1029,79 @@ void Mixer::addPlayHandle1(PlayHandlePointer _ph)
         {
             qWarning("Mixer::addPlayHandleInternal ph already in");
         }
-        else
+        else if(!m_playHandlesToAdd.insert(_ph.data()))
         {
-            m_playHandlesToAdd.appendUnique(_ph);
+            // full, the handle is removed rather than left behind
+            qWarning("Mixer::addPlayHandle queue full (%d), handle type=%d "
+                     "dropped",
+                     m_playHandlesToAdd.capacity(), _ph->type());
+            _ph->setFinished();
         }
     }
 
     // doneChangeInModel();
 }
 
+bool Mixer::isRenderingThread()
+{
+    return s_renderingThread;
+}
+
+void Mixer::addPlayHandle(PlayHandlePointer _ph)
+{
+    if(_ph.isNull())
+    {
+        BACKTRACE
+        qWarning("Mixer::addPlayHandle(nullptr)");
+        return;
+    }
+
+    _ph->setHandedOff();
+    if(!m_newPlayHandles.tryPush(_ph.data()))
+    {
+        // queue full, take the slow path
+        bool removal = _ph->takeHandedOff();
+        emit playHandleToAdd(_ph);
+        if(removal)
+            emit playHandleToRemove(_ph);
+    }
+}
+
+// called by the rendering thread only
+void Mixer::addNewPlayHandles()
+{
+    LocklessList<PlayHandle*>::Element* e = m_newPlayHandles.popList();
+
+    // the list is a stack, reverse it to keep the order of the notes
+    LocklessList<PlayHandle*>::Element* first = nullptr;
+    while(e != nullptr)
+    {
+        LocklessList<PlayHandle*>::Element* next = e->next;
+        e->next = first;
+        first   = e;
+        e       = next;
+    }
+
+    while(first != nullptr)
+    {
+        LocklessList<PlayHandle*>::Element* next = first->next;
+        PlayHandle*                         ph   = first->value;
+        m_newPlayHandles.free(first);
+        first = next;
+
+        if(ph->takeHandedOff())
+        {
+            // finished while waiting in the queue, the handle manager
+            // skipped it: request the removal again
+            emit playHandleToRemove(ph->pointer());
+        }
+        else
+        {
+            addPlayHandle1(ph->pointer());
+        }
+    }
+}
+
 void Mixer::removePlayHandle1(PlayHandlePointer _ph)
 {
     if(_ph.isNull())  // == nullptr)
@@ -958,6 +1111,13 @@ void Mixer::removePlayHandle1(PlayHandlePointer _ph)
         return;
     }
 
+    if(_ph->deferRemoval())
+    {
+        // still in the queue of new handles, addNewPlayHandles() will
+        // emit the removal again
+        return;
+    }
+
     if(!_ph->isFinished())
     {
         qWarning("Mixer::removePlayHandle ph not finished");
@@ -1050,12 +1210,32 @@ void Mixer::deletePlayHandle1(PlayHandlePointer _ph)
     if(_ph->type() != 1 && _ph->type() != 4)
         qInfo("... after ph->exitMixer() type=%d", _ph->type());
 
-    // if(bx1 + bx2 + bx3 > 0)
-    {
-        if(_ph->type() == PlayHandle::TypeNotePlayHandle)
+    // the handles removed by the queued removals are deleted together
+    if(m_playHandlesToDelete.isEmpty())
+        QMetaObject::invokeMethod(m_handleManager,
+                                  "deleteRemovedPlayHandlesHM",
+                                  Qt::QueuedConnection);
+    if(!m_playHandlesToDelete.contains(_ph))
+        m_playHandlesToDelete.append(_ph);
+}
+
+void Mixer::deleteRemovedPlayHandles1()
+{
+    // wait once for the readers which may still see the handles. The
+    // audio ports mix their handles inside the read section of the
+    // period, so this covers their registries too.
+    m_playHandles.synchronize();
+    m_playHandlesToAdd.synchronize();
+    m_playHandlesToRemove.synchronize();
+
+    QVector<PlayHandlePointer> handles;
+    handles.swap(m_playHandlesToDelete);
+    for(PlayHandlePointer& ph: handles)
+    {
+        if(ph->type() == PlayHandle::TypeNotePlayHandle)
         {
             // TMP
-            NotePlayHandle* nph = dynamic_cast<NotePlayHandle*>(_ph.data());
+            NotePlayHandle* nph = dynamic_cast<NotePlayHandle*>(ph.data());
             if(nph == nullptr)
             {
                 BACKTRACE
@@ -1064,35 +1244,35 @@ void Mixer::deletePlayHandle1(PlayHandlePointer _ph)
             else
             {
                 NotePlayHandleManager::release(nph);
-                emit playHandleDeleted(_ph);
-                _ph.clear();
+                emit playHandleDeleted(ph);
+                ph.clear();
             }
         }
         else
         {
-            if(s_deleteTracker.contains(_ph->m_debug_uuid))
+            if(s_deleteTracker.contains(ph->m_debug_uuid))
             {
                 BACKTRACE
                 qCritical(
                         "Mixer::deletePlayHandleInternal %p was "
                         "already released (%s)",
-                        _ph.data(), typeid(_ph).name());
-                return;
+                        ph.data(), typeid(ph).name());
+                continue;
             }
-            s_deleteTracker.insert(_ph->m_debug_uuid, true);
+            s_deleteTracker.insert(ph->m_debug_uuid, true);
 
-            if(_ph->type() == 2)
+            if(ph->type() == 2)
                 qInfo("   deleting IPH");
-            // if(_ph->type() == 4)
+            // if(ph->type() == 4)
             //    qInfo("   deleting SPH");
-            if(_ph->type() == 8)
+            if(ph->type() == 8)
                 qInfo("   deleting PPH");
-            // DELETE_HELPER(_ph);
-            emit playHandleDeleted(_ph);
+            // DELETE_HELPER(ph);
+            emit playHandleDeleted(ph);
             QCoreApplication::sendPostedEvents();
             // QThread::yieldCurrentThread();
-            delete _ph.data();
-            _ph.clear();
+            delete ph.data();
+            ph.clear();
         }
     }
     // else qWarning("Mixer::deletePlayHandle1 nph not found in lists");
@@ -1921,3 +2101,11 @@ void HandleManager::removeAllPlayHandlesHM()
 
     m_mixer->removeAllPlayHandles1();
 }
+
+void HandleManager::deleteRemovedPlayHandlesHM()
+{
+    if(QThread::currentThread() != this)
+        qInfo("HandleManager::deleteRemovedPlayHandlesHM STRANGE");
+
+    m_mixer->deleteRemovedPlayHandles1();
+}
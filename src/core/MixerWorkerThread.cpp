@@ -24,32 +24,188 @@
 
 #include "MixerWorkerThread.h"
 
+#include "Configuration.h"
 #include "Mixer.h"
 #include "ThreadableJob.h"
 #include "denormals.h"
 #include "Backtrace.h"
+#include "lmmsconfig.h"
 
 #include <QMutex>
 #include <QWaitCondition>
 
+#ifdef LMMS_HAVE_SCHED_H
+#include <sched.h>
+#endif
+
 MixerWorkerThread::JobQueue MixerWorkerThread::s_globalJobQueue;
 QWaitCondition*             MixerWorkerThread::s_queueReadyWaitCond = nullptr;
 SafeList<MixerWorkerThread*> MixerWorkerThread::s_workerThreads;
 
+// index of the deque owned by the current thread, 0 for non-workers
+static __thread int s_dequeIndex = 0;
+
+static inline void cpuRelax()
+{
+#if defined(LMMS_HOST_X86) || defined(LMMS_HOST_X86_64)
+    asm("pause");
+#endif
+}
+
+// implementation of the work-stealing deque
+MixerWorkerThread::JobDeque::Array::Array(long _size) :
+      m_size(_size), m_mask(_size - 1),
+      m_items(new std::atomic<ThreadableJob*>[_size])
+{
+    for(long i = 0; i < m_size; ++i)
+        m_items[i].store(nullptr, std::memory_order_relaxed);
+}
+
+MixerWorkerThread::JobDeque::Array::~Array()
+{
+    delete[] m_items;
+}
+
+MixerWorkerThread::JobDeque::JobDeque(int _capacity) :
+      m_top(0), m_bottom(0), m_array(nullptr)
+{
+    long size = 1;
+    while(size < _capacity)
+        size <<= 1;
+    m_array.store(new Array(size), std::memory_order_relaxed);
+}
+
+MixerWorkerThread::JobDeque::~JobDeque()
+{
+    delete m_array.load(std::memory_order_relaxed);
+    for(Array* a: m_retired)
+        delete a;
+}
+
+MixerWorkerThread::JobDeque::Array* MixerWorkerThread::JobDeque::resize(
+        Array* _a, long _top, long _bottom, long _size)
+{
+    Array* r = new Array(_size);
+    for(long i = _top; i < _bottom; ++i)
+        r->put(i, _a->get(i));
+    m_retired.append(_a);
+    m_array.store(r, std::memory_order_release);
+    return r;
+}
+
+void MixerWorkerThread::JobDeque::reserve(long _jobs)
+{
+    Array* a = m_array.load(std::memory_order_relaxed);
+    if(_jobs <= a->m_size)
+        return;
+
+    long size = a->m_size;
+    while(size < _jobs)
+        size <<= 1;
+    resize(a, m_top.load(std::memory_order_acquire),
+           m_bottom.load(std::memory_order_relaxed), size);
+}
+
+void MixerWorkerThread::JobDeque::push(ThreadableJob* _job)
+{
+    const long b = m_bottom.load(std::memory_order_relaxed);
+    const long t = m_top.load(std::memory_order_acquire);
+    Array*     a = m_array.load(std::memory_order_relaxed);
+    // cold path, the deques are sized from the jobs of the graph
+    if(b - t > a->m_size - 1)
+        a = resize(a, t, b, a->m_size * 2);
+    a->put(b, _job);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_bottom.store(b + 1, std::memory_order_relaxed);
+}
+
+ThreadableJob* MixerWorkerThread::JobDeque::pop()
+{
+    const long b = m_bottom.load(std::memory_order_relaxed) - 1;
+    Array*     a = m_array.load(std::memory_order_relaxed);
+    m_bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long t = m_top.load(std::memory_order_relaxed);
+
+    ThreadableJob* r = nullptr;
+    if(t <= b)
+    {
+        r = a->get(b);
+        if(t == b)
+        {
+            // last job, race against the thieves
+            if(!m_top.compare_exchange_strong(t, t + 1,
+                                              std::memory_order_seq_cst,
+                                              std::memory_order_relaxed))
+                r = nullptr;
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+    }
+    else
+    {
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return r;
+}
+
+ThreadableJob* MixerWorkerThread::JobDeque::steal()
+{
+    while(true)
+    {
+        long t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const long b = m_bottom.load(std::memory_order_acquire);
+        if(t >= b)
+            return nullptr;
+
+        Array*         a = m_array.load(std::memory_order_acquire);
+        ThreadableJob* r = a->get(t);
+        if(m_top.compare_exchange_strong(t, t + 1,
+                                         std::memory_order_seq_cst,
+                                         std::memory_order_relaxed))
+            return r;
+        // another thread took it, try the next one
+    }
+}
+
 // implementation of internal JobQueue
+MixerWorkerThread::JobQueue::JobQueue() :
+      m_deques(), m_pending(0), m_opMode(Static)
+{
+    // deque 0 belongs to the non-worker threads
+    addDeque();
+}
+
+MixerWorkerThread::JobQueue::~JobQueue()
+{
+    for(JobDeque* d: m_deques)
+        delete d;
+}
+
+int MixerWorkerThread::JobQueue::addDeque()
+{
+    m_deques.append(new JobDeque());
+    return m_deques.size() - 1;
+}
+
 void MixerWorkerThread::JobQueue::reset(OperationMode _opMode)
 {
     /*
-    if(m_queueSize > 0)
+    if(m_pending > 0)
     {
         BACKTRACE
-        qWarning("MixerWorkerThread::JobQueue::reset queue=%d done=%d",
-                 (int)m_queueSize, (int)m_itemsDone);
+        qWarning("MixerWorkerThread::JobQueue::reset pending=%d",
+                 (int)m_pending);
     }
     */
-    m_queueSize = 0;
-    m_itemsDone = 0;
-    m_opMode    = _opMode;
+    m_pending = 0;
+    m_opMode  = _opMode;
+}
+
+void MixerWorkerThread::JobQueue::reserve(int _jobs)
+{
+    for(JobDeque* d: m_deques)
+        d->reserve(_jobs);
 }
 
 void MixerWorkerThread::JobQueue::addJob(ThreadableJob* _job)
@@ -58,57 +214,78 @@ void MixerWorkerThread::JobQueue::addJob(ThreadableJob* _job)
     {
         // update job state
         _job->queue();
-        // actually queue the job via atomic operations
-        auto index = m_queueSize.fetchAndAddOrdered(1);
-        if(index < JOB_QUEUE_SIZE)
-        {
-            m_items[index] = _job;
-        }
-        else
-        {
-            qWarning("MixerWorkerThread::JobQueue full");
-            m_itemsDone.fetchAndAddOrdered(1);
-        }
+        // count the job before it can be taken
+        m_pending.ref();
+        m_deques[s_dequeIndex]->push(_job);
+    }
+    else
+    {
+        // skipped jobs still count as done for their dependent
+        jobDone(_job);
+    }
+}
+
+void MixerWorkerThread::JobQueue::jobDone(ThreadableJob* _job)
+{
+    // queue the dependent once all of its dependencies are done. This is
+    // done before the job is counted so wait() can't return in between.
+    ThreadableJob* dependent = _job->dependent();
+    if(dependent != nullptr && dependent->dependencyDone())
+        addJob(dependent);
+}
+
+ThreadableJob* MixerWorkerThread::JobQueue::takeJob(int _index)
+{
+    ThreadableJob* r = m_deques[_index]->pop();
+    if(r != nullptr)
+        return r;
+
+    const int n = m_deques.size();
+    for(int i = 1; i < n; ++i)
+    {
+        r = m_deques[(_index + i) % n]->steal();
+        if(r != nullptr)
+            return r;
     }
+    return nullptr;
 }
 
 void MixerWorkerThread::JobQueue::run()
 {
-    bool processedJob = true;
-    while(processedJob && (int)m_itemsDone < (int)m_queueSize)
+    const int index = s_dequeIndex;
+    while((int)m_pending > 0)
     {
-        processedJob = false;
-        for(int i = 0; i < m_queueSize && i < JOB_QUEUE_SIZE; ++i)
+        ThreadableJob* job = takeJob(index);
+        if(job != nullptr)
         {
-            ThreadableJob* job = m_items[i].fetchAndStoreOrdered(nullptr);
-            if(job != nullptr)
-            {
-                // qInfo("Processing job in %s",
-                //      qPrintable(QThread::currentThread()->objectName()));
-                job->process();
-                processedJob = true;
-                m_itemsDone.fetchAndAddOrdered(1);
-            }
+            // qInfo("Processing job in %s",
+            //      qPrintable(QThread::currentThread()->objectName()));
+            job->process();
+            jobDone(job);
+            m_pending.deref();
+            continue;
         }
+
         // always exit loop if we're not in dynamic mode
-        processedJob = processedJob && (m_opMode == Dynamic);
+        if(m_opMode != Dynamic)
+            break;
+
+        // in dynamic mode, the remaining jobs are waiting for their
+        // dependencies and will be queued by the jobs being processed
+        cpuRelax();
     }
 }
 
 void MixerWorkerThread::JobQueue::wait()
 {
-    while((int)m_itemsDone < (int)m_queueSize)
-    {
-#if defined(LMMS_HOST_X86) || defined(LMMS_HOST_X86_64)
-        asm("pause");
-#endif
-    }
+    while((int)m_pending > 0)
+        cpuRelax();
 }
 
 // implementation of worker threads
 
 MixerWorkerThread::MixerWorkerThread(Mixer* mixer) :
-      QThread(mixer), m_quit(false)
+      QThread(mixer), m_quit(false), m_dequeIndex(0)
 {
     setObjectName("mixer worker");
 
@@ -122,6 +299,9 @@ MixerWorkerThread::MixerWorkerThread(Mixer* mixer) :
     // workerThreads << this;
     s_workerThreads.append(this);
 
+    // every worker owns a deque, created before any job is queued
+    m_dequeIndex = s_globalJobQueue.addDeque();
+
     resetJobQueue();
 }
 
@@ -144,7 +324,7 @@ void MixerWorkerThread::startAndWaitForJobs()
     // "inline" i.e. within the global Mixer thread. This way we can reduce
     // latencies that otherwise would be caused by synchronizing with another
     // thread.
-    // s_globalJobQueue.run();
+    s_globalJobQueue.run();
     s_globalJobQueue.wait();
 }
 
@@ -152,6 +332,25 @@ void MixerWorkerThread::run()
 {
     disable_denormals();
 
+    s_dequeIndex = m_dequeIndex;
+
+#ifdef LMMS_BUILD_LINUX
+#ifdef LMMS_HAVE_SCHED_H
+    if(CONFIG_GET_BOOL("mixer.workeraffinity"))
+    {
+        // pin the worker to one core so its deque stays cache-hot
+        const int ncpu = QThread::idealThreadCount();
+        if(ncpu > 0)
+        {
+            cpu_set_t mask;
+            CPU_ZERO(&mask);
+            CPU_SET((m_dequeIndex - 1) % ncpu, &mask);
+            sched_setaffinity(0, sizeof(mask), &mask);
+        }
+    }
+#endif
+#endif
+
     Mutex m("MixerWorkerThread::run", false);
     while(m_quit == false)
     {
@@ -35,8 +35,8 @@
 #include <iterator>
 
 PlayHandle::PlayHandle(const Type type, f_cnt_t offset) :
-      // m_audioPort(nullptr),
-      m_finished(false), m_type(type), m_offset(offset),
+      m_mixingPort(nullptr), m_handoffState(NotHandedOff), m_finished(false), m_type(type),
+      m_offset(offset),
       m_processingLock(
               "PlayHandle::m_processingLock", QMutex::Recursive, false),
       m_usesBuffer(true), m_playHandleBuffer(nullptr),
@@ -44,6 +44,9 @@ PlayHandle::PlayHandle(const Type type, f_cnt_t offset) :
       //m_refCount(0),
       m_pointer(nullptr)
 {
+    for(int i = 0; i < NumRegistryHooks; ++i)
+        m_registrySlots[i].storeRelease(-1);
+
     m_pointer = new PlayHandlePointer(this);
     // (((PlayHandlePointer*)m_pointer)->reset(this);
     // BufferManager::acquire()),
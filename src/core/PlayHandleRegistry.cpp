@@ -0,0 +1,202 @@
+/*
+ * PlayHandleRegistry.cpp - slot-indexed set of play handles
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "PlayHandleRegistry.h"
+
+#include "Backtrace.h"
+
+PlayHandleRegistry::PlayHandleRegistry(PlayHandle::RegistryHooks _hook,
+                                       int                       _capacity) :
+      m_hook(_hook),
+      m_capacity(((qMax(_capacity, 1) + 31) / 32) * 32),
+      m_slots(nullptr), m_used(nullptr), m_words(m_capacity / 32),
+      m_size(0), m_highWater(0), m_hint(0), m_epoch(0), m_waiting(0)
+{
+    m_slots = new std::atomic<PlayHandle*>[m_capacity];
+    for(int s = 0; s < m_capacity; ++s)
+        m_slots[s].store(nullptr, std::memory_order_relaxed);
+
+    m_used = new std::atomic<quint32>[m_words];
+    for(int w = 0; w < m_words; ++w)
+        m_used[w].store(0, std::memory_order_relaxed);
+
+    m_readers[0].store(0, std::memory_order_relaxed);
+    m_readers[1].store(0, std::memory_order_relaxed);
+}
+
+PlayHandleRegistry::~PlayHandleRegistry()
+{
+    clear();
+    delete[] m_slots;
+    delete[] m_used;
+}
+
+bool PlayHandleRegistry::insert(PlayHandle* _ph)
+{
+    if(_ph == nullptr)
+    {
+        BACKTRACE
+        qWarning("PlayHandleRegistry::insert(nullptr)");
+        return false;
+    }
+
+    if(_ph->m_registrySlots[m_hook].loadAcquire() >= 0)
+        return false;
+
+    const int s = allocSlot();
+    if(s < 0)
+    {
+        qCritical("PlayHandleRegistry::insert full (capacity=%d)",
+                  m_capacity);
+        return false;
+    }
+
+    m_slots[s].store(_ph, std::memory_order_release);
+    if(!_ph->m_registrySlots[m_hook].testAndSetOrdered(-1, s))
+    {
+        // inserted concurrently by another thread
+        m_slots[s].store(nullptr, std::memory_order_release);
+        freeSlot(s);
+        return false;
+    }
+
+    m_size.fetch_add(1, std::memory_order_relaxed);
+
+    int hw = m_highWater.load(std::memory_order_relaxed);
+    while(hw <= s
+          && !m_highWater.compare_exchange_weak(hw, s + 1,
+                                                std::memory_order_release))
+        ;
+
+    return true;
+}
+
+bool PlayHandleRegistry::remove(PlayHandle* _ph)
+{
+    if(_ph == nullptr)
+        return false;
+
+    const int s = _ph->m_registrySlots[m_hook].fetchAndStoreOrdered(-1);
+    if(s < 0)
+        return false;
+
+    PlayHandle* expected = _ph;
+    if(!m_slots[s].compare_exchange_strong(expected, nullptr,
+                                           std::memory_order_acq_rel))
+    {
+        BACKTRACE
+        qCritical("PlayHandleRegistry::remove slot %d is corrupted", s);
+        return false;
+    }
+
+    m_size.fetch_sub(1, std::memory_order_relaxed);
+    freeSlot(s);
+    return true;
+}
+
+void PlayHandleRegistry::clear()
+{
+    const int hw = m_highWater.load(std::memory_order_acquire);
+    for(int s = 0; s < hw; ++s)
+    {
+        PlayHandle* ph = m_slots[s].load(std::memory_order_acquire);
+        if(ph != nullptr)
+            remove(ph);
+    }
+}
+
+int PlayHandleRegistry::allocSlot()
+{
+    const int start = m_hint.load(std::memory_order_relaxed);
+    for(int i = 0; i < m_words; ++i)
+    {
+        const int w    = (start + i) % m_words;
+        quint32   used = m_used[w].load(std::memory_order_relaxed);
+        while(used != 0xFFFFFFFFU)
+        {
+            const int bit = __builtin_ctz(~used);
+            if(m_used[w].compare_exchange_weak(used, used | (1U << bit),
+                                               std::memory_order_acq_rel))
+            {
+                m_hint.store(w, std::memory_order_relaxed);
+                return w * 32 + bit;
+            }
+        }
+    }
+    return -1;
+}
+
+void PlayHandleRegistry::freeSlot(int _s)
+{
+    const int w = _s / 32;
+    m_used[w].fetch_and(~(1U << (_s % 32)), std::memory_order_release);
+    // keep the handles packed at the start of the array
+    if(w < m_hint.load(std::memory_order_relaxed))
+        m_hint.store(w, std::memory_order_relaxed);
+}
+
+int PlayHandleRegistry::enterRead()
+{
+    for(;;)
+    {
+        const int e = m_epoch.load(std::memory_order_seq_cst);
+        m_readers[e & 1].fetch_add(1, std::memory_order_seq_cst);
+        if(m_epoch.load(std::memory_order_seq_cst) == e)
+            return e;
+        // a synchronize() flipped the epoch meanwhile
+        if(m_readers[e & 1].fetch_sub(1, std::memory_order_seq_cst) == 1)
+            wakeSynchronizer(e & 1);
+    }
+}
+
+void PlayHandleRegistry::leaveRead(int _epoch)
+{
+    if(m_readers[_epoch & 1].fetch_sub(1, std::memory_order_seq_cst) == 1)
+        wakeSynchronizer(_epoch & 1);
+}
+
+// does not lock unless a synchronize() is waiting for this epoch
+void PlayHandleRegistry::wakeSynchronizer(int _parity)
+{
+    int expected = _parity + 1;
+    if(m_waiting.compare_exchange_strong(expected, 0,
+                                         std::memory_order_seq_cst))
+        m_synchronized.release();
+}
+
+void PlayHandleRegistry::synchronize()
+{
+    QMutexLocker locker(&m_syncMutex);
+    const int    e = m_epoch.fetch_add(1, std::memory_order_seq_cst) & 1;
+    for(;;)
+    {
+        m_waiting.store(e + 1, std::memory_order_seq_cst);
+        if(m_readers[e].load(std::memory_order_seq_cst) == 0)
+        {
+            // the last reader may have taken the flag meanwhile
+            if(m_waiting.exchange(0, std::memory_order_seq_cst) == 0)
+                m_synchronized.acquire();
+            return;
+        }
+        m_synchronized.acquire();
+    }
+}
@@ -24,7 +24,9 @@
 
 #include "ProjectJournal.h"
 
+#include "AutomatableModel.h"
 #include "AutomationPattern.h"
+#include "ConfigManager.h"
 #include "Engine.h"
 #include "JournallingObject.h"
 #include "Song.h"
@@ -33,11 +35,18 @@
 
 static const int EO_ID_MSB = 1 << 23;
 
+// the changes of the same model closer than this are one check point
+static const qint64 VALUE_COALESCE_MS = 500;
+
 const int ProjectJournal::MAX_UNDO_STATES
         = 100;  // TODO: make this configurable in settings
 
 ProjectJournal::ProjectJournal() :
       m_joIDs(), m_undoCheckPoints(), m_redoCheckPoints(),
+      m_maxBytes(qint64(qMax(1, ConfigManager::inst()
+                                         ->value("app", "undomb", "64")
+                                         .toInt()))
+                 * 1024 * 1024),
       m_journalling(false)
 {
 }
@@ -56,12 +65,11 @@ void ProjectJournal::undo()
 
         if(o != nullptr)
         {
-            DataFile curState(DataFile::JournalData);
-            o->saveState(curState, curState.content());
-            m_redoCheckPoints.push(CheckPoint(c.joID, curState));
+            m_redoCheckPoints.push(checkPoint(o));
+            bound(m_redoCheckPoints);
 
             bool was = testAndSetJournalling(false);
-            o->restoreState(c.data.content().firstChildElement());
+            restore(o, c);
             setJournalling(was);
             Engine::song()->setModified();
             break;
@@ -78,12 +86,11 @@ void ProjectJournal::redo()
 
         if(o != nullptr)
         {
-            DataFile curState(DataFile::JournalData);
-            o->saveState(curState, curState.content());
-            m_undoCheckPoints.push(CheckPoint(c.joID, curState));
+            m_undoCheckPoints.push(checkPoint(o));
+            bound(m_undoCheckPoints);
 
             bool was = testAndSetJournalling(false);
-            o->restoreState(c.data.content().firstChildElement());
+            restore(o, c);
             setJournalling(was);
             Engine::song()->setModified();
             break;
@@ -121,14 +128,74 @@ void ProjectJournal::addJournalCheckPoint(JournallingObject* o)
 
         m_redoCheckPoints.clear();
 
-        DataFile dataFile(DataFile::JournalData);
-        o->saveState(dataFile, dataFile.content());
+        // the first value of a series of changes is already kept
+        const bool isModel = dynamic_cast<AutomatableModel*>(o) != nullptr;
+        if(isModel && !m_undoCheckPoints.isEmpty()
+           && m_undoCheckPoints.top().isValue
+           && m_undoCheckPoints.top().joID == o->id()
+           && m_lastValueTimer.isValid()
+           && m_lastValueTimer.elapsed() < VALUE_COALESCE_MS)
+        {
+            m_lastValueTimer.restart();
+            return;
+        }
+        if(isModel)
+            m_lastValueTimer.restart();
+        else
+            m_lastValueTimer.invalidate();
+
+        m_undoCheckPoints.push(checkPoint(o));
+        bound(m_undoCheckPoints);
+    }
+}
+
+ProjectJournal::CheckPoint ProjectJournal::checkPoint(JournallingObject* _jo)
+{
+    CheckPoint c(_jo->id());
+
+    AutomatableModel* m = dynamic_cast<AutomatableModel*>(_jo);
+    if(m != nullptr)
+    {
+        c.isValue = true;
+        c.value   = m->rawValue<real_t>();
+        return c;
+    }
+
+    DataFile dataFile(DataFile::JournalData);
+    _jo->saveState(dataFile, dataFile.content());
+    c.state = qCompress(dataFile.toByteArray(-1));
+    return c;
+}
+
+void ProjectJournal::restore(JournallingObject* _jo, const CheckPoint& _c)
+{
+    if(_c.isValue)
+    {
+        AutomatableModel* m = dynamic_cast<AutomatableModel*>(_jo);
+        if(m != nullptr)
+            m->setValue(_c.value);
+        return;
+    }
+
+    DataFile dataFile(qUncompress(_c.state));
+    _jo->restoreState(dataFile.content().firstChildElement());
+}
+
+void ProjectJournal::bound(CheckPointStack& _stack)
+{
+    qint64 bytes = 0;
+    for(const CheckPoint& c: _stack)
+        bytes += c.size();
 
-        m_undoCheckPoints.push(CheckPoint(o->id(), dataFile));
-        if(m_undoCheckPoints.size() > MAX_UNDO_STATES)
-            m_undoCheckPoints.remove(0, m_undoCheckPoints.size()
-                                                - MAX_UNDO_STATES);
+    int n = 0;
+    while(n < _stack.size() - 1
+          && (_stack.size() - n > MAX_UNDO_STATES || bytes > m_maxBytes))
+    {
+        bytes -= _stack.at(n).size();
+        ++n;
     }
+    if(n > 0)
+        _stack.remove(0, n);
 }
 
 jo_id_t ProjectJournal::allocID(JournallingObject* _obj)
@@ -197,6 +264,7 @@ void ProjectJournal::clearJournal()
 {
     m_undoCheckPoints.clear();
     m_redoCheckPoints.clear();
+    m_lastValueTimer.invalidate();
 
     /*
     for(JoIdMap::Iterator it = m_joIDs.begin(); it != m_joIDs.end();)
@@ -38,6 +38,8 @@
 #include "Song.h"
 #include "denormals.h"
 
+#include <QFileInfo>
+
 #ifdef LMMS_HAVE_SCHED_H
 #include "sched.h"
 #endif
@@ -105,7 +107,8 @@ ProjectRenderer::ProjectRenderer(
         RenderManager*                _rm) :
       QThread(_rm),
       // QThread(Engine::mixer()),
-      m_fileDev(nullptr), m_qualitySettings(qualitySettings), m_progress(0),
+      m_fileDev(nullptr), m_outputSettings(outputSettings),
+      m_qualitySettings(qualitySettings), m_progress(0),
       m_abort(false)
 {
     setObjectName("project renderer " + outputFilename);
@@ -130,6 +133,48 @@ ProjectRenderer::ProjectRenderer(
 
 ProjectRenderer::~ProjectRenderer()
 {
+    // the master device is deleted by the mixer
+    if(m_fileDev != nullptr)
+    {
+        m_fileDev->stopEncoder();
+        m_fileDev->clearMirrors();
+    }
+    for(AudioFileDevice* dev: m_mirrorDevices)
+        delete dev;
+}
+
+bool ProjectRenderer::addMirrorFormat(ExportFileFormats _fmt)
+{
+    AudioFileDeviceInstantiaton factory = fileEncodeDevices(_fmt).m_getDevInst;
+    if(!isReady() || factory == nullptr || outputFile() == "-")
+        return false;
+
+    const QFileInfo fi(outputFile());
+    const QString   file = fi.path() + "/" + fi.completeBaseName()
+                         + getFileExtensionFromFormat(_fmt);
+
+    bool             successful = false;
+    AudioFileDevice* dev        = factory(file, m_outputSettings,
+                                   DEFAULT_CHANNELS, Engine::mixer(),
+                                   successful);
+    if(!successful)
+    {
+        qWarning("ProjectRenderer: can not write %s", qPrintable(file));
+        delete dev;
+        return false;
+    }
+
+    m_fileDev->addMirror(dev);
+    m_mirrorDevices.append(dev);
+    return true;
+}
+
+QStringList ProjectRenderer::mirrorFiles() const
+{
+    QStringList r;
+    for(AudioFileDevice* dev: m_mirrorDevices)
+        r << dev->outputFile();
+    return r;
 }
 
 // little help-function for getting file-format from a file-extension (only
@@ -194,6 +239,16 @@ void ProjectRenderer::run()
 
     Engine::getSong()->startExport();
     Engine::getSong()->updateLength();
+    // the encoders run beside the render loop
+    m_fileDev->startEncoder();
+    for(AudioFileDevice* dev: m_stemDevices)
+        dev->startEncoder();
+
+    // the file gets each period one buffer later than the stems, so they
+    // are armed before the skipped buffer to start with the same period
+    for(AudioFileDevice* dev: m_stemDevices)
+        dev->setCapturing(true);
+
     // skip first empty buffer
     Engine::mixer()->nextBuffer();
 
@@ -224,6 +279,14 @@ void ProjectRenderer::run()
         }
     }
 
+    for(AudioFileDevice* dev: m_stemDevices)
+        dev->setCapturing(false);
+
+    // the files are complete once the encoders are done
+    m_fileDev->stopEncoder();
+    for(AudioFileDevice* dev: m_stemDevices)
+        dev->stopEncoder();
+
     // notify mixer of the end of processing
     Engine::mixer()->stopProcessing();
 
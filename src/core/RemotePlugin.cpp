@@ -32,6 +32,7 @@
 #include "RemotePlugin.h"
 
 #include "BufferManager.h"
+#include "ConfigManager.h"
 #include "Engine.h"
 #include "Mixer.h"
 #include "denormals.h"
@@ -84,7 +85,10 @@ RemotePlugin::RemotePlugin() :
       m_shmID(0),
 #endif
       m_shmSize(0), m_shm(nullptr), m_inputCount(DEFAULT_CHANNELS),
-      m_outputCount(DEFAULT_CHANNELS)
+      m_outputCount(DEFAULT_CHANNELS),
+      m_pipelined(
+              ConfigManager::inst()->value("mixer", "pipelinedplugins").toInt()),
+      m_pending(false), m_half(-1)
 {
 #ifndef SYNC_WITH_SHM_FIFO
     struct sockaddr_un sa;
@@ -271,8 +275,60 @@ bool RemotePlugin::process(const sampleFrame* _in_buf, sampleFrame* _out_buf)
         return false;
     }
 
+    if(m_pipelined)
+    {
+        // collect the period N-1, which is in the other half
+        lock();
+        const bool done = m_half >= 0;
+        waitForProcessingDone();
+
+        const int    half = done ? m_half : 0;
+        float* const shm  = m_shm + half * m_shmSize / (2 * sizeof(float));
+        memset(shm, 0, m_shmSize / 2);
+        writeInput(shm, _in_buf, frames);
+        sendMessage(message(IdStartProcessing).addInt(int(shm - m_shm)));
+        m_pending = true;
+        m_half    = 1 - half;
+        unlock();
+
+        if(m_failed || _out_buf == nullptr || m_outputCount == 0)
+            return false;
+
+        if(!done)
+        {
+            // first period: nothing to collect yet
+            BufferManager::clear(_out_buf);
+            return true;
+        }
+
+        readOutput(m_shm + m_half * m_shmSize / (2 * sizeof(float)), _out_buf,
+                   frames);
+        return true;
+    }
+
     memset(m_shm, 0, m_shmSize);
+    writeInput(m_shm, _in_buf, frames);
 
+    lock();
+    sendMessage(IdStartProcessing);
+
+    if(m_failed || _out_buf == nullptr || m_outputCount == 0)
+    {
+        unlock();
+        return false;
+    }
+
+    waitForMessage(IdProcessingDone);
+    unlock();
+
+    readOutput(m_shm, _out_buf, frames);
+    return true;
+}
+
+void RemotePlugin::writeInput(float*             _shm,
+                              const sampleFrame* _in_buf,
+                              fpp_t              _frames)
+{
     ch_cnt_t inputs = qMin<ch_cnt_t>(m_inputCount, DEFAULT_CHANNELS);
 
     if(_in_buf != nullptr && inputs > 0)
@@ -280,59 +336,80 @@ bool RemotePlugin::process(const sampleFrame* _in_buf, sampleFrame* _out_buf)
         if(m_splitChannels)
         {
             for(ch_cnt_t ch = 0; ch < inputs; ++ch)
-                for(fpp_t frame = 0; frame < frames; ++frame)
-                    m_shm[ch * frames + frame] = _in_buf[frame][ch];
+                for(fpp_t frame = 0; frame < _frames; ++frame)
+                    _shm[ch * _frames + frame] = _in_buf[frame][ch];
         }
         else if(inputs == DEFAULT_CHANNELS)
         {
-            memcpy(m_shm, _in_buf, frames * BYTES_PER_FRAME);
+            memcpy(_shm, _in_buf, _frames * BYTES_PER_FRAME);
         }
         else
         {
-            sampleFrame* o = (sampleFrame*)m_shm;
+            sampleFrame* o = (sampleFrame*)_shm;
             for(ch_cnt_t ch = 0; ch < inputs; ++ch)
-                for(fpp_t frame = 0; frame < frames; ++frame)
+                for(fpp_t frame = 0; frame < _frames; ++frame)
                     o[frame][ch] = _in_buf[frame][ch];
         }
     }
+}
 
-    lock();
-    sendMessage(IdStartProcessing);
-
-    if(m_failed || _out_buf == nullptr || m_outputCount == 0)
-    {
-        unlock();
-        return false;
-    }
-
-    waitForMessage(IdProcessingDone);
-    unlock();
-
+void RemotePlugin::readOutput(const float* _shm,
+                              sampleFrame* _out_buf,
+                              fpp_t        _frames)
+{
     const ch_cnt_t outputs = qMin<ch_cnt_t>(m_outputCount, DEFAULT_CHANNELS);
     if(m_splitChannels)
     {
         for(ch_cnt_t ch = 0; ch < outputs; ++ch)
-            for(fpp_t frame = 0; frame < frames; ++frame)
+            for(fpp_t frame = 0; frame < _frames; ++frame)
                 _out_buf[frame][ch]
-                        = m_shm[(m_inputCount + ch) * frames + frame];
+                        = _shm[(m_inputCount + ch) * _frames + frame];
     }
     else if(outputs == DEFAULT_CHANNELS)
     {
-        memcpy(_out_buf, m_shm + m_inputCount * frames,
-               frames * BYTES_PER_FRAME);
+        memcpy(_out_buf, _shm + m_inputCount * _frames,
+               _frames * BYTES_PER_FRAME);
     }
     else
     {
-        sampleFrame* o = (sampleFrame*)(m_shm + m_inputCount * frames);
+        const sampleFrame* o
+                = (const sampleFrame*)(_shm + m_inputCount * _frames);
         // clear buffer, if plugin didn't fill up both channels
         BufferManager::clear(_out_buf);  //, frames );
 
         for(ch_cnt_t ch = 0; ch < qMin<int>(DEFAULT_CHANNELS, outputs); ++ch)
-            for(fpp_t frame = 0; frame < frames; ++frame)
+            for(fpp_t frame = 0; frame < _frames; ++frame)
                 _out_buf[frame][ch] = o[frame][ch];
     }
+}
 
-    return true;
+// must be called locked
+void RemotePlugin::waitForProcessingDone()
+{
+    // the reply may also be consumed by another waitForMessage(),
+    // processMessage() clears m_pending in any case
+    while(m_pending && !m_failed && !isInvalid())
+        fetchAndProcessNextMessage();
+    m_pending = false;
+}
+
+void RemotePlugin::setPipelined(bool _on)
+{
+    lock();
+    if(_on != m_pipelined)
+    {
+        waitForProcessingDone();
+        m_pipelined = _on;
+        m_half      = -1;
+        if(m_shm != nullptr)
+            resizeSharedProcessingMemory();
+    }
+    unlock();
+}
+
+f_cnt_t RemotePlugin::latency() const
+{
+    return m_pipelined ? Engine::mixer()->framesPerPeriod() : 0;
 }
 
 void RemotePlugin::processMidiEvent(const MidiEvent& _e,
@@ -355,8 +432,11 @@ void RemotePlugin::processMidiEvent(const MidiEvent& _e,
 
 void RemotePlugin::resizeSharedProcessingMemory()
 {
+    // two halves in pipelined mode, one being processed by the remote
+    // process while the other one is filled and read by us
     const size_t s = (m_inputCount + m_outputCount)
-                     * Engine::mixer()->framesPerPeriod() * sizeof(float);
+                     * Engine::mixer()->framesPerPeriod() * sizeof(float)
+                     * (m_pipelined ? 2 : 1);
     if(m_shm != nullptr)
     {
 #ifdef USE_QT_SHMEM
@@ -384,6 +464,7 @@ void RemotePlugin::resizeSharedProcessingMemory()
     m_shm = (float*)shmat(m_shmID, 0, 0);
 #endif
     m_shmSize = s;
+    m_half    = -1;
     sendMessage(message(IdChangeSharedMemoryKey)
                         .addInt(shm_key)
                         .addInt(m_shmSize));
@@ -444,6 +525,9 @@ bool RemotePlugin::processMessage(const message& _m)
             break;
 
         case IdProcessingDone:
+            m_pending = false;
+            break;
+
         case IdQuit:
         default:
             break;
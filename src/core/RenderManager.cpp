@@ -31,6 +31,9 @@
 
 //#include "BBTrack.h"
 #include "BBTrackContainer.h"
+#include "FxMixer.h"
+#include "InstrumentTrack.h"
+#include "SampleTrack.h"
 #include "Song.h"
 
 RenderManager::RenderManager(const Mixer::qualitySettings& qualitySettings,
@@ -49,6 +52,7 @@ RenderManager::~RenderManager()
 {
     delete m_activeRenderer;
     m_activeRenderer = nullptr;
+    clearStems(true);
 
     Engine::mixer()->restoreAudioDevice();  // Also deletes audio dev.
     Engine::mixer()->changeQuality(m_oldQualitySettings);
@@ -60,8 +64,13 @@ void RenderManager::abortProcessing()
     {
         disconnect(m_activeRenderer, SIGNAL(finished()), this,
                    SLOT(renderNextTrack()));
+        disconnect(m_activeRenderer, SIGNAL(finished()), this,
+                   SLOT(finishStems()));
+        // the render thread writes the stems until it returns
         m_activeRenderer->abortProcessing();
+        m_activeRenderer->wait();
     }
+    clearStems(true);
     restoreMutedState();
 }
 
@@ -108,14 +117,17 @@ void RenderManager::renderNextTrack()
     // post-process current track
     if(m_activeRenderer != nullptr)
     {
-        QString f = m_activeRenderer->outputFile();
-        bool    a = m_activeRenderer->aborted();
+        QString     f  = m_activeRenderer->outputFile();
+        QStringList mf = m_activeRenderer->mirrorFiles();
+        bool        a  = m_activeRenderer->aborted();
 
         delete m_activeRenderer;
         m_activeRenderer = nullptr;
 
         fprintf(stderr, "\n");
         postProcess(f, a);
+        for(QString& g: mf)
+            postProcess(g, a);
     }
     else
     {
@@ -151,6 +163,8 @@ void RenderManager::renderNextTrack()
 
         if(m_activeRenderer->isReady())
         {
+            addMirrorFormats();
+
             // pass progress signals through
             connect(m_activeRenderer, SIGNAL(progressChanged(int)), this,
                     SIGNAL(progressChanged(int)));
@@ -172,7 +186,180 @@ void RenderManager::renderNextTrack()
 // Render the song into individual channels
 void RenderManager::renderChannels()
 {
-    qWarning("RenderManager::renderChannels not implemented");
+    renderInOnePass(false, true);
+}
+
+// Render the song into individual tracks and channels
+void RenderManager::renderStems()
+{
+    renderInOnePass(true, true);
+}
+
+// Play the song once: the master output goes to the renderer device and
+// every audio port or fx channel copies its own output into a stem device.
+// The ports and channels run in parallel in the worker threads, so the
+// stems are encoded in parallel too.
+void RenderManager::renderInOnePass(bool _tracks, bool _channels)
+{
+    int num = 0;
+
+    if(_tracks)
+    {
+        Tracks tl = Engine::getSong()->tracks();
+        tl << Engine::getBBTrackContainer()->tracks();
+        for(Track* tk: tl)
+        {
+            if(tk->isMuted())
+                continue;
+
+            AudioPortPointer port;
+            if(tk->type() == Track::InstrumentTrack)
+                port = static_cast<InstrumentTrack*>(tk)->audioPort();
+            else if(tk->type() == Track::SampleTrack)
+                port = static_cast<SampleTrack*>(tk)->audioPort();
+            if(port.isNull())
+                continue;
+
+            AudioFileDevice* dev
+                    = createStemDevice(pathForTrack(tk, ++num), m_format);
+            if(dev == nullptr)
+                continue;
+
+            port->setStemDevice(dev);
+            m_stemPorts.append(port);
+            m_stemDevices.append(dev);
+        }
+    }
+
+    if(_channels)
+    {
+        FxMixer* fxm = Engine::fxMixer();
+        // the master channel is the renderer output
+        for(int i = 1; i < fxm->numChannels(); ++i)
+        {
+            FxChannel* ch = fxm->effectChannel(i);
+            if(ch == nullptr || ch->isMuted())
+                continue;
+
+            AudioFileDevice* dev
+                    = createStemDevice(pathForChannel(ch, ++num), m_format);
+            if(dev == nullptr)
+                continue;
+
+            ch->setStemDevice(dev);
+            m_stemChannels.append(ch);
+            m_stemDevices.append(dev);
+        }
+    }
+
+    qInfo("RenderManager: rendering %d stems in one pass",
+          m_stemDevices.size());
+
+    m_activeRenderer = new ProjectRenderer(
+            m_qualitySettings, m_outputSettings, m_format,
+            QDir(m_outputPath)
+                    .filePath(QString("00_Master%1").arg(
+                            ProjectRenderer::getFileExtensionFromFormat(
+                                    m_format))),
+            this);
+
+    if(m_activeRenderer->isReady())
+    {
+        addMirrorFormats();
+        for(AudioFileDevice* dev: m_stemDevices)
+            m_activeRenderer->addStemDevice(dev);
+
+        connect(m_activeRenderer, SIGNAL(progressChanged(int)), this,
+                SIGNAL(progressChanged(int)));
+        connect(m_activeRenderer, SIGNAL(finished()), this,
+                SLOT(finishStems()));
+
+        m_activeRenderer->startProcessing();
+    }
+    else
+    {
+        qCritical("Renderer failed to acquire a file device!");
+        clearStems(true);
+        emit finished();
+    }
+}
+
+void RenderManager::addMirrorFormats()
+{
+    for(ProjectRenderer::ExportFileFormats fmt: m_mirrorFormats)
+        m_activeRenderer->addMirrorFormat(fmt);
+}
+
+AudioFileDevice* RenderManager::createStemDevice(
+        const QString& _path, ProjectRenderer::ExportFileFormats _fmt)
+{
+    AudioFileDeviceInstantiaton factory
+            = ProjectRenderer::fileEncodeDevices(_fmt).m_getDevInst;
+    if(factory == nullptr)
+        return nullptr;
+
+    bool             successful = false;
+    AudioFileDevice* dev        = factory(_path, m_outputSettings,
+                                   DEFAULT_CHANNELS, Engine::mixer(),
+                                   successful);
+    if(!successful)
+    {
+        qWarning("RenderManager: can not write stem %s", qPrintable(_path));
+        delete dev;
+        return nullptr;
+    }
+
+    if(_fmt == m_format)
+    {
+        const QString base = _path.left(
+                _path.length()
+                - ProjectRenderer::getFileExtensionFromFormat(_fmt).length());
+        for(ProjectRenderer::ExportFileFormats fmt: m_mirrorFormats)
+        {
+            AudioFileDevice* mirror = createStemDevice(
+                    base + ProjectRenderer::getFileExtensionFromFormat(fmt),
+                    fmt);
+            if(mirror == nullptr)
+                continue;
+
+            dev->addMirror(mirror);
+            m_stemMirrors.append(mirror);
+        }
+    }
+    return dev;
+}
+
+void RenderManager::finishStems()
+{
+    clearStems(m_activeRenderer != nullptr && m_activeRenderer->aborted());
+    // post-process the master and finish
+    renderNextTrack();
+}
+
+void RenderManager::clearStems(bool _aborted)
+{
+    // the worker threads may be writing a stem while the mixer runs
+    Engine::mixer()->requestChangeInModel();
+    for(AudioPortPointer& port: m_stemPorts)
+        port->setStemDevice(nullptr);
+    for(FxChannel* ch: m_stemChannels)
+        ch->setStemDevice(nullptr);
+    Engine::mixer()->doneChangeInModel();
+    m_stemPorts.clear();
+    m_stemChannels.clear();
+
+    for(AudioFileDevice* dev: m_stemDevices)
+        dev->stopEncoder();
+
+    for(AudioFileDevice* dev: m_stemDevices + m_stemMirrors)
+    {
+        QString f = dev->outputFile();
+        // closes the file
+        delete dev;
+        postProcess(f, _aborted);
+    }
+    m_stemDevices.clear();
+    m_stemMirrors.clear();
 }
 
 // Render the song into individual tracks
@@ -223,6 +410,8 @@ void RenderManager::renderProject()
 
     if(m_activeRenderer->isReady())
     {
+        addMirrorFormats();
+
         // pass progress signals through
         connect(m_activeRenderer, SIGNAL(progressChanged(int)), this,
                 SIGNAL(progressChanged(int)));
@@ -266,6 +455,20 @@ QString RenderManager::pathForTrack(const Track* track, int num)
     return QDir(m_outputPath).filePath(name);
 }
 
+// Determine the output path for a channel when rendering stems
+QString RenderManager::pathForChannel(const FxChannel* channel, int num)
+{
+    QString extension = ProjectRenderer::getFileExtensionFromFormat(m_format);
+    QString name      = channel->name();
+    name              = name.remove(QRegExp("[^a-zA-Z]"));
+    name              = QString("%1_FX%2_%3%4")
+                   .arg(num, 2, 10, QChar('0'))
+                   .arg(channel->channelIndex())
+                   .arg(name)
+                   .arg(extension);
+    return QDir(m_outputPath).filePath(name);
+}
+
 void RenderManager::updateConsoleProgress()
 {
     if(m_activeRenderer)
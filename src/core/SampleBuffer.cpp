@@ -29,13 +29,16 @@
 #include "Backtrace.h"
 
 #include <QBuffer>
+#include <QCoreApplication>
 #include <QFile>
 #include <QFileInfo>
 #include <QHash>
 #include <QMessageBox>
 #include <QMutexLocker>
 #include <QPainter>
+#include <QtConcurrent>
 
+#include <atomic>
 #include <sndfile.h>
 
 #define OV_EXCLUDE_STATIC_CALLBACKS
@@ -59,7 +62,9 @@
 #include "MixHelpers.h"
 #include "Mixer.h"
 #include "SampleBuffer.h"
+#include "SampleCache.h"
 #include "SampleRate.h"
+#include "SampleStreamer.h"
 #include "Song.h"
 #include "endian_handling.h"  // REQUIRED
 
@@ -178,9 +183,16 @@ void SampleBuffer::sampleRateChanged()
 
 static QHash<QString, sampleFrame*> s_mmap_pointer;
 static QHash<QString, QFile*>       s_mmap_file;
+static QMutex                       s_mmap_mutex;
 
 void SampleBuffer::clearMMap()
 {
+    QMutexLocker locker(&s_mmap_mutex);
+
+    // a streamer was started when the first file was mapped
+    if(!s_mmap_file.isEmpty())
+        SampleStreamer::inst()->clear();
+
     s_mmap_pointer.clear();
     for(QFile* f: s_mmap_file)
     {
@@ -190,6 +202,223 @@ void SampleBuffer::clearMMap()
     s_mmap_file.clear();
 }
 
+// maps a raw cache, shared by the buffers playing the same file
+bool SampleBuffer::mapFile(const QString& _fileName)
+{
+    QMutexLocker locker(&s_mmap_mutex);
+
+    sampleFrame* data = s_mmap_pointer.value(_fileName, nullptr);
+    qint64       n    = 0;
+    if(data != nullptr)
+    {
+        n = s_mmap_file.value(_fileName)->size();
+        qInfo("SampleBuffer: File %s already mapped (%lld bytes) %p",
+              qPrintable(_fileName), n, data);
+    }
+    else
+    {
+        QFile* file = new QFile(_fileName);
+        n           = file->size();
+        if(n < qint64(BYTES_PER_FRAME) || !file->open(QFile::ReadOnly)
+           || !(data = (sampleFrame*)(file->map(0, n))))
+        {
+            delete file;
+            qWarning("SampleBuffer: Fail to map %s", qPrintable(_fileName));
+            return false;
+        }
+
+        s_mmap_file.insert(_fileName, file);
+        s_mmap_pointer.insert(_fileName, data);
+        SampleStreamer::inst()->addMapping(data, n / BYTES_PER_FRAME);
+        qInfo("SampleBuffer: File %s mapped successfully (%lld bytes) %p",
+              qPrintable(_fileName), n, data);
+    }
+
+    m_origData   = data;
+    m_origFrames = n / BYTES_PER_FRAME;
+    m_mmapped    = true;
+    m_data       = m_origData;
+    m_frames     = m_origFrames;
+    return true;
+}
+
+// File size and sample length limits
+static const int FILE_SIZE_MAX     = 1024;  // MB
+static const int SAMPLE_LENGTH_MAX = 90;    // Minutes
+
+// the bigger files are streamed from their raw cache
+static qint64 streamingSize()
+{
+    return qint64(ConfigManager::inst()
+                          ->value("mixer", "samplestreamingmb", "64")
+                          .toInt())
+           * 1024 * 1024;
+}
+
+// the files decoded in the background, by absolute path
+static QMutex                        s_warm_mutex;
+static QHash<QString, QFuture<void>> s_warm_futures;
+static std::atomic<bool>             s_warm_cancelled(false);
+
+void SampleBuffer::warmCache(const QString& _audioFile)
+{
+    if(!SampleCache::isEnabled() || _audioFile.isEmpty())
+        return;
+
+    // only the files update() looks up in the shared cache
+    const QString file = tryToMakeAbsolute(_audioFile);
+    const qint64  size = QFileInfo(file).size();
+    if(file.endsWith("." + rawStereoSuffix()) || size <= 0
+       || size > streamingSize()
+       || size > qint64(FILE_SIZE_MAX) * 1024 * 1024)
+        return;
+
+    QMutexLocker locker(&s_warm_mutex);
+    if(s_warm_futures.contains(file))
+        return;
+
+    s_warm_cancelled = false;
+    s_warm_futures.insert(file, QtConcurrent::run(&decodeForCache, file));
+}
+
+void SampleBuffer::waitForWarmCache(bool _cancel)
+{
+    QMutexLocker locker(&s_warm_mutex);
+    if(_cancel)
+        s_warm_cancelled = true;
+    for(QFuture<void>& f: s_warm_futures)
+        f.waitForFinished();
+    s_warm_futures.clear();
+}
+
+void SampleBuffer::waitForWarming(const QString& _file)
+{
+    QFuture<void> f;
+    {
+        QMutexLocker locker(&s_warm_mutex);
+        if(!s_warm_futures.contains(_file))
+            return;
+        f = s_warm_futures.value(_file);
+    }
+    f.waitForFinished();
+}
+
+// runs in the pool: no transform, no message box, only the shared cache
+void SampleBuffer::decodeForCache(const QString& _file)
+{
+    if(s_warm_cancelled)
+        return;
+
+    // a new buffer has the parameters of the key
+    SampleBuffer sb(f_cnt_t(0), false);
+    MM_FREE(sb.m_data);
+    sb.m_data   = nullptr;
+    sb.m_frames = 0;
+
+    sample_rate_t samplerate = Engine::mixer()->baseSampleRate();
+    const QString key        = sb.cacheKey(_file, samplerate);
+    if(key.isEmpty() || !SampleCache::find(key).isEmpty())
+        return;
+
+    if(!sb.decodeFile(_file, samplerate) || sb.m_frames == 0)
+        return;
+
+    MixHelpers::sanitize(sb.m_data, sb.m_frames);
+    sb.normalizeSampleRate(samplerate, false);
+    if(sb.m_frames > 1)
+        SampleCache::store(key, sb.m_data, sb.m_frames);
+}
+
+QString SampleBuffer::cacheKey(const QString&      _file,
+                               const sample_rate_t _samplerate) const
+{
+    return SampleCache::key(
+            _file, QString("rate=%1 sr=%2 rev=%3 st=%4 pre=%5 post=%6")
+                           .arg(_samplerate)
+                           .arg(m_sampleRate)
+                           .arg(m_reversed)
+                           .arg(m_stretching, 0, 'g', 17)
+                           .arg(m_predelay, 0, 'g', 17)
+                           .arg(m_postdelay, 0, 'g', 17));
+}
+
+// decodes the audio file into m_data, false if it is over the limits.
+// m_frames is 0 if it can not be decoded.
+bool SampleBuffer::decodeFile(const QString& _filename,
+                              sample_rate_t& _samplerate)
+{
+#ifdef LMMS_BUILD_WIN32
+    char* f = qstrdup(_filename.toLocal8Bit().constData());
+#else
+    char* f = qstrdup(_filename.toUtf8().constData());
+#endif
+    sampleS16_t* ibuf     = nullptr;
+    sample_t*    fbuf     = nullptr;
+    ch_cnt_t     channels = DEFAULT_CHANNELS;
+
+    bool fileLoadError = false;
+    m_frames           = 0;
+
+    const QFileInfo fileInfo(_filename);
+    if(fileInfo.size() > qint64(FILE_SIZE_MAX) * 1024 * 1024)
+    {
+        fileLoadError = true;
+    }
+#ifdef LMMS_HAVE_MPG123
+    else if(_filename.endsWith(".mp3"))
+    {
+        // fileLoadError=true;
+        m_frames = decodeSampleMPG123(f, fbuf, channels, _samplerate);
+    }
+#endif
+    else
+    {
+        SNDFILE* snd_file;
+        SF_INFO  sf_info;
+        sf_info.format = 0;
+        if((snd_file = sf_open(f, SFM_READ, &sf_info)) != nullptr)
+        {
+            f_cnt_t frames = sf_info.frames;
+            int     rate   = sf_info.samplerate;
+            if(frames / rate > SAMPLE_LENGTH_MAX * 60)
+            {
+                fileLoadError = true;
+            }
+            sf_close(snd_file);
+        }
+    }
+
+    if(!fileLoadError)
+    {
+#ifdef LMMS_HAVE_OGGVORBIS
+        // workaround for a bug in libsndfile or our libsndfile decoder
+        // causing some OGG files to be distorted -> try with OGG Vorbis
+        // decoder first if filename extension matches "ogg"
+        if(m_frames == 0 && fileInfo.suffix() == "ogg")
+        {
+            m_frames = decodeSampleOGGVorbis(f, ibuf, channels, _samplerate);
+        }
+#endif
+        if(m_frames == 0)
+        {
+            m_frames = decodeSampleSF(f, fbuf, channels, _samplerate);
+        }
+#ifdef LMMS_HAVE_OGGVORBIS
+        if(m_frames == 0)
+        {
+            m_frames = decodeSampleOGGVorbis(f, ibuf, channels, _samplerate);
+        }
+#endif
+        if(m_frames == 0)
+        {
+            m_frames = decodeSampleDS(f, ibuf, channels, _samplerate);
+        }
+    }
+
+    delete[] f;
+    return !fileLoadError;
+}
+
 void SampleBuffer::update(bool _keepSettings)
 {
     // qInfo("SampleBuffer::update");
@@ -208,9 +437,15 @@ void SampleBuffer::update(bool _keepSettings)
         }
     }
 
-    // File size and sample length limits
-    const int fileSizeMax     = 1024;  // MB
-    const int sampleLengthMax = 90;    // Minutes
+    // the mappings are shared and stay until the project is cleared
+    if(m_mmapped)
+    {
+        m_origData   = nullptr;
+        m_origFrames = 0;
+        m_mmapped    = false;
+        m_data       = nullptr;
+        m_frames     = 0;
+    }
 
     sample_rate_t samplerate = Engine::mixer()->baseSampleRate();
     QString       cchext
@@ -218,8 +453,42 @@ void SampleBuffer::update(bool _keepSettings)
               + rawStereoSuffix();  // QString(".f%1r%2").arg(DEFAULT_CHANNELS).arg(samplerate);
     QString filename;
 
+    QString cachedKey;
+    QString cachedFile;
+    if(!m_audioFile.isEmpty())
+    {
+        const QString file = tryToMakeAbsolute(m_audioFile);
+
+        // the huge files are decoded chunk by chunk into their raw cache
+        // and played from there, they are never loaded in memory
+        if(!file.endsWith(cchext) && !QFile(file + cchext).exists()
+           && QFileInfo(file).size() > streamingSize())
+            decodeToCache(file, file + cchext, samplerate);
+
+        // the others are found decoded and transformed in the shared cache
+        if(SampleCache::isEnabled() && !file.endsWith(cchext)
+           && QFileInfo(file).size() <= streamingSize())
+        {
+            // the project loading may be decoding it already
+            waitForWarming(file);
+            cachedKey  = cacheKey(file, samplerate);
+            cachedFile = SampleCache::find(cachedKey);
+            if(!cachedFile.isEmpty() && !mapFile(cachedFile))
+                cachedFile.clear();
+        }
+    }
+
     bool fileLoadError = false;
-    if(m_audioFile.isEmpty() && m_origData != nullptr && m_origFrames > 0)
+    if(!cachedFile.isEmpty())
+    {
+        if(!_keepSettings)
+        {
+            m_loopStartFrame = m_startFrame = 0;
+            m_loopEndFrame = m_endFrame = m_frames;
+        }
+    }
+    else if(m_audioFile.isEmpty() && m_origData != nullptr
+            && m_origFrames > 0)
     {
         // qInfo("SampleBuffer::update copy origData %p to data
         // %p",m_origData,m_data);
@@ -247,66 +516,17 @@ void SampleBuffer::update(bool _keepSettings)
             filename += cchext;
         qInfo("SampleBuffer: Trying cache %s", qPrintable(filename));
 
-        /*
-        if(n%BYTES_PER_FRAME!=0)
-        {
-                fileLoadError=true;
-                qWarning("SampleBuffer: Invalid size %lld for
-        %s",n,qPrintable(filename));
-        }
-        else
-        */
-        if(s_mmap_pointer.contains(filename))  // m_data = MM_ALLOC(
-                                               // sampleFrame, m_origFrames );
+        if(mapFile(filename))
         {
-            quint64 n    = s_mmap_file.value(filename)->size();
-            m_origData   = s_mmap_pointer.value(filename);
-            m_origFrames = n / BYTES_PER_FRAME;
-            m_mmapped    = true;
-            m_data       = m_origData;
-            m_frames     = m_origFrames;
             if(!_keepSettings)
             {
                 m_loopStartFrame = m_startFrame = 0;
                 m_loopEndFrame = m_endFrame = m_frames;
             }
-            qInfo("SampleBuffer: File %s already mapped (%d frames,%lld "
-                  "bytes) %p",
-                  qPrintable(filename), m_frames, n, m_data);
-            // qInfo("--- testing #1 m_data[0][0]=%f",m_data[0][0]);
         }
         else
         {
-            QFile* file = new QFile(filename);
-            qint64 n    = file->size();
-            file->open(QFile::ReadOnly);
-            if(!(m_origData = (sampleFrame*)(file->map(0, n))))
-            {
-                delete file;
-                m_origFrames  = 0;
-                m_mmapped     = false;
-                fileLoadError = true;
-                qWarning("SampleBuffer: Fail to map %s",
-                         qPrintable(filename));
-            }
-            else
-            {
-                s_mmap_file.insert(filename, file);
-                s_mmap_pointer.insert(filename, m_origData);
-                m_origFrames = n / BYTES_PER_FRAME;
-                m_mmapped    = true;
-                m_data       = m_origData;
-                m_frames     = m_origFrames;
-                if(!_keepSettings)
-                {
-                    m_loopStartFrame = m_startFrame = 0;
-                    m_loopEndFrame = m_endFrame = m_frames;
-                }  // file.unmap();
-                qInfo("SampleBuffer: File %s mapped successfully (%d "
-                      "frames,%lld bytes) %p",
-                      qPrintable(filename), m_frames, n, m_data);
-                // qInfo("--- testing #2 m_data[0][0]=%f",m_data[0][0]);
-            }
+            fileLoadError = true;
         }
     }
     else if(!m_audioFile.isEmpty())
@@ -315,85 +535,7 @@ void SampleBuffer::update(bool _keepSettings)
             qWarning("SampleBuffer already has data...");
 
         QString filename = tryToMakeAbsolute(m_audioFile);
-#ifdef LMMS_BUILD_WIN32
-        char* f = qstrdup(filename.toLocal8Bit().constData());
-#else
-        char* f = qstrdup(filename.toUtf8().constData());
-#endif
-        sampleS16_t* ibuf     = nullptr;
-        sample_t*    fbuf     = nullptr;
-        ch_cnt_t     channels = DEFAULT_CHANNELS;
-
-        m_frames = 0;
-
-        const QFileInfo fileInfo(filename);
-        if(fileInfo.size() > fileSizeMax * 1024 * 1024)
-        {
-            fileLoadError = true;
-        }
-#ifdef LMMS_HAVE_MPG123
-        else if(filename.endsWith(".mp3"))
-        {
-            // fileLoadError=true;
-            m_frames = decodeSampleMPG123(f, fbuf, channels, samplerate);
-        }
-#endif
-        else
-        {
-            SNDFILE* snd_file;
-            SF_INFO  sf_info;
-            sf_info.format = 0;
-            if((snd_file = sf_open(f, SFM_READ, &sf_info)) != nullptr)
-            {
-                f_cnt_t frames = sf_info.frames;
-                int     rate   = sf_info.samplerate;
-                if(frames / rate > sampleLengthMax * 60)
-                {
-                    fileLoadError = true;
-                }
-                sf_close(snd_file);
-            }
-        }
-
-        if(!fileLoadError)
-        {
-            /*
-#ifdef LMMS_HAVE_MPG123
-            if( m_frames == 0 && fileInfo.suffix() == "mp3" )
-            {
-                    m_frames = decodeSampleMPG123( f, fbuf, channels,
-samplerate );
-            }
-#endif
-            */
-#ifdef LMMS_HAVE_OGGVORBIS
-            // workaround for a bug in libsndfile or our libsndfile decoder
-            // causing some OGG files to be distorted -> try with OGG Vorbis
-            // decoder first if filename extension matches "ogg"
-            if(m_frames == 0 && fileInfo.suffix() == "ogg")
-            {
-                m_frames = decodeSampleOGGVorbis(f, ibuf, channels,
-                                                 samplerate);
-            }
-#endif
-            if(m_frames == 0)
-            {
-                m_frames = decodeSampleSF(f, fbuf, channels, samplerate);
-            }
-#ifdef LMMS_HAVE_OGGVORBIS
-            if(m_frames == 0)
-            {
-                m_frames = decodeSampleOGGVorbis(f, ibuf, channels,
-                                                 samplerate);
-            }
-#endif
-            if(m_frames == 0)
-            {
-                m_frames = decodeSampleDS(f, ibuf, channels, samplerate);
-            }
-
-            delete[] f;
-        }
+        fileLoadError    = !decodeFile(filename, samplerate);
 
         if(m_frames == 0 || fileLoadError)  // if still no frames, bail
         {
@@ -492,7 +634,7 @@ samplerate );
         }
     }
 
-    if(!fileLoadError)
+    if(!fileLoadError && cachedFile.isEmpty())
     {
         if(m_stretching != 0.)
             stretch(exp2(m_stretching));
@@ -500,6 +642,11 @@ samplerate );
             predelay(m_predelay);
         if(m_postdelay != 0.)
             postdelay(m_postdelay);
+
+        // next time, the file is mapped from the cache
+        if(!cachedKey.isEmpty() && !m_mmapped && m_data != nullptr
+           && m_frames > 1)
+            SampleCache::store(cachedKey, m_data, m_frames);
     }
 
     if(lock)
@@ -515,8 +662,8 @@ samplerate );
         QString title   = tr("Fail to open file");
         QString message = tr("Audio files are limited to %1 MB "
                              "in size and %2 minutes of playing time")
-                                  .arg(fileSizeMax)
-                                  .arg(sampleLengthMax);
+                                  .arg(FILE_SIZE_MAX)
+                                  .arg(SAMPLE_LENGTH_MAX);
         if(gui)
         {
             QMessageBox::information(nullptr, title, message,
@@ -917,19 +1064,14 @@ f_cnt_t SampleBuffer::decodeSampleDS(const char*    _f,
     return frames;
 }
 
-static sample_t tmp_prefetch_for_mmapped_files = 0.;
-
-void SampleBuffer::prefetch(f_cnt_t _index)
+void SampleBuffer::prefetch(f_cnt_t _index, bool _backwards)
 {
-    if(!m_data)
+    // only the mapped caches are read from the disk while playing
+    if(!m_mmapped || m_data == nullptr || m_data != m_origData)
         return;
-    // prefetch. should be done in a separate thread
-    // 4096=typical OS page size / sizeof(sample_t) / nbch
-    for(int j = 1; j < 9; j++)
-    {
-        int i = qMax(0, qMin(m_frames - 1, _index + j * 512));
-        ::tmp_prefetch_for_mmapped_files = m_data[i][1];
-    }
+
+    SampleStreamer::inst()->request(m_data, qBound(0, _index, m_frames - 1),
+                                    _backwards);
 }
 
 f_cnt_t SampleBuffer::nextFrame(const f_cnt_t  _currentFrame,
@@ -1080,6 +1222,8 @@ bool SampleBuffer::play(sampleFrame*      _ab,
         return false;
     }
 
+    prefetch(_state->m_frameIndex, _state->isBackwards());
+
     const double freqFactor
             = (_freq == m_frequency
                && m_sampleRate == Engine::mixer()->processingSampleRate())
@@ -2392,26 +2536,201 @@ void SampleBuffer::setDataFrame(f_cnt_t _f, sample_t _ch0, sample_t _ch1)
 void SampleBuffer::writeCacheData(QString _fileName) const
 {
     qInfo("SampleBuffer: Write cache %s", qPrintable(_fileName));
-    QFile file(_fileName);
-    if(!file.open(QIODevice::WriteOnly))
+    // written aside then renamed, the cache may be mapped by another
+    // process
+    QFile file(QString("%1.%2.part")
+                       .arg(_fileName)
+                       .arg(QCoreApplication::applicationPid()));
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
         qCritical("SampleBuffer: Can not write %s", qPrintable(_fileName));
     else
     {
-        // if(m_origData) qFatal("SampleBuffer::update in write cache
-        // origData=%p",m_origData); m_origData=nullptr; m_origFrames=0;
-
         QDataStream out(&file);
         quint64     n = m_frames * BYTES_PER_FRAME;
         quint64     w = out.writeRawData((const char*)m_data, n);
+        file.close();
         if(n != w)
+        {
             qWarning("SampleBuffer: Fail to fully write %s",
                      qPrintable(_fileName));
+            file.remove();
+        }
+        else if(!QFile::remove(_fileName) && QFile::exists(_fileName))
+        {
+            qWarning("SampleBuffer: Can not replace %s",
+                     qPrintable(_fileName));
+            file.remove();
+        }
+        else if(!file.rename(_fileName))
+        {
+            qWarning("SampleBuffer: Can not write %s",
+                     qPrintable(_fileName));
+            file.remove();
+        }
         else
             qInfo("SampleBuffer: Cache written %s", qPrintable(_fileName));
-        file.close();
     }
 }
 
+bool SampleBuffer::decodeToCache(const QString&      _file,
+                                 const QString&      _cache,
+                                 const sample_rate_t _samplerate)
+{
+    SF_INFO sf_info;
+    sf_info.format = 0;
+#ifdef LMMS_BUILD_WIN32
+    SNDFILE* snd_file = sf_open(_file.toLocal8Bit().constData(), SFM_READ,
+                                &sf_info);
+#else
+    SNDFILE* snd_file
+            = sf_open(_file.toUtf8().constData(), SFM_READ, &sf_info);
+#endif
+    if(snd_file == nullptr)
+        return false;
+
+    // written aside, so an interrupted decoding leaves no cache. The name
+    // is unique, another process may decode the same file.
+    QFile out(QString("%1.%2.part")
+                      .arg(_cache)
+                      .arg(QCoreApplication::applicationPid()));
+    if(!out.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning("SampleBuffer: Can not write %s", qPrintable(out.fileName()));
+        sf_close(snd_file);
+        return false;
+    }
+
+    qInfo("SampleBuffer: Stream %s into %s", qPrintable(_file),
+          qPrintable(_cache));
+
+    const f_cnt_t chunk    = SampleStreamer::CHUNK_FRAMES;
+    const int     channels = sf_info.channels;
+    const int     ch       = (channels > 1) ? 1 : 0;
+    const double  ratio    = double(_samplerate) / sf_info.samplerate;
+    const f_cnt_t outSize  = f_cnt_t(ceil(chunk * ratio)) + 64;
+
+    FLOAT*       ibuf = new FLOAT[chunk * channels];
+    sampleFrame* sbuf = MM_ALLOC(sampleFrame, chunk);
+    sampleFrame* rbuf = MM_ALLOC(sampleFrame, outSize);
+
+    int        error = 0;
+    SRC_STATE* state = nullptr;
+    if(_samplerate != sf_info.samplerate)
+        state = src_new(SRC_SINC_MEDIUM_QUALITY, DEFAULT_CHANNELS, &error);
+
+    bool    ok      = (error == 0);
+    f_cnt_t written = 0;
+    while(ok)
+    {
+        const f_cnt_t n = sf_readf_float(snd_file, ibuf, chunk);
+        if(n <= 0)
+            break;
+
+        for(f_cnt_t f = 0; f < n; ++f)
+        {
+            sbuf[f][0] = ibuf[f * channels + 0];
+            sbuf[f][1] = ibuf[f * channels + ch];
+        }
+        MixHelpers::sanitize(sbuf, n);
+        MixHelpers::unclip(sbuf, n);
+
+        // the resampler may not take the whole chunk at once
+        f_cnt_t used = 0;
+        while(ok && used < n)
+        {
+            const sampleFrame* data   = sbuf + used;
+            f_cnt_t            frames = n - used;
+            if(state != nullptr)
+            {
+                f_cnt_t ifu = 0, ofg = 0;
+                SampleRate::resample(sbuf + used, rbuf, n - used, outSize,
+                                     ratio, 10, ifu, ofg, state);
+                if(ifu == 0 && ofg == 0)
+                    break;
+                used += ifu;
+                data   = rbuf;
+                frames = ofg;
+                MixHelpers::sanitize(rbuf, frames);
+            }
+            else
+            {
+                used = n;
+            }
+
+            const qint64 bytes = qint64(frames) * BYTES_PER_FRAME;
+            ok = (out.write((const char*)data, bytes) == bytes);
+            written += frames;
+        }
+    }
+
+    // the resampler holds the last frames of the source for its filter,
+    // they only come out once the end of the input is signalled
+    if(ok && state != nullptr)
+    {
+        FLOAT  none[DEFAULT_CHANNELS] = {0.f, 0.f};
+        FLOAT* obuf                   = new FLOAT[outSize * DEFAULT_CHANNELS];
+        while(ok)
+        {
+            SRC_DATA src_data;
+            src_data.data_in       = none;
+            src_data.data_out      = obuf;
+            src_data.input_frames  = 0;
+            src_data.output_frames = outSize;
+            src_data.src_ratio     = ratio;
+            src_data.end_of_input  = 1;
+            if((error = src_process(state, &src_data)))
+            {
+                qWarning("SampleBuffer: error while resampling: %s",
+                         src_strerror(error));
+                ok = false;
+                break;
+            }
+
+            const f_cnt_t frames = src_data.output_frames_gen;
+            if(frames == 0)
+                break;
+
+            for(f_cnt_t f = 0; f < frames; ++f)
+            {
+                rbuf[f][0] = obuf[f * DEFAULT_CHANNELS + 0];
+                rbuf[f][1] = obuf[f * DEFAULT_CHANNELS + 1];
+            }
+            MixHelpers::sanitize(rbuf, frames);
+
+            const qint64 bytes = qint64(frames) * BYTES_PER_FRAME;
+            ok = (out.write((const char*)rbuf, bytes) == bytes);
+            written += frames;
+        }
+        delete[] obuf;
+    }
+
+    if(state != nullptr)
+        src_delete(state);
+    MM_FREE(rbuf);
+    MM_FREE(sbuf);
+    delete[] ibuf;
+    sf_close(snd_file);
+    out.close();
+
+    if(!ok || written == 0)
+    {
+        qWarning("SampleBuffer: Fail to stream %s", qPrintable(_file));
+        out.remove();
+        return false;
+    }
+
+    QFile::remove(_cache);
+    if(!out.rename(_cache))
+    {
+        out.remove();
+        return false;
+    }
+
+    qInfo("SampleBuffer: Cache written %s (%d frames)", qPrintable(_cache),
+          written);
+    return true;
+}
+
 QString SampleBuffer::tryToMakeRelative(const QString& file)
 {
     if(QFileInfo(file).isRelative() == false)
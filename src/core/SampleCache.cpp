@@ -0,0 +1,198 @@
+/*
+ * SampleCache.cpp - shared on-disk cache of the decoded samples
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SampleCache.h"
+
+#include "ConfigManager.h"
+#include "lmmsconfig.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStandardPaths>
+
+#ifndef LMMS_BUILD_WIN32
+#include <utime.h>
+#endif
+
+namespace SampleCache
+{
+
+// the whole content is hashed, read by chunks. The cached files are
+// smaller than mixer/samplestreamingmb and the hash is kept for the
+// session.
+static const qint64 CHUNK = 1024 * 1024;
+
+static QMutex                  s_mutex;
+static QHash<QString, QString> s_contentKeys;  // path:size:time -> hash
+
+static QString directory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+           + "/samples/";
+}
+
+static QString contentKey(const QString& _file)
+{
+    const QFileInfo fi(_file);
+    const QString   id = QString("%1:%2:%3")
+                               .arg(fi.absoluteFilePath())
+                               .arg(fi.size())
+                               .arg(fi.lastModified().toMSecsSinceEpoch());
+
+    {
+        QMutexLocker locker(&s_mutex);
+        if(s_contentKeys.contains(id))
+            return s_contentKeys.value(id);
+    }
+
+    // hashed outside of the lock, the files are hashed in parallel
+    QFile f(_file);
+    if(!f.open(QIODevice::ReadOnly))
+        return QString();
+
+    QCryptographicHash h(QCryptographicHash::Sha1);
+    h.addData(QByteArray::number(f.size()));
+    while(!f.atEnd())
+    {
+        const QByteArray chunk = f.read(CHUNK);
+        if(chunk.isEmpty())
+            return QString();
+        h.addData(chunk);
+    }
+
+    const QString r = h.result().toHex();
+    QMutexLocker  locker(&s_mutex);
+    s_contentKeys.insert(id, r);
+    return r;
+}
+
+// the least recently used entries go first
+static void evict(const qint64 _max)
+{
+    QDir dir(directory());
+    const QFileInfoList entries = dir.entryInfoList(
+            QStringList("*.raw"), QDir::Files, QDir::Time | QDir::Reversed);
+
+    qint64 total = 0;
+    for(const QFileInfo& fi: entries)
+        total += fi.size();
+
+    for(const QFileInfo& fi: entries)
+    {
+        if(total <= _max)
+            break;
+        // the processes mapping it keep their copy
+        if(QFile::remove(fi.absoluteFilePath()))
+        {
+            total -= fi.size();
+            qInfo("SampleCache: evict %s", qPrintable(fi.fileName()));
+        }
+    }
+}
+
+bool isEnabled()
+{
+    return ConfigManager::inst()
+            ->value("mixer", "samplediskcache", "1")
+            .toInt();
+}
+
+QString key(const QString& _file, const QString& _params)
+{
+    const QString content = contentKey(_file);
+    if(content.isEmpty())
+        return QString();
+
+    // the raw frames depend on the build too
+    QCryptographicHash h(QCryptographicHash::Sha1);
+    h.addData(content.toLatin1());
+    h.addData(_params.toUtf8());
+    h.addData(QByteArray::number(int(sizeof(sampleFrame))));
+    return h.result().toHex();
+}
+
+QString find(const QString& _key)
+{
+    const QString path = directory() + _key + ".raw";
+    if(!QFileInfo(path).isFile())
+        return QString();
+
+#ifndef LMMS_BUILD_WIN32
+    // the time of the last use, for the eviction
+    utime(QFile::encodeName(path).constData(), nullptr);
+#endif
+    return path;
+}
+
+bool store(const QString&     _key,
+           const sampleFrame* _data,
+           const f_cnt_t      _frames)
+{
+    if(_key.isEmpty() || _data == nullptr || _frames <= 0)
+        return false;
+
+    if(!QDir().mkpath(directory()))
+        return false;
+
+    const QString path = directory() + _key + ".raw";
+    // unique name, several processes may store the same entry
+    QFile out(QString("%1.%2.part")
+                      .arg(path)
+                      .arg(QCoreApplication::applicationPid()));
+    if(!out.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    const qint64 n = qint64(_frames) * sizeof(sampleFrame);
+    const bool   ok
+            = (out.write(reinterpret_cast<const char*>(_data), n) == n);
+    out.close();
+
+    if(!ok)
+    {
+        out.remove();
+        return false;
+    }
+
+    // another process may have stored it meanwhile
+    if(QFileInfo(path).exists() || !out.rename(path))
+    {
+        out.remove();
+        return QFileInfo(path).exists();
+    }
+
+    qInfo("SampleCache: store %s (%d frames)", qPrintable(_key), _frames);
+
+    evict(qint64(ConfigManager::inst()
+                         ->value("mixer", "samplediskcachemb", "4096")
+                         .toInt())
+          * 1024 * 1024);
+    return true;
+}
+
+};  // namespace SampleCache
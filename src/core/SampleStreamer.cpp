@@ -0,0 +1,271 @@
+/*
+ * SampleStreamer.cpp - keeps the played parts of the mapped sample caches
+ *                      in memory
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SampleStreamer.h"
+
+#include "ConfigManager.h"
+#include "lmmsconfig.h"
+
+#ifndef LMMS_BUILD_WIN32
+#include <sys/mman.h>
+#endif
+
+const f_cnt_t   SampleStreamer::CHUNK_FRAMES;
+SampleStreamer* SampleStreamer::s_instance = nullptr;
+
+// read by load(), so the compiler keeps the page reads
+static volatile sample_t s_touched = 0.;
+
+SampleStreamer* SampleStreamer::inst()
+{
+    if(s_instance == nullptr)
+    {
+        s_instance = new SampleStreamer();
+        s_instance->start(QThread::LowPriority);
+    }
+    return s_instance;
+}
+
+void SampleStreamer::cleanup()
+{
+    if(s_instance == nullptr)
+        return;
+
+    s_instance->m_stop = true;
+    s_instance->m_wakeMutex.lock();
+    s_instance->m_wake.wakeAll();
+    s_instance->m_wakeMutex.unlock();
+    s_instance->wait();
+    s_instance->clear();
+    delete s_instance;
+    s_instance = nullptr;
+}
+
+SampleStreamer::SampleStreamer() :
+      m_requests(1024), m_stop(false), m_sleeping(false), m_clock(0),
+      m_budget(qint64(qMax(16, ConfigManager::inst()
+                                       ->value("mixer", "samplecachemb",
+                                               "1024")
+                                       .toInt()))
+               * 1024 * 1024),
+      m_readAhead(4)
+{
+    setObjectName("sample streamer");
+    m_stats.hits          = 0;
+    m_stats.misses        = 0;
+    m_stats.prefetched    = 0;
+    m_stats.evicted       = 0;
+    m_stats.residentBytes = 0;
+}
+
+SampleStreamer::~SampleStreamer()
+{
+    LocklessList<Request>::Element* e = m_requests.popList();
+    while(e != nullptr)
+    {
+        LocklessList<Request>::Element* next = e->next;
+        m_requests.free(e);
+        e = next;
+    }
+}
+
+void SampleStreamer::addMapping(const sampleFrame* _base,
+                                const f_cnt_t      _frames)
+{
+    QMutexLocker locker(&m_mutex);
+    m_mappings.insert(_base, _frames);
+}
+
+void SampleStreamer::removeMapping(const sampleFrame* _base)
+{
+    QMutexLocker locker(&m_mutex);
+    for(auto it = m_resident.begin(); it != m_resident.end();)
+    {
+        if(it.key().first == _base)
+        {
+            m_stats.residentBytes -= chunkBytes(it.key());
+            it = m_resident.erase(it);
+        }
+        else
+            ++it;
+    }
+    m_mappings.remove(_base);
+}
+
+void SampleStreamer::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    if(!m_mappings.isEmpty())
+        qInfo("SampleStreamer: %lld hits, %lld misses, %lld prefetched, "
+              "%lld evicted, %lld MB resident",
+              m_stats.hits, m_stats.misses, m_stats.prefetched,
+              m_stats.evicted, m_stats.residentBytes / (1024 * 1024));
+
+    m_mappings.clear();
+    m_resident.clear();
+    m_stats.residentBytes = 0;
+}
+
+bool SampleStreamer::request(const sampleFrame* _base,
+                             const f_cnt_t      _index,
+                             const bool         _backwards)
+{
+    Request r;
+    r.base      = _base;
+    r.index     = _index;
+    r.backwards = _backwards;
+    if(!m_requests.tryPush(r))
+        return false;
+
+    // the lock is only held by the streamer while it goes to sleep
+    if(m_sleeping.exchange(false))
+    {
+        QMutexLocker locker(&m_wakeMutex);
+        m_wake.wakeOne();
+    }
+    return true;
+}
+
+SampleStreamer::Stats SampleStreamer::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+void SampleStreamer::run()
+{
+    while(!m_stop)
+    {
+        LocklessList<Request>::Element* e = m_requests.popList();
+        if(e == nullptr)
+        {
+            // checked again once the players know the streamer sleeps,
+            // so a request pushed meanwhile wakes it up
+            m_wakeMutex.lock();
+            m_sleeping.store(true);
+            e = m_requests.popList();
+            if(e == nullptr && !m_stop)
+                m_wake.wait(&m_wakeMutex);
+            m_sleeping.store(false);
+            m_wakeMutex.unlock();
+            if(e == nullptr)
+                continue;
+        }
+
+        QMutexLocker locker(&m_mutex);
+        while(e != nullptr)
+        {
+            LocklessList<Request>::Element* next = e->next;
+            serve(e->value);
+            m_requests.free(e);
+            e = next;
+        }
+    }
+}
+
+void SampleStreamer::serve(const Request& _r)
+{
+    if(!m_mappings.contains(_r.base))
+        return;
+
+    const f_cnt_t frames = m_mappings.value(_r.base);
+    const int     last   = (frames - 1) / CHUNK_FRAMES;
+    const int     chunk  = qBound(0, _r.index / CHUNK_FRAMES, last);
+
+    touch(ChunkKey(_r.base, chunk), true);
+    for(int i = 1; i <= m_readAhead; ++i)
+    {
+        const int c = _r.backwards ? chunk - i : chunk + i;
+        if(c < 0 || c > last)
+            break;
+        touch(ChunkKey(_r.base, c), false);
+    }
+}
+
+void SampleStreamer::touch(const ChunkKey& _key, bool _played)
+{
+    auto it = m_resident.find(_key);
+    if(it != m_resident.end())
+    {
+        it.value() = ++m_clock;
+        if(_played)
+            ++m_stats.hits;
+        return;
+    }
+
+    if(_played)
+        ++m_stats.misses;
+    else
+        ++m_stats.prefetched;
+
+    load(_key);
+    m_resident.insert(_key, ++m_clock);
+    m_stats.residentBytes += chunkBytes(_key);
+
+    // least recently used first, the chunk just loaded is the most recent
+    while(m_stats.residentBytes > m_budget && m_resident.size() > 1)
+    {
+        auto oldest = m_resident.begin();
+        for(auto i = m_resident.begin(); i != m_resident.end(); ++i)
+            if(i.value() < oldest.value())
+                oldest = i;
+
+        const ChunkKey key = oldest.key();
+        m_resident.erase(oldest);
+        m_stats.residentBytes -= chunkBytes(key);
+        ++m_stats.evicted;
+        evict(key);
+    }
+}
+
+qint64 SampleStreamer::chunkBytes(const ChunkKey& _key) const
+{
+    const f_cnt_t frames = m_mappings.value(_key.first);
+    const f_cnt_t start  = f_cnt_t(_key.second) * CHUNK_FRAMES;
+    return qint64(qMin(CHUNK_FRAMES, frames - start)) * sizeof(sampleFrame);
+}
+
+void SampleStreamer::load(const ChunkKey& _key)
+{
+    const sampleFrame* data = _key.first + _key.second * CHUNK_FRAMES;
+    const qint64       n    = chunkBytes(_key);
+#ifndef LMMS_BUILD_WIN32
+    madvise((void*)data, n, MADV_WILLNEED);
+#endif
+    // one read per page brings the chunk in memory
+    const int step = 4096 / sizeof(sampleFrame);
+    for(f_cnt_t f = 0; f < n / f_cnt_t(sizeof(sampleFrame)); f += step)
+        s_touched = data[f][0];
+}
+
+void SampleStreamer::evict(const ChunkKey& _key)
+{
+#ifndef LMMS_BUILD_WIN32
+    // the mapping is read only: the pages are read again from the file
+    // if they are played later
+    const sampleFrame* data = _key.first + _key.second * CHUNK_FRAMES;
+    madvise((void*)data, chunkBytes(_key), MADV_DONTNEED);
+#else
+    Q_UNUSED(_key)
+#endif
+}
@@ -46,6 +46,7 @@
 #include "PianoRoll.h"
 #include "ProjectJournal.h"
 #include "ProjectNotes.h"  // REQUIRED
+#include "SampleBuffer.h"
 #include "SongEditor.h"
 #include "TextFloat.h"
 #include "TimeLineWidget.h"
@@ -54,12 +55,14 @@
 //#include "MemoryManagerArray.h"
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QTextStream>
 //#include <QDebug>
 #include <QFile>
 #include <QFileInfo>
 #include <QMessageBox>
 
+#include <algorithm>
 #include <functional>
 
 Song::Song() :
@@ -111,6 +114,7 @@ Song::~Song()
 {
     qInfo("Song::~Song 1");
     m_playing = false;
+    clearAutomationBuffers();
     MM_ACTIVE(false)
     qInfo("Song::~Song 2");
     // HAT deleted by the container
@@ -457,12 +461,28 @@ void Song::processNextBuffer()
                                    framesToPlay);
             }
 
+            renderAutomations(framesPlayed, currentFrame, framesToPlay);
+
             // qInfo("Song::play tl=%d pos=%s", trackList.size(),
             //      qPrintable(pos.toString()));
             for(int i = 0; i < trackList.size(); ++i)
                 trackList[i]->play(pos, framesToPlay, framesPlayed, tcoNum);
             m_playMode = old;
         }
+        else
+        {
+            // the period starts inside a tick
+            if(framesPlayed == 0)
+            {
+                MidiTime pos = m_playPos[m_playMode];
+                if(m_playMode == Mode_PlayAutomation)
+                    pos += m_automationToPlay->startPosition();
+                else if(m_playMode == Mode_PlayPattern)
+                    pos += m_patternToPlay->startPosition();
+                collectAutomations(trackList, pos);
+            }
+            renderAutomations(framesPlayed, currentFrame, framesToPlay);
+        }
 
         // update frame-counters
         framesPlayed += framesToPlay;
@@ -475,16 +495,14 @@ void Song::processNextBuffer()
         m_elapsedTicks
                 = (m_playPos[Mode_PlaySong].getTicks() % ticksPerTact()) / 48;
     }
+
+    flushAutomations();
 }
 
 void Song::processAutomations(const TrackList& tracklist,
                               MidiTime         timeStart,
                               fpp_t)
 {
-    // AutomatedValueMap values;
-
-    QSet<const AutomatableModel*> recordedModels;
-
     TrackContainer* container = this;
     int             tcoNum    = -1;
 
@@ -508,10 +526,7 @@ void Song::processAutomations(const TrackList& tracklist,
             return;
     }
 
-    // values = container->automatedValuesAt(timeStart, tcoNum);
-    m_automatedValues.clear();
-    container->automatedValuesAt(timeStart, tcoNum, m_automatedValues);
-    // qInfo("automated values: %d",m_automatedValues.size());
+    collectAutomations(tracklist, timeStart);
 
     const Tracks& tracks = container->tracks();
 
@@ -538,24 +553,147 @@ void Song::processAutomations(const TrackList& tracklist,
             // qInfo("Song record %f %f",v1,v2);
             p->emit recordValue(relTime, v2);
 
-            recordedModels << recordedModel;
+            m_recordedModels << recordedModel;
+        }
+    }
+
+    // the values are applied by renderAutomations()
+}
+
+// find the pattern driving each automated model at timeStart
+void Song::collectAutomations(const TrackList& tracklist, MidiTime timeStart)
+{
+    m_automatedSources.clear();
+    m_recordedModels.clear();
+
+    TrackContainer* container = this;
+    int             tcoNum    = -1;
+
+    if(m_playMode == Mode_PlayBB)
+    {
+        auto bbTrack = qobject_cast<BBTrack*>(tracklist.at(0));
+        container    = Engine::getBBTrackContainer();
+        tcoNum       = bbTrack->ownBBTrackIndex();
+    }
+
+    container->automatedSourcesAt(timeStart, tcoNum, m_automatedSources);
+}
+
+// render the automation of the frames [_offset,_offset+_frames[ of the
+// period, _currentFrame being the position of _offset inside the tick
+void Song::renderAutomations(f_cnt_t _offset,
+                             real_t  _currentFrame,
+                             fpp_t   _frames)
+{
+    if(m_automatedSources.isEmpty())
+        return;
+
+    const fpp_t  fpp    = Engine::mixer()->framesPerPeriod();
+    const long   period = AutomatableModel::periodCounter();
+    const real_t step   = 1. / Engine::framesPerTick();
+
+    for(auto it = m_automatedSources.constBegin();
+        it != m_automatedSources.constEnd(); ++it)
+    {
+        AutomatableModel* m = it.key();
+        if(m == nullptr || m_recordedModels.contains(m))
+            continue;
+
+        AutomationBuffer* ab = m_automationBuffers.value(m, nullptr);
+        if(ab == nullptr || ab->model != m || ab->values.length() != fpp)
+        {
+            // first time this model is automated, a destroyed model had
+            // the same address, or the period size changed
+            delete ab;
+            ab          = new AutomationBuffer(m, fpp);
+            ab->channel = Engine::fxMixer()->channelOf(m);
+            m_automationBuffers.insert(m, ab);
         }
+
+        if(ab->period != period)
+        {
+            ab->period = period;
+            ab->filled = 0;
+            m_renderedAutomations.append(ab);
+        }
+
+        // the audio reaching a fx channel is late by its input latency,
+        // so is the automation of the effects of the channel
+        real_t time = it.value().time + _currentFrame * step;
+        if(ab->channel != nullptr)
+            time = qMax(time - ab->channel->inputLatency() * step,
+                        real_t(0.));
+
+        real_t* values = ab->values.values();
+        it.value().pattern->renderValues(time, step, values + _offset,
+                                         _frames);
+
+        // automated since the middle of the period, hold the first value
+        for(f_cnt_t f = ab->filled; f < _offset; ++f)
+            values[f] = values[_offset];
+        ab->filled = _offset + _frames;
+    }
+}
+
+// periods a buffer is kept unused before checking if its model is still
+// automated
+static const long AUTOMATION_CHECK_PERIODS = 1024;
+
+// hand the rendered buffers over to the models
+void Song::flushAutomations()
+{
+    const fpp_t fpp    = Engine::mixer()->framesPerPeriod();
+    const long  period = AutomatableModel::periodCounter();
+
+    for(AutomationBuffer* ab: m_renderedAutomations)
+    {
+        // not automated anymore at the end of the period, hold the last
+        // value
+        real_t* values = ab->values.values();
+        for(f_cnt_t f = qMax(ab->filled, f_cnt_t(1)); f < fpp; ++f)
+            values[f] = values[ab->filled - 1];
+
+        ab->values.setPeriod(ab->period);
+        ab->model->setAutomatedBuffer(&ab->values);
     }
+    m_renderedAutomations.clear();
 
-    // Apply values
-    for(auto it = m_automatedValues.begin(); it != m_automatedValues.end();
-        it++)  // values
+    // drop the buffers of the destroyed models and of the models whose
+    // automation was removed
+    for(auto it = m_automationBuffers.begin();
+        it != m_automationBuffers.end();)
     {
-        auto m = it.key();
-        if(!m)
+        AutomationBuffer* ab = it.value();
+        if(ab->model.isNull())
+        {
+            delete ab;
+            it = m_automationBuffers.erase(it);
             continue;
-        if(!recordedModels.contains(m))
+        }
+
+        if(period - qMax(ab->period, ab->checked) > AUTOMATION_CHECK_PERIODS)
         {
-            m->setAutomatedValue(it.value());
+            if(!ab->model->isAutomated())
+            {
+                delete ab;
+                it = m_automationBuffers.erase(it);
+                continue;
+            }
+            ab->checked = period;
         }
+        ++it;
     }
 }
 
+void Song::clearAutomationBuffers()
+{
+    m_automatedSources.clear();
+    m_recordedModels.clear();
+    m_renderedAutomations.clear();
+    qDeleteAll(m_automationBuffers);
+    m_automationBuffers.clear();
+}
+
 std::pair<MidiTime, MidiTime> Song::getExportEndpoints() const
 {
     if(m_renderBetweenMarkers)
@@ -904,6 +1042,10 @@ void Song::clearProject()
     if(m_playing)
         stop();
 
+    Engine::mixer()->requestChangeInModel();
+    clearAutomationBuffers();
+    Engine::mixer()->doneChangeInModel();
+
     for(int i = 0; i < Mode_Count; i++)
         setPlayPos(0, (PlayModes)i);
 
@@ -1090,6 +1232,29 @@ void Song::createNewProjectFromTemplate(const QString& templ)
         gui->mainWindow()->resetWindowTitle();
 }
 
+void Song::addLoadProfile(const QString& _what, const qint64 _ms)
+{
+    m_loadProfile.append(qMakePair(_what, _ms));
+}
+
+// the audio files of the sample tiles and of the sample players, in the
+// order they are loaded
+static QStringList projectSampleFiles(const QDomElement& _content)
+{
+    QStringList r;
+    for(const char* tag: {"sampletco", "audiofileprocessor"})
+    {
+        const QDomNodeList nodes = _content.elementsByTagName(tag);
+        for(int i = 0; i < nodes.count(); ++i)
+        {
+            const QString src = nodes.at(i).toElement().attribute("src");
+            if(!src.isEmpty() && !r.contains(src))
+                r.append(src);
+        }
+    }
+    return r;
+}
+
 // load given song
 void Song::loadProject(const QString& fileName)
 {
@@ -1119,7 +1284,11 @@ void Song::loadProject(const QString& fileName)
 
     m_oldFileName = m_fileName;
 
+    QElapsedTimer loadTimer;
+    loadTimer.start();
+
     clearProject();
+    m_loadProfile.clear();
 
     clearErrors();
 
@@ -1199,6 +1368,13 @@ void Song::loadProject(const QString& fileName)
         }
     }
 
+    // the samples are decoded in the background while the tracks and
+    // the plugins are created, the tracks then map them from the disk
+    // cache instead of decoding them again
+    const QStringList sampleFiles = projectSampleFiles(dataFile.content());
+    for(const QString& file: sampleFiles)
+        SampleBuffer::warmCache(file);
+
     // load the different sections
     {
         QDomNode node = dataFile.content().firstChild();
@@ -1277,6 +1453,8 @@ void Song::loadProject(const QString& fileName)
         }
     }
 
+    SampleBuffer::waitForWarmCache(isCancelled());
+
     // qInfo("Song::loadProject 0");
     // quirk for fixing projects with broken positions of TCOs inside
     // BB-tracks
@@ -1331,6 +1509,19 @@ void Song::loadProject(const QString& fileName)
         }
     }
 
+    // the slowest tracks first
+    std::sort(m_loadProfile.begin(), m_loadProfile.end(),
+              [](const QPair<QString, qint64>& a,
+                 const QPair<QString, qint64>& b) {
+                  return a.second > b.second;
+              });
+    qInfo("Song: %s loaded in %lld ms, %d tracks, %d samples",
+          qPrintable(fileName), loadTimer.elapsed(), m_loadProfile.size(),
+          sampleFiles.size());
+    for(int i = 0; i < qMin(10, m_loadProfile.size()); ++i)
+        qInfo("  %6lld ms  %s", m_loadProfile.at(i).second,
+              qPrintable(m_loadProfile.at(i).first));
+
     // qInfo("Song::loadProject 6");
     m_loadingProject = false;
     m_modified       = false;
@@ -1550,7 +1741,7 @@ QString Song::projectDir()
     QFileInfo fi(fname);
     QString   fs = fi.suffix().toLower();
     qInfo("Song::projectDir suffix is %s", qPrintable(fs));
-    if((fs != "mmp") && (fs != "mmpz"))
+    if((fs != "mmp") && (fs != "mmpz") && (fs != "lsmmb"))
     {
         qWarning("Song::projectDir invalid project suffix: %s",
                  qPrintable(fi.suffix()));
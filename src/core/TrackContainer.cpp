@@ -38,6 +38,7 @@
 
 #include <QCoreApplication>
 #include <QDomElement>
+#include <QElapsedTimer>
 #include <QProgressDialog>
 #include <QWriteLocker>
 
@@ -136,7 +137,20 @@ void TrackContainer::loadSettings(const QDomElement& _this)
                                 .arg(Engine::getSong()
                                              ->getLoadingTrackCount()));
             }
-            Track::create(e, this);
+            QElapsedTimer timer;
+            timer.start();
+            const Track* t = Track::create(e, this);
+            if(t != nullptr && !journalRestore)
+            {
+                // the instrument is most of the time of its track
+                const InstrumentTrack* it
+                        = dynamic_cast<const InstrumentTrack*>(t);
+                const QString what
+                        = it != nullptr ? QString("%1 (%2)").arg(
+                                  trackName, it->instrumentName())
+                                        : trackName;
+                Engine::getSong()->addLoadProfile(what, timer.elapsed());
+            }
         }
         e = e.nextSiblingElement("track");
     }
@@ -306,11 +320,65 @@ void TrackContainer::automatedValuesAt(MidiTime           _time,
     automatedValuesFromTracks(tracks(), _time, _bb, _map);
 }
 
+void TrackContainer::automatedSourcesAt(MidiTime            _time,
+                                        int                 _bb,
+                                        AutomatedSourceMap& _map) const
+{
+    automatedSourcesFromTracks(tracks(), _time, _bb, _map);
+}
+
 // AutomatedValueMap
 void TrackContainer::automatedValuesFromTracks(const Tracks&      _tracks,
                                                MidiTime           _time,
                                                int                _bb,
                                                AutomatedValueMap& _map)
+{
+    automatedFromTracks(_tracks, _time, _bb, _map);
+}
+
+void TrackContainer::automatedSourcesFromTracks(const Tracks&       _tracks,
+                                                MidiTime            _time,
+                                                int                 _bb,
+                                                AutomatedSourceMap& _map)
+{
+    automatedFromTracks(_tracks, _time, _bb, _map);
+}
+
+static INLINE void automatedFromPattern(AutomationPattern* _p,
+                                        const MidiTime&    _time,
+                                        AutomatedValueMap& _map)
+{
+    _p->automatedValuesAt(_time, _map);
+}
+
+static INLINE void automatedFromPattern(AutomationPattern*  _p,
+                                        const MidiTime&     _time,
+                                        AutomatedSourceMap& _map)
+{
+    _p->automatedSourcesAt(_time, _map);
+}
+
+static INLINE void automatedFromBB(const BBTrackContainer* _c,
+                                   const MidiTime&         _time,
+                                   int                     _bb,
+                                   AutomatedValueMap&      _map)
+{
+    _c->automatedValuesAt(_time, _bb, _map);
+}
+
+static INLINE void automatedFromBB(const BBTrackContainer* _c,
+                                   const MidiTime&         _time,
+                                   int                     _bb,
+                                   AutomatedSourceMap&     _map)
+{
+    _c->automatedSourcesAt(_time, _bb, _map);
+}
+
+template <typename M>
+void TrackContainer::automatedFromTracks(const Tracks& _tracks,
+                                         MidiTime      _time,
+                                         int           _bb,
+                                         M&            _map)
 {
     Tiles tcos;
 
@@ -380,7 +448,7 @@ void TrackContainer::automatedValuesFromTracks(const Tracks&      _tracks,
 
             // real_t value = p->valueAt(relTime);
             // for(AutomatableModel* model: p->objects())
-            p->automatedValuesAt(relTime, _map);
+            automatedFromPattern(p, relTime, _map);
         }
         else if(auto* bb = dynamic_cast<BBTCO*>(tco))
         {
@@ -394,7 +462,7 @@ void TrackContainer::automatedValuesFromTracks(const Tracks&      _tracks,
                      % (bbContainer->lengthOfBB(bbIndex)
                         * MidiTime::ticksPerTact());
 
-            bbContainer->automatedValuesAt(bbTime, bbIndex, _map);
+            automatedFromBB(bbContainer, bbTime, bbIndex, _map);
             /*
             auto bbValues = bbContainer->automatedValuesAt(bbTime, bbIndex);
             for (auto it=bbValues.begin(); it != bbValues.end(); it++)
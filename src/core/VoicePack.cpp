@@ -0,0 +1,343 @@
+/*
+ * VoicePack.cpp - oscillator voices rendered together
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "VoicePack.h"
+
+#include "AutomatableModel.h"
+#include "Engine.h"
+#include "Mixer.h"
+#include "WaveFormStandard.h"
+
+// no sub pack, the voices are not modulated
+static const int NoModulation = Oscillator::NumModulationAlgos;
+
+// same as positivefraction() without the call to floor(), the phases are
+// small: they are brought back near 2 at each period
+static INLINE real_t phaseFraction(const real_t _x)
+{
+    if(!(abs(_x) < 1073741824.))
+        return positivefraction(_x);
+
+    real_t t = real_t(int(_x));
+    if(t > _x)
+        t -= 1.;
+    return _x - t;
+}
+
+// the standard waves are read from their tables in one loop, the phases
+// are made positive in place
+static INLINE void standardSamples(const WaveForm* _wave,
+                                   real_t*         _x,
+                                   real_t*         _r,
+                                   const int       _n)
+{
+    for(int k = 0; k < _n; ++k)
+        _x[k] = phaseFraction(_x[k]);
+    _wave->f(_x, _r, _n);
+}
+
+template <>
+inline void VoicePack::getSamples<Oscillator::SineWave>(real_t*   _x,
+                                                        real_t*   _r,
+                                                        const int _n) const
+{
+    standardSamples(WaveFormStandard::SINE, _x, _r, _n);
+}
+
+template <>
+inline void VoicePack::getSamples<Oscillator::TriangleWave>(
+        real_t* _x, real_t* _r, const int _n) const
+{
+    standardSamples(WaveFormStandard::TRIANGLE, _x, _r, _n);
+}
+
+template <>
+inline void VoicePack::getSamples<Oscillator::SawWave>(real_t*   _x,
+                                                       real_t*   _r,
+                                                       const int _n) const
+{
+    standardSamples(WaveFormStandard::RAMP, _x, _r, _n);
+}
+
+template <>
+inline void VoicePack::getSamples<Oscillator::SquareWave>(real_t*   _x,
+                                                          real_t*   _r,
+                                                          const int _n) const
+{
+    standardSamples(WaveFormStandard::SQUARE, _x, _r, _n);
+}
+
+template <>
+inline void VoicePack::getSamples<Oscillator::MoogSawWave>(
+        real_t* _x, real_t* _r, const int _n) const
+{
+    standardSamples(WaveFormStandard::HARSHRAMP, _x, _r, _n);
+}
+
+template <>
+inline void VoicePack::getSamples<Oscillator::ExponentialWave>(
+        real_t* _x, real_t* _r, const int _n) const
+{
+    standardSamples(WaveFormStandard::SQPEAK, _x, _r, _n);
+}
+
+template <>
+inline void VoicePack::getSamples<Oscillator::WhiteNoise>(real_t*   _x,
+                                                          real_t*   _r,
+                                                          const int _n) const
+{
+    for(int k = 0; k < _n; ++k)
+        _r[k] = Oscillator::noiseSample(_x[k]);
+}
+
+template <>
+inline void VoicePack::getSamples<Oscillator::UserDefinedWave>(
+        real_t* _x, real_t* _r, const int _n) const
+{
+    for(int k = 0; k < _n; ++k)
+        _r[k] = m_userWave->userWaveSample(_x[k]);
+}
+
+VoicePack::VoicePack() :
+      m_waveShapeModel(nullptr), m_modulationAlgoModel(nullptr),
+      m_subPack(nullptr), m_userWave(nullptr), m_size(0)
+{
+}
+
+void VoicePack::setModels(const IntModel* _waveShapeModel,
+                          const IntModel* _modAlgoModel,
+                          VoicePack*      _subPack)
+{
+    m_waveShapeModel      = _waveShapeModel;
+    m_modulationAlgoModel = _modAlgoModel;
+    m_subPack             = _subPack;
+}
+
+int VoicePack::addVoice(const frequency_t& _freq,
+                        const real_t&      _detuning,
+                        const real_t&      _phaseOffset,
+                        const volume_t&    _volume)
+{
+    if(m_size >= LANES)
+        return -1;
+
+    const int l = m_size++;
+
+    m_freq[l]            = &_freq;
+    m_detuning[l]        = &_detuning;
+    m_ext_phaseOffset[l] = &_phaseOffset;
+    m_volume[l]          = &_volume;
+    m_phaseOffset[l]     = _phaseOffset;
+    m_phase[l]           = _phaseOffset;
+    return l;
+}
+
+void VoicePack::update(real_t* _out, const fpp_t _frames)
+{
+    if(m_subPack != nullptr && m_subPack->m_size != m_size)
+    {
+        qWarning("VoicePack::update sub pack has %d voices instead of %d",
+                 m_subPack->m_size, m_size);
+        return;
+    }
+
+    if(m_subPack == nullptr)
+    {
+        updateAlgo<NoModulation>(_out, _frames);
+    }
+    else
+    {
+        switch(m_modulationAlgoModel->value())
+        {
+            case Oscillator::PhaseModulation:
+                updateAlgo<Oscillator::PhaseModulation>(_out, _frames);
+                break;
+            case Oscillator::AmplitudeModulation:
+                updateAlgo<Oscillator::AmplitudeModulation>(_out, _frames);
+                break;
+            case Oscillator::SignalMix:
+                updateAlgo<Oscillator::SignalMix>(_out, _frames);
+                break;
+            case Oscillator::SynchronizedBySubOsc:
+                updateAlgo<Oscillator::SynchronizedBySubOsc>(_out, _frames);
+                break;
+            case Oscillator::FrequencyModulation:
+                updateAlgo<Oscillator::FrequencyModulation>(_out, _frames);
+                break;
+        }
+    }
+
+    // Oscillator::update() outputs silence above the nyquist frequency
+    const frequency_t nyquist = Engine::mixer()->processingSampleRate() / 2;
+    for(int l = 0; l < m_size; ++l)
+        if(*m_freq[l] >= nyquist)
+            for(fpp_t f = 0; f < _frames; ++f)
+                _out[f * m_size + l] = 0.;
+}
+
+template <int A>
+void VoicePack::updateAlgo(real_t* _out, const fpp_t _frames)
+{
+    switch(m_waveShapeModel->value())
+    {
+        case Oscillator::SineWave:
+        default:
+            updateLanes<A, Oscillator::SineWave>(_out, _frames);
+            break;
+        case Oscillator::TriangleWave:
+            updateLanes<A, Oscillator::TriangleWave>(_out, _frames);
+            break;
+        case Oscillator::SawWave:
+            updateLanes<A, Oscillator::SawWave>(_out, _frames);
+            break;
+        case Oscillator::SquareWave:
+            updateLanes<A, Oscillator::SquareWave>(_out, _frames);
+            break;
+        case Oscillator::MoogSawWave:
+            updateLanes<A, Oscillator::MoogSawWave>(_out, _frames);
+            break;
+        case Oscillator::ExponentialWave:
+            updateLanes<A, Oscillator::ExponentialWave>(_out, _frames);
+            break;
+        case Oscillator::WhiteNoise:
+            updateLanes<A, Oscillator::WhiteNoise>(_out, _frames);
+            break;
+        case Oscillator::UserDefinedWave:
+            updateLanes<A, Oscillator::UserDefinedWave>(_out, _frames);
+            break;
+    }
+}
+
+// same as Oscillator::recalcPhase(), for every lane
+void VoicePack::recalcPhases()
+{
+    for(int l = 0; l < m_size; ++l)
+    {
+        m_phase[l] -= m_phaseOffset[l];
+        m_phaseOffset[l] = *m_ext_phaseOffset[l];
+        m_phase[l] += m_phaseOffset[l];
+        m_phase[l] = positivefraction(m_phase[l]) + 2.;
+    }
+}
+
+void VoicePack::syncInit(real_t* _out, const fpp_t _frames, real_t* _coeffs)
+{
+    if(m_subPack != nullptr)
+        m_subPack->update(_out, _frames);
+
+    recalcPhases();
+    for(int l = 0; l < m_size; ++l)
+        _coeffs[l] = *m_freq[l] * *m_detuning[l];
+}
+
+// The modulation is chosen at compile time. Each block is done in three
+// passes: the phases of all the lanes, the waves, then the output. Only
+// the output depends on the wave, so the modulator is applied the same
+// way as in Oscillator.
+template <int A, Oscillator::WaveShapes W>
+void VoicePack::updateLanes(real_t* _out, const fpp_t _frames)
+{
+    const int n = m_size;
+
+    real_t subCoeff[LANES];
+    if(A == Oscillator::SynchronizedBySubOsc)
+        m_subPack->syncInit(_out, _frames, subCoeff);
+    else if(A != NoModulation)
+        m_subPack->update(_out, _frames);
+
+    recalcPhases();
+
+    real_t coeff[LANES];
+    real_t volume[LANES];
+    for(int l = 0; l < n; ++l)
+    {
+        coeff[l]  = *m_freq[l] * *m_detuning[l];
+        volume[l] = *m_volume[l];
+    }
+
+    const real_t sampleRateCorrection
+            = 44100. / Engine::mixer()->processingSampleRate();
+
+    real_t  x[BLOCK_FRAMES * LANES];
+    real_t  r[BLOCK_FRAMES * LANES];
+    real_t* phase = m_phase;
+    for(fpp_t f0 = 0; f0 < _frames; f0 += BLOCK_FRAMES)
+    {
+        const int frames = qMin<int>(BLOCK_FRAMES, _frames - f0);
+        real_t*   s      = _out + f0 * n;
+
+        for(int f = 0; f < frames; ++f)
+        {
+            for(int l = 0; l < n; ++l)
+            {
+                const int i = f * n + l;
+                switch(A)
+                {
+                    case Oscillator::PhaseModulation:
+                        x[i] = phase[l] + s[i];
+                        break;
+                    case Oscillator::SynchronizedBySubOsc:
+                    {
+                        // same as Oscillator::syncOk()
+                        real_t&      subPhase = m_subPack->m_phase[l];
+                        const real_t v1       = subPhase;
+                        subPhase += subCoeff[l];
+                        if(floor(subPhase) > floor(v1))
+                            phase[l] = m_phaseOffset[l];
+                        x[i] = phase[l];
+                        break;
+                    }
+                    case Oscillator::FrequencyModulation:
+                        phase[l] += s[i] * sampleRateCorrection;
+                        x[i] = phase[l];
+                        break;
+                    default:
+                        x[i] = phase[l];
+                        break;
+                }
+                phase[l] += coeff[l];
+            }
+        }
+
+        getSamples<W>(x, r, frames * n);
+
+        for(int f = 0; f < frames; ++f)
+        {
+            for(int l = 0; l < n; ++l)
+            {
+                const int i = f * n + l;
+                switch(A)
+                {
+                    case Oscillator::AmplitudeModulation:
+                        s[i] *= r[i] * volume[l];
+                        break;
+                    case Oscillator::SignalMix:
+                        s[i] += r[i] * volume[l];
+                        break;
+                    default:
+                        s[i] = r[i] * volume[l];
+                        break;
+                }
+            }
+        }
+    }
+}
@@ -616,6 +616,35 @@ real_t WaveForm::f(const real_t          _x,
     return r;
 }
 
+// x must be between 0. and 1.
+void WaveForm::f(const real_t* _x, real_t* _r, const int _n) const
+{
+    if(!m_built)
+        const_cast<WaveForm*>(this)->build();
+
+    if(m_mode != Linear || m_data == nullptr)
+    {
+        for(int k = 0; k < _n; ++k)
+            _r[k] = f(_x[k], m_mode);
+        return;
+    }
+
+    const real_t* data = m_data;
+    const int     size = m_size;
+    for(int k = 0; k < _n; ++k)
+    {
+        const real_t j = _x[k] * size;
+        const int    i = j;  // int()
+        if(i < 0 || i > size)
+        {
+            // reports the error
+            _r[k] = f(_x[k], m_mode);
+            continue;
+        }
+        _r[k] = linearInterpolate(data[i], data[i + 1], j - i);
+    }
+}
+
 // x must be between 0. and 1.
 real_t WaveForm::f(const real_t _x, const interpolation_t _m) const
 {
@@ -65,7 +65,7 @@ void AudioDevice::processNextBuffer()
     if(frames)
     {
         //, mixer()->masterGain());
-        writeBuffer(m_buffer, frames);
+        deliverBuffer(m_buffer, frames);
     }
     else
     {
@@ -0,0 +1,109 @@
+/*
+ * AudioEncoderThread.cpp - encodes the periods of a file device in the
+ *                          background
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AudioEncoderThread.h"
+
+#include "AudioFileDevice.h"
+
+#include <cstring>
+
+AudioEncoderThread::AudioEncoderThread(AudioFileDevice* _device,
+                                       const fpp_t      _frames,
+                                       const int        _periods) :
+      m_device(_device),
+      m_frames(_frames), m_size(qMax(_periods, 2)), m_ring(nullptr),
+      m_write(0), m_read(0), m_free(m_size), m_used(0), m_pushed(0),
+      m_stalls(0)
+{
+    setObjectName("encoder " + _device->outputFile());
+
+    m_ring = new Period[m_size];
+    for(int i = 0; i < m_size; ++i)
+    {
+        m_ring[i].buffer = new surroundSampleFrame[m_frames];
+        m_ring[i].frames = 0;
+    }
+}
+
+AudioEncoderThread::~AudioEncoderThread()
+{
+    if(isRunning())
+        finish();
+
+    for(int i = 0; i < m_size; ++i)
+        delete[] m_ring[i].buffer;
+    delete[] m_ring;
+}
+
+void AudioEncoderThread::push(const surroundSampleFrame* _buf,
+                              const fpp_t                _frames)
+{
+    // the period size is fixed during an export, split anything bigger
+    for(fpp_t done = 0; done < _frames; done += m_frames)
+    {
+        if(!m_free.tryAcquire())
+        {
+            // the encoder is behind
+            ++m_stalls;
+            m_free.acquire();
+        }
+
+        const int w     = m_write.load(std::memory_order_relaxed);
+        Period&   p     = m_ring[w % m_size];
+        p.frames        = qMin<fpp_t>(m_frames, _frames - done);
+        memcpy(p.buffer, _buf + done, p.frames * sizeof(surroundSampleFrame));
+
+        m_write.store(w + 1, std::memory_order_release);
+        m_used.release();
+        ++m_pushed;
+    }
+}
+
+void AudioEncoderThread::finish()
+{
+    // a token without a period ends the loop once the ring is empty
+    m_used.release();
+    wait();
+
+    if(m_stalls > 0)
+        qInfo("AudioEncoderThread: %s, %d periods, waited %d times",
+              qPrintable(m_device->outputFile()), m_pushed, m_stalls);
+}
+
+void AudioEncoderThread::run()
+{
+    for(;;)
+    {
+        m_used.acquire();
+
+        const int r = m_read.load(std::memory_order_relaxed);
+        if(r == m_write.load(std::memory_order_acquire))
+            break;
+
+        const Period& p = m_ring[r % m_size];
+        m_device->writeBuffer(p.buffer, p.frames);
+
+        m_read.store(r + 1, std::memory_order_release);
+        m_free.release();
+    }
+}
@@ -27,8 +27,12 @@
 #include <QTemporaryFile>
 
 #include "AudioFileDevice.h"
+#include "AudioEncoderThread.h"
+#include "ConfigManager.h"
 #include "ExportProjectDialog.h"
 #include "GuiApplication.h"
+#include "Mixer.h"
+#include "ValueBuffer.h"
 
 
 AudioFileDevice::AudioFileDevice( OutputSettings const & outputSettings,
@@ -40,7 +44,12 @@ AudioFileDevice::AudioFileDevice( OutputSettings const & outputSettings,
 	m_outputFile( NULL ),
 	m_useTmpFile( false ),
 	m_useStdout ( false ),
-	m_outputSettings(outputSettings)
+	m_outputSettings(outputSettings),
+	m_encoder( NULL ),
+	m_capturing( false ),
+	m_captureFrames( 0 ),
+	m_captureBuffer( NULL ),
+	m_resampleBuffer( NULL )
 {
 	setSampleRate( outputSettings.getSampleRate() );
 }
@@ -50,8 +59,113 @@ AudioFileDevice::AudioFileDevice( OutputSettings const & outputSettings,
 
 AudioFileDevice::~AudioFileDevice()
 {
+	// should have been stopped before the subclass flushed its encoder
+	stopEncoder();
 	closeOutputFile();
 	if(m_outputFile) delete m_outputFile;
+	delete[] m_captureBuffer;
+	delete[] m_resampleBuffer;
+}
+
+
+
+
+void AudioFileDevice::setCapturing( bool _on )
+{
+	// the period size is fixed during an export
+	const fpp_t frames = mixer()->framesPerPeriod();
+	if( _on && m_captureFrames < frames )
+	{
+		delete[] m_captureBuffer;
+		delete[] m_resampleBuffer;
+		m_captureBuffer = new surroundSampleFrame[frames];
+		m_resampleBuffer = new surroundSampleFrame[frames];
+		m_captureFrames = frames;
+	}
+	m_capturing = _on;
+}
+
+
+
+
+void AudioFileDevice::writeCaptured( const sampleFrame* _buf,
+					const fpp_t _frames,
+					const real_t _gain,
+					const ValueBuffer* _gains )
+{
+	if( !m_capturing || _frames > m_captureFrames )
+		return;
+
+	const real_t* gains = _gains != NULL ? _gains->values() : NULL;
+	for( fpp_t f = 0; f < _frames; ++f )
+	{
+		const real_t g = gains != NULL ? gains[f] : _gain;
+		for( ch_cnt_t ch = 0; ch < SURROUND_CHANNELS; ++ch )
+		{
+			m_captureBuffer[f][ch] = _buf != NULL
+				? _buf[f][ch % DEFAULT_CHANNELS] * g : 0.;
+		}
+	}
+
+	surroundSampleFrame* b = m_captureBuffer;
+	if( mixer()->processingSampleRate() != sampleRate() )
+	{
+		resample( m_captureBuffer, _frames, m_resampleBuffer,
+				mixer()->processingSampleRate(), sampleRate() );
+		b = m_resampleBuffer;
+	}
+
+	deliverBuffer( b, _frames );
+}
+
+
+
+
+void AudioFileDevice::startEncoder()
+{
+	for( AudioFileDevice* dev : m_mirrors )
+		dev->startEncoder();
+
+	if( m_encoder != NULL ||
+		!ConfigManager::inst()->value( "mixer", "backgroundencoding",
+						"1" ).toInt() )
+		return;
+
+	// about one second of audio at the default period size
+	m_encoder = new AudioEncoderThread( this,
+					mixer()->framesPerPeriod(), 128 );
+	m_encoder->start();
+}
+
+
+
+
+void AudioFileDevice::stopEncoder()
+{
+	if( m_encoder != NULL )
+	{
+		m_encoder->finish();
+		delete m_encoder;
+		m_encoder = NULL;
+	}
+
+	for( AudioFileDevice* dev : m_mirrors )
+		dev->stopEncoder();
+}
+
+
+
+
+void AudioFileDevice::deliverBuffer( const surroundSampleFrame* _buf,
+					const fpp_t _frames )
+{
+	for( AudioFileDevice* dev : m_mirrors )
+		dev->deliverBuffer( _buf, _frames );
+
+	if( m_encoder != NULL )
+		m_encoder->push( _buf, _frames );
+	else
+		writeBuffer( _buf, _frames );
 }
 
 
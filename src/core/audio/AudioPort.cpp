@@ -25,8 +25,10 @@
 #include "AudioPort.h"
 
 #include "AudioDevice.h"
+#include "AudioFileDevice.h"
 #include "Backtrace.h"
 #include "BufferManager.h"
+#include "Configuration.h"
 #include "EffectChain.h"
 #include "Engine.h"
 #include "FxMixer.h"
@@ -56,13 +58,17 @@ AudioPort::AudioPort(const QString& _name,
               "AudioPort::m_processingLock", QMutex::Recursive, false),
       m_extOutputEnabled(false), m_nextFxChannel(0), m_name(_name),
       m_effects(_hasEffectChain ? new EffectChain(nullptr) : nullptr),
-      m_playHandles(true), m_volumeEnabledModel(volumeEnabledModel),
+      m_playHandles(PlayHandle::AudioPortHook,
+                    qMax(int(PlayHandle::MaxNumber),
+                         CONFIG_GET_INT("mixer.maxplayhandlesperport"))),
+      m_volumeEnabledModel(volumeEnabledModel),
       m_volumeModel(volumeModel), m_panningEnabledModel(panningEnabledModel),
       m_panningModel(panningModel),
       m_bendingEnabledModel(bendingEnabledModel),
       m_bendingModel(bendingModel), m_mutedModel(mutedModel),
       m_frozenModel(frozenModel), m_clippingModel(clippingModel),
-      m_frozenBuf(nullptr), m_pointer(nullptr)
+      m_frozenBuf(nullptr), m_stemDevice(nullptr), m_pointer(nullptr),
+      m_sourceLatency(0), m_latency(0)
 {
     m_pointer = new AudioPortPointer(this);
     if(m_name.isEmpty())
@@ -142,10 +148,27 @@ bool AudioPort::processEffects()
     return false;
 }
 
+void AudioPort::updateLatency()
+{
+    m_latency = m_sourceLatency;
+    if(m_effects)
+        m_latency += m_effects->latency();
+}
+
+void AudioPort::writeStem(bool _hasOutput)
+{
+    if(m_stemDevice != nullptr)
+        m_stemDevice->writeCaptured(_hasOutput ? m_portBuffer : nullptr,
+                                    Engine::mixer()->framesPerPeriod());
+}
+
 void AudioPort::doProcessing()
 {
     if(m_mutedModel != nullptr && m_mutedModel->value())
+    {
+        writeStem(false);
         return;
+    }
 
     lock();
     const Song*   song = Engine::song();
@@ -195,10 +218,15 @@ void AudioPort::doProcessing()
                 */
             }
 
+            // the frozen buffer is recorded before the compensation,
+            // so it is delayed like the live output
+            m_compensation.process(m_portBuffer, fpp, true);
+
             // send output to fx mixer
             Engine::fxMixer()->mixToChannel(m_portBuffer, m_nextFxChannel);
             // TODO: improve the flow here - convert to pull model
             m_bufferUsage = false;
+            writeStem(true);
             unlock();
             return;
         }
@@ -422,7 +450,8 @@ void AudioPort::doProcessing()
     // handle effects
     const bool me = processEffects();
     // qInfo("AudioPort::doProcessing #4 me=%d",me);
-    if(me || m_bufferUsage)
+    const bool hasOutput = me || m_bufferUsage;
+    if(hasOutput)
     {
         /*
         qInfo("AudioPort::doProcessing #5 frozen=%d fb=%p song=%d
@@ -477,6 +506,16 @@ void AudioPort::doProcessing()
                 m_volumeModel->setAutomatedValue(m_volumeModel->rawValue()
                                                  * 0.995);
         }
+    }
+
+    // aligned with the other inputs of the fx channel, the delay keeps
+    // running until its content is out
+    const bool mixed = hasOutput || m_compensation.isPending();
+    if(mixed)
+    {
+        if(!hasOutput)
+            BufferManager::clear(m_portBuffer);
+        m_compensation.process(m_portBuffer, fpp, hasOutput);
 
         // send output to fx mixer
         Engine::fxMixer()->mixToChannel(m_portBuffer, m_nextFxChannel);
@@ -484,6 +523,7 @@ void AudioPort::doProcessing()
         m_bufferUsage = false;
     }
 
+    writeStem(mixed);
     unlock();
 }
 
@@ -501,7 +541,7 @@ void AudioPort::addPlayHandle(PlayHandlePointer _ph)
         return;
     }
 
-    if(!Engine::mixer()->isHM())
+    if(!Engine::mixer()->isHM() && !Mixer::isRenderingThread())
     {
         BACKTRACE
         qWarning("AudioPort::addPlayHandle not HM thread");
@@ -515,7 +555,16 @@ void AudioPort::addPlayHandle(PlayHandlePointer _ph)
 
     // m_playHandleLock.lock();
 
-    m_playHandles.appendUnique(_ph);
+    if(!m_playHandles.appendUnique(_ph))
+    {
+        // full, the handle is finished rather than rendered unmixed
+        qWarning("AudioPort::addPlayHandle full (%d), handle type=%d "
+                 "dropped",
+                 m_playHandles.capacity(), _ph->type());
+        _ph->setFinished();
+        return;
+    }
+    _ph->setMixingPort(this);
 
     // m_playHandleLock.unlock();
 }
@@ -557,7 +606,11 @@ void AudioPort::removePlayHandle(PlayHandlePointer _ph)
     if(_ph->type() == 2)
         qInfo("AudioPort: ready to remove IPH");
 
+    // the handle may still be mixed by doProcessing(), the mixer
+    // synchronizes its own registry before deleting it
     int nh = m_playHandles.removeAll(_ph, false);
+    if(_ph->mixingPort() == this)
+        _ph->setMixingPort(nullptr);
     if(nh == 0)  // One
         qWarning("AudioPort::removePlayHandle handle not found");
     // type=%d", _ph->type());
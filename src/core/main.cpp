@@ -49,6 +49,7 @@
 //#include <csignal> // To register the signal handler
 #endif
 
+#include "BatchRenderer.h"
 #include "MainApplication.h"
 #include "MemoryManager.h"
 //#include "ConfigManager.h"
@@ -72,6 +73,7 @@
 #include "lmmsversion.h"
 #include "versioninfo.h"
 
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QLocale>
 #include <QTimer>
@@ -176,12 +178,20 @@ void printHelp()
            "-a, --float                   32bit float bit depth\n"  // REQUIRED
            "-b, --bitrate <bitrate>       Specify output bitrate in KBit/s\n"
            "       Default: 160.\n"
+           "    --batch <manifest>        Render the jobs of a JSON or CSV "
+           "manifest\n"
+           "       Columns: project, output, format, samplerate, "
+           "interpolation,\n"
+           "       oversampling, bitrate, mode, range.\n"
            "-c, --config <configfile>     Get the configuration from "
            "<configfile>\n"
-           "-d, --dump <in>               Dump XML of compressed file <in>\n"
+           "-d, --dump <in>               Dump XML of compressed or binary "
+           "file <in>\n"
            "-f, --format <format>         Specify format of render-output "
            "where\n"
            "       Format is either 'wav', 'flac', 'ogg' or 'mp3'.\n"
+           "       Several comma-separated formats, like 'wav,flac,mp3',\n"
+           "       are written during the same render.\n"
            "    --geometry <geometry>     Specify the size and position of "
            "the main window\n"
            "       geometry is <xsizexysize+xoffset+yoffsety>.\n"
@@ -195,6 +205,8 @@ void printHelp()
            "          - sincbest\n"
            "    --import <in> [-e]        Import MIDI file <in>.\n"
            "       If -e is specified lmms exits after importing the file.\n"
+           "    --jobs <n>                Number of parallel batch jobs\n"
+           "       Default: half the number of cores.\n"
            "-l, --loop                    Render as a loop\n"
            "-m, --mode                    Stereo mode used for MP3 export\n"
            "       Possible values: s, j, m\n"
@@ -209,16 +221,22 @@ void printHelp()
            "-p, --play                    Play given project file\n"
            "    --profile <out>           Dump profiling information to file "
            "<out>\n"
-           "-r, --render (--song|--channels|--tracks) <project>\n"
+           "    --report <file>           Write the batch report to <file>\n"
+           "       Default: standard out, one JSON object per job.\n"
+           "-r, --render (--song|--channels|--tracks|--stems) <project>\n"
            "                              Render given project file\n"
            "-s, --samplerate <samplerate> Specify output samplerate in Hz\n"
            "       Range: 44100 (default) to 192000\n"
            "--song\n"
            "--channels\n"
            "-t, --tracks\n"
+           "--stems                       Tracks and channels in one pass\n"
            "-u, --upgrade <in> [out]      Upgrade file <in> and save as "
            "<out>\n"
            "       Standard out is used if no output file is specifed\n"
+           "       The format of <out> follows its extension: mmp, mmpz "
+           "or lsmmb\n"
+           "       (chunked binary), so it also converts the projects.\n"
            "-v, --version                 Show version information and "
            "exit.\n"
            "    --allowroot               Bypass root user startup check "
@@ -286,8 +304,10 @@ int main(int argc, char** argv)
     bool    renderLoop      = false;
     bool    renderChannels  = false;
     bool    renderTracks    = false;
+    bool    renderStems     = false;
+    int     batchJobs       = 0;
     QString fileToLoad, fileToImport, playOut, renderOut, testOut,
-            profilerOutputFile, configFile;
+            profilerOutputFile, configFile, batchManifest, batchReport;
 
     // first of two command-line parsing stages
     for(int i = 1; i < argc; ++i)
@@ -297,7 +317,7 @@ int main(int argc, char** argv)
         if(arg == "--help" || arg == "-h" || arg == "--version" || arg == "-v"
            || arg == "--test"
            // arg == "--play"    || arg == "-p" ||
-           || arg == "--render" || arg == "-r")
+           || arg == "--render" || arg == "-r" || arg == "--batch")
         {
             coreOnly = true;
         }
@@ -345,6 +365,8 @@ int main(int argc, char** argv)
                       OutputSettings::Depth_F32,
                       OutputSettings::StereoMode_JointStereo);
     ProjectRenderer::ExportFileFormats eff = ProjectRenderer::WaveFile;
+    // the formats after the first one, written during the same render
+    QVector<ProjectRenderer::ExportFileFormats> mirrorFormats;
 
     // second of two command-line parsing stages
     for(int i = 1; i < argc; ++i)
@@ -415,7 +437,16 @@ int main(int argc, char** argv)
 
             QFile f(QString::fromLocal8Bit(argv[i]));
             f.open(QIODevice::ReadOnly);
-            QString d = qUncompress(f.readAll());
+            const QByteArray data = f.readAll();
+            if(DataFile::isBinary(data))
+            {
+                DataFile    dataFile(data);
+                QTextStream ts(stdout);
+                dataFile.write(ts);
+                fflush(stdout);
+                return EXIT_SUCCESS;
+            }
+            QString d = qUncompress(data);
             printf("%s\n", d.toUtf8().constData());
 
             return EXIT_SUCCESS;
@@ -455,6 +486,51 @@ int main(int argc, char** argv)
             */
             renderOut = "yes";  // fileToLoad;
         }
+        else if(arg == "--batch")
+        {
+            ++i;
+
+            if(i == argc)
+            {
+                qWarning(
+                        "Error: No manifest specified.\n"
+                        "     : Try \"%s --help\" for more information.",
+                        argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            batchManifest = QString::fromLocal8Bit(argv[i]);
+        }
+        else if(arg == "--jobs")
+        {
+            ++i;
+
+            if(i == argc || QString(argv[i]).toInt() <= 0)
+            {
+                qWarning(
+                        "Error: Invalid number of jobs.\n"
+                        "     : Try \"%s --help\" for more information.",
+                        argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            batchJobs = QString(argv[i]).toInt();
+        }
+        else if(arg == "--report")
+        {
+            ++i;
+
+            if(i == argc)
+            {
+                qWarning(
+                        "Error: No report file specified.\n"
+                        "     : Try \"%s --help\" for more information.",
+                        argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            batchReport = QString::fromLocal8Bit(argv[i]);
+        }
         else if(arg == "--loop" || arg == "-l")
         {
             renderLoop = true;
@@ -463,16 +539,25 @@ int main(int argc, char** argv)
         {
             renderChannels = true;
             renderTracks   = false;
+            renderStems    = false;
         }
         else if(arg == "--song")
         {
             renderChannels = false;
             renderTracks   = false;
+            renderStems    = false;
         }
         else if(arg == "--tracks" || arg == "-t")
         {
             renderChannels = false;
             renderTracks   = true;
+            renderStems    = false;
+        }
+        else if(arg == "--stems")
+        {
+            renderChannels = false;
+            renderTracks   = false;
+            renderStems    = true;
         }
         else if(arg == "--output" || arg == "-o")
         {
@@ -502,39 +587,50 @@ int main(int argc, char** argv)
                 return EXIT_FAILURE;
             }
 
-            const QString ext = QString(argv[i]);
+            const QStringList exts = QString(argv[i]).split(',');
 
-            if(ext == "wav")
+            mirrorFormats.clear();
+            for(const QString& ext: exts)
             {
-                eff = ProjectRenderer::WaveFile;
-            }
+                ProjectRenderer::ExportFileFormats fmt;
+                if(ext == "wav")
+                {
+                    fmt = ProjectRenderer::WaveFile;
+                }
 #ifdef LMMS_HAVE_OGGVORBIS
-            else if(ext == "ogg")
-            {
-                eff = ProjectRenderer::OggFile;
-            }
+                else if(ext == "ogg")
+                {
+                    fmt = ProjectRenderer::OggFile;
+                }
 #endif
 #ifdef LMMS_HAVE_MP3LAME
-            else if(ext == "mp3")
-            {
-                eff = ProjectRenderer::MP3File;
-            }
+                else if(ext == "mp3")
+                {
+                    fmt = ProjectRenderer::MP3File;
+                }
 #endif
-            else if(ext == "flac")
-            {
-                eff = ProjectRenderer::FlacFile;
-            }
-            else if(ext == "au")
-            {
-                eff = ProjectRenderer::AUFile;
-            }
-            else
-            {
-                qWarning(
-                        "Error: Invalid output format %s.\n"
-                        "     : Try \"%s --help\" for more information.",
-                        argv[i], argv[0]);
-                return EXIT_FAILURE;
+                else if(ext == "flac")
+                {
+                    fmt = ProjectRenderer::FlacFile;
+                }
+                else if(ext == "au")
+                {
+                    fmt = ProjectRenderer::AUFile;
+                }
+                else
+                {
+                    qWarning(
+                            "Error: Invalid output format %s.\n"
+                            "     : Try \"%s --help\" for more "
+                            "information.",
+                            qPrintable(ext), argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if(&ext == &exts.first())
+                    eff = fmt;
+                else
+                    mirrorFormats.append(fmt);
             }
         }
         else if(arg == "--samplerate" || arg == "-s")
@@ -863,10 +959,25 @@ int main(int argc, char** argv)
         qWarning("Error: Signal initialization failed.");
 #endif
 
-    bool destroyEngine = false;
+    bool           destroyEngine = false;
+    real_t         renderAudioMs = 0.;
+    QElapsedTimer  renderTimer;
+    BatchRenderer* batch = nullptr;
     // qWarning("Test: OP '%s'", qPrintable(testOut));
 
-    if(!testOut.isEmpty())
+    if(!batchManifest.isEmpty())
+    {
+        // the jobs are rendered by child processes, no engine here
+        batch = new BatchRenderer(batchManifest, batchJobs, batchReport,
+                                  app);
+        if(!batch->load())
+            exit(EXIT_FAILURE);
+
+        QCoreApplication::instance()->connect(batch, SIGNAL(finished()),
+                                              SLOT(quit()));
+        QTimer::singleShot(0, batch, SLOT(start()));
+    }
+    else if(!testOut.isEmpty())
     {
         // qWarning("Test: Engine::init");
         Engine::init(true);
@@ -898,7 +1009,7 @@ int main(int argc, char** argv)
 
         // When rendering multiple tracks, renderOut is a directory
         // otherwise, it is a file, so we need to append the file extension
-        if(!renderChannels && !renderTracks)
+        if(!renderChannels && !renderTracks && !renderStems)
         {
             if(renderOut != "-")
             {
@@ -939,8 +1050,18 @@ int main(int argc, char** argv)
 
         Engine::getSong()->setExportLoop(renderLoop);
 
+        // length of the rendered audio, for the render-stats line
+        const std::pair<MidiTime, MidiTime> endpoints
+                = Engine::getSong()->getExportEndpoints();
+        renderAudioMs = MidiTime::ticksToMilliseconds(
+                endpoints.second.getTicks() - endpoints.first.getTicks(),
+                Engine::getSong()->getTempo());
+        renderTimer.start();
+
         // create renderer
         RenderManager* r = new RenderManager(qs, os, eff, renderOut);
+        for(ProjectRenderer::ExportFileFormats fmt: mirrorFormats)
+            r->addFormat(fmt);
         QCoreApplication::instance()->connect(r, SIGNAL(finished()),
                                               SLOT(quit()));
 
@@ -965,6 +1086,11 @@ int main(int argc, char** argv)
             PL_BEGIN("Tracks Rendering")
             r->renderTracks();
         }
+        else if(renderStems)
+        {
+            PL_BEGIN("Stems Rendering")
+            r->renderStems();
+        }
         else
         {
             PL_BEGIN("Project Rendering")
@@ -1214,7 +1340,9 @@ int main(int argc, char** argv)
     // QThread::currentThread()->setPriority(QThread::LowPriority);
 
     // DEBUG_THREAD_PRINT
-    const int ret = app->exec();
+    int ret = app->exec();
+    if(batch != nullptr && batch->numFailed() > 0 && ret == 0)
+        ret = EXIT_FAILURE;
     delete app;
 
     if(!renderOut.isEmpty())
@@ -1227,6 +1355,10 @@ int main(int argc, char** argv)
         {
             PL_END("Tracks Rendering")
         }
+        else if(renderStems)
+        {
+            PL_END("Stems Rendering")
+        }
         else
         {
             PL_END("Project Rendering")
@@ -1238,6 +1370,12 @@ int main(int argc, char** argv)
         {
             printf("\n");
         }
+
+        // parsed by the batch renderer
+        if(renderOut != "-")
+            printf("render-stats audio_ms=%.0f elapsed_ms=%lld\n",
+                   double(renderAudioMs), (long long)renderTimer.elapsed());
+        fflush(stdout);
     }
 
     // TODO: use aboutToQuit() signal
@@ -1062,7 +1062,7 @@ void FileItem::determineFileType(void)
     m_handling = NotSupported;
 
     const QString ext = extension();
-    if(ext == "mmp" || ext == "mpt" || ext == "mmpz")
+    if(ext == "mmp" || ext == "mpt" || ext == "mmpz" || ext == "lsmmb")
     {
         m_type     = ProjectFile;
         m_handling = LoadAsProject;
@@ -109,7 +109,7 @@ MainWindow::MainWindow() :
     emit initProgress(tr("Preparing file browsers"));
     sideBar->appendTab(new FileBrowser(
             confMgr->userProjectsDir() + "*" + confMgr->factoryProjectsDir(),
-            "*.mmp *.mmpz *.xml *.mid", tr("My Projects"),
+            "*.mmp *.mmpz *.lsmmb *.xml *.mid", tr("My Projects"),
             embed::getIconPixmap("project_file")
                     .transformed(QTransform().rotate(90)),
             splitter, false, true));
@@ -930,7 +930,7 @@ void MainWindow::openProject()
     if(mayChangeProject(false))
     {
         FileDialog ofd(this, tr("Open Project"), "",
-                       tr("LMMS (*.mmp *.mmpz)"));
+                       tr("LMMS (*.mmp *.mmpz *.lsmmb)"));
 
         ofd.setDirectory(ConfigManager::inst()->userProjectsDir());
         ofd.setFileMode(FileDialog::AnyFile);  // ExistingFile);
@@ -1025,7 +1025,7 @@ bool MainWindow::saveProject()
 bool MainWindow::saveProjectAs()
 {
     VersionedSaveDialog sfd(this, tr("Save Project"), "",
-                            tr("LMMS Project") + " (*.mmpz *.mmp);;"
+                            tr("LMMS Project") + " (*.mmpz *.mmp *.lsmmb);;"
                                     + tr("LMMS Project Template")
                                     + " (*.mpt)");
     QString             f = Engine::getSong()->projectFileName();
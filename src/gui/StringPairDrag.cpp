@@ -149,7 +149,8 @@ StringPair StringPairDrag::convertExternal(const QMimeData* _md)
     {
         const QList<QUrl> urls = _md->urls();
 
-        QStringList projectfile      = QString("mmp|mpt|mmpz").split('|');
+        QStringList projectfile
+                = QString("mmp|mpt|mmpz|lsmmb").split('|');
         QStringList presetfile       = QString("xpf|xml").split('|');
         QStringList pluginpresetfile = QString("xiz").split('|');
         QStringList samplefile
@@ -332,6 +332,9 @@ void InstrumentTrack::processAudioBuffer(sampleFrame*    buf,
         return;
     }
 
+    // used by the mixer for the delay compensation
+    m_audioPort->setSourceLatency(m_instrument->latency());
+
     // Test for silent input data if instrument provides a single stream only
     // (i.e. driven by InstrumentPlayHandle) We could do that in all other
     // cases as well but the overhead for silence test is bigger than what we
@@ -487,7 +490,7 @@ void InstrumentTrack::addMidiNote(const int      _key,
                 _channel, NotePlayHandle::OriginMidiInput);
         // n->incrRefCount();
         m_notes[_key] = n;
-        Engine::mixer()->emit playHandleToAdd(n->pointer());
+        Engine::mixer()->addPlayHandle(n->pointer());
         m_midiNotesMutex.unlock();
     }
     else
@@ -1252,24 +1255,15 @@ bool InstrumentTrack::play(const MidiTime& _start,
             if(p->autoRepeat())
                 cur_start %= ul;
 
-            // get all notes from the given pattern...
-            const Notes& notes = p->notes();
-            // ...and set our index to zero
-            Notes::ConstIterator nit = notes.begin();
-
-            // very effective algorithm for playing notes that are
-            // posated within the current sample-frame
-
-            if(cur_start > 0)
-            {
-                // skip notes which are posated before start-tact
-                while(nit != notes.end() && (*nit)->pos() < cur_start)
-                    ++nit;
-            }
+            // notes starting at this tick, the pattern keeps a cursor
+            // so there is no need to skip the previous ones
+            Notes::ConstIterator nit, nend;
+            p->notesAt(cur_start, nit, nend);
 
             Note* cur_note;
-            while(nit != notes.end() && (cur_note = *nit)->pos() == cur_start)
+            while(nit != nend)
             {
+                cur_note = *nit;
                 if(real_start >= p->length())
                 {
                     ++nit;
@@ -1304,8 +1298,7 @@ bool InstrumentTrack::play(const MidiTime& _start,
                     nph->setSongGlobalParentOffset(p->startPosition());
                 }
 
-                // Engine::mixer()->addPlayHandle(nph);
-                Engine::mixer()->emit playHandleToAdd(nph->pointer());
+                Engine::mixer()->addPlayHandle(nph->pointer());
                 played_a_note = true;
                 ++nit;
             }
@@ -46,6 +46,7 @@
 #include <QPushButton>
 #include <QTimer>
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 
@@ -56,7 +57,8 @@ QPixmap* PatternView::s_stepBtnOffLight = nullptr;
 
 Pattern::Pattern(InstrumentTrack* _instrumentTrack) :
       Tile(_instrumentTrack, tr("Score tile"), "scoreTile"),
-      m_instrumentTrack(_instrumentTrack), m_patternType(MelodyPattern)
+      m_instrumentTrack(_instrumentTrack), m_patternType(MelodyPattern),
+      m_playCursor(0), m_playTick(0)
 {
     setName(_instrumentTrack->name());
     // if(isFixed())
@@ -71,7 +73,7 @@ Pattern::Pattern(InstrumentTrack* _instrumentTrack) :
 Pattern::Pattern(const Pattern& _other) :
       // Tile(_other.m_instrumentTrack, _other.displayName()),
       Tile(_other), m_instrumentTrack(_other.m_instrumentTrack),
-      m_patternType(_other.m_patternType)
+      m_patternType(_other.m_patternType), m_playCursor(0), m_playTick(0)
 {
     for(const Note* note: _other.m_notes)
         m_notes.append(new Note(*note));
@@ -94,6 +96,52 @@ Pattern::~Pattern()
     m_notes.clear();
 }
 
+void Pattern::notesAt(tick_t                 _tick,
+                      Notes::const_iterator& _first,
+                      Notes::const_iterator& _last) const
+{
+    if(!m_playNotes.isSharedWith(m_notes))
+    {
+        // edited since the last call
+        m_playNotes  = m_notes;
+        m_playCursor = 0;
+        m_playTick   = 0;
+    }
+
+    const Notes::const_iterator begin = m_playNotes.constBegin();
+    const Notes::const_iterator end   = m_playNotes.constEnd();
+
+    Notes::const_iterator it = end;
+    if(_tick >= m_playTick && m_playCursor <= m_playNotes.size())
+    {
+        // playing forward, the notes are just after the cursor
+        it = begin + m_playCursor;
+        for(int i = 0; i < 4 && it != end && (*it)->pos() < _tick; ++i)
+            ++it;
+        if(it != end && (*it)->pos() < _tick)
+            it = std::lower_bound(it, end, _tick,
+                                  [](const Note* n, tick_t t) {
+                                      return n->pos() < t;
+                                  });
+    }
+    else
+    {
+        // loop or seek
+        it = std::lower_bound(begin, end, _tick,
+                              [](const Note* n, tick_t t) {
+                                  return n->pos() < t;
+                              });
+    }
+
+    m_playCursor = it - begin;
+    m_playTick   = _tick;
+
+    _first = it;
+    while(it != end && (*it)->pos() == _tick)
+        ++it;
+    _last = it;
+}
+
 bool Pattern::isEmpty() const
 {
     for(const Note* note: m_notes)
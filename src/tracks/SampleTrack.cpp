@@ -1097,7 +1097,7 @@ bool SampleTrack::play(const MidiTime& _start,
                 SampleRecordHandle* h = new SampleRecordHandle(st);
                 h->setOffset(_offset);
                 // send it to the mixer
-                Engine::mixer()->emit playHandleToAdd(h->pointer());
+                Engine::mixer()->addPlayHandle(h->pointer());
                 played_a_note = true;
             }
             else
@@ -1128,7 +1128,7 @@ bool SampleTrack::play(const MidiTime& _start,
 
                 h->setOffset(_offset);
                 // send it to the mixer
-                Engine::mixer()->emit playHandleToAdd(h->pointer());
+                Engine::mixer()->addPlayHandle(h->pointer());
                 played_a_note = true;
             }
         }
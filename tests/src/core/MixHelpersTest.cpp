@@ -0,0 +1,207 @@
+/*
+ * MixHelpersTest.cpp - the vector kernels against the scalar ones
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include "MixHelpers.h"
+#include "ValueBuffer.h"
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+
+class MixHelpersTest : QTestSuite
+{
+	Q_OBJECT
+private:
+	// not a multiple of any vector size, so the scalar tail runs too
+	static const int FRAMES = 259;
+
+	typedef std::function<bool(sampleFrame*)> Kernel;
+
+	sampleFrame m_src[FRAMES];
+	sampleFrame m_dst[FRAMES];
+	sample_t m_left[FRAMES];
+	sample_t m_right[FRAMES];
+
+	static sample_t random(sample_t _range)
+	{
+		return _range * (2. * qrand() / RAND_MAX - 1.);
+	}
+
+	void fill(bool _dirty)
+	{
+		qsrand(1234);
+		for(int f = 0; f < FRAMES; ++f)
+		{
+			for(int c = 0; c < DEFAULT_CHANNELS; ++c)
+			{
+				// some clipping and some silent samples
+				m_src[f][c] = random(f % 7 == 0 ? 1.E-11 : 2.);
+				m_dst[f][c] = random(1.);
+			}
+			m_left[f] = random(1.);
+			m_right[f] = random(1.);
+		}
+
+		if(_dirty)
+		{
+			m_src[3][0] = std::numeric_limits<sample_t>::infinity();
+			m_src[17][1] = -std::numeric_limits<sample_t>::infinity();
+			m_src[FRAMES - 2][0] = std::numeric_limits<sample_t>::quiet_NaN();
+		}
+	}
+
+	// runs the kernel with every instruction set and compares the bits
+	void compare(const Kernel& _kernel, bool _dirty = false)
+	{
+		const MixHelpers::Isa current = MixHelpers::isa();
+
+		sampleFrame expected[FRAMES];
+		fill(_dirty);
+		QVERIFY(MixHelpers::setIsa(MixHelpers::Isa_Scalar));
+		const bool expectedResult = _kernel(m_dst);
+		memcpy(expected, m_dst, sizeof(expected));
+
+		for(int i = MixHelpers::Isa_SSE2; i <= MixHelpers::Isa_AVX512; ++i)
+		{
+			const MixHelpers::Isa isa = MixHelpers::Isa(i);
+			if(!MixHelpers::setIsa(isa))
+			{
+				qInfo("MixHelpersTest: %s not supported", MixHelpers::isaName(isa));
+				continue;
+			}
+
+			fill(_dirty);
+			const bool result = _kernel(m_dst);
+			QCOMPARE(result, expectedResult);
+			QVERIFY2(memcmp(expected, m_dst, sizeof(expected)) == 0,
+				MixHelpers::isaName(isa));
+		}
+
+		MixHelpers::setIsa(current);
+	}
+
+private slots:
+	void DetectionTests()
+	{
+		QVERIFY(MixHelpers::isaSupported(MixHelpers::Isa_Scalar));
+		QVERIFY(MixHelpers::isaSupported(MixHelpers::isa()));
+	}
+
+	void AddTests()
+	{
+		compare([this](sampleFrame* _dst) {
+			MixHelpers::add(_dst, m_src, FRAMES);
+			return true;
+		});
+		compare([this](sampleFrame* _dst) {
+			MixHelpers::addSanitized(_dst, m_src, FRAMES);
+			return true;
+		}, true);
+		compare([this](sampleFrame* _dst) {
+			MixHelpers::addMultiplied(_dst, m_src, 0.7, FRAMES);
+			return true;
+		});
+		compare([this](sampleFrame* _dst) {
+			MixHelpers::addSwappedMultiplied(_dst, m_src, 0.7, FRAMES);
+			return true;
+		});
+		compare([this](sampleFrame* _dst) {
+			MixHelpers::addSanitizedMultiplied(_dst, m_src, 0.7, FRAMES);
+			return true;
+		}, true);
+		compare([this](sampleFrame* _dst) {
+			MixHelpers::addMultipliedStereo(_dst, m_src, 0.3, 0.9, FRAMES);
+			return true;
+		});
+		compare([this](sampleFrame* _dst) {
+			MixHelpers::multiplyAndAddMultiplied(_dst, m_src, 0.4, 0.6, FRAMES);
+			return true;
+		});
+		compare([this](sampleFrame* _dst) {
+			MixHelpers::multiplyAndAddMultipliedJoined(_dst, m_left, m_right,
+				0.4, 0.6, FRAMES);
+			return true;
+		});
+	}
+
+	void AddByBufferTests()
+	{
+		ValueBuffer vb1(FRAMES);
+		ValueBuffer vb2(FRAMES);
+		for(int f = 0; f < FRAMES; ++f)
+		{
+			vb1.set(f, real_t(f) / FRAMES);
+			vb2.set(f, 1. - real_t(f) / FRAMES);
+		}
+
+		compare([this, &vb1](sampleFrame* _dst) {
+			MixHelpers::addMultiplied(_dst, m_src, &vb1, FRAMES);
+			return true;
+		});
+		compare([this, &vb1](sampleFrame* _dst) {
+			MixHelpers::addMultipliedByBuffer(_dst, m_src, 0.7, &vb1, FRAMES);
+			return true;
+		});
+		compare([this, &vb1, &vb2](sampleFrame* _dst) {
+			MixHelpers::addMultipliedByBuffers(_dst, m_src, &vb1, &vb2, FRAMES);
+			return true;
+		});
+		compare([this, &vb1](sampleFrame* _dst) {
+			MixHelpers::addSanitizedMultipliedByBuffer(_dst, m_src, 0.7, &vb1,
+				FRAMES);
+			return true;
+		}, true);
+		compare([this, &vb1, &vb2](sampleFrame* _dst) {
+			MixHelpers::addSanitizedMultipliedByBuffers(_dst, m_src, &vb1, &vb2,
+				FRAMES);
+			return true;
+		}, true);
+	}
+
+	void InPlaceTests()
+	{
+		// the kernels work on the source buffer here
+		compare([this](sampleFrame*) {
+			return MixHelpers::isClipping(m_src, FRAMES);
+		});
+		compare([](sampleFrame* _dst) {
+			return MixHelpers::isClipping(_dst, FRAMES);
+		});
+		compare([this](sampleFrame* _dst) {
+			memcpy(_dst, m_src, sizeof(m_src));
+			return MixHelpers::sanitize(_dst, FRAMES);
+		}, true);
+		compare([this](sampleFrame* _dst) {
+			memcpy(_dst, m_src, sizeof(m_src));
+			return MixHelpers::sanitize(_dst, FRAMES);
+		});
+		compare([this](sampleFrame* _dst) {
+			memcpy(_dst, m_src, sizeof(m_src));
+			return MixHelpers::unclip(_dst, FRAMES);
+		});
+	}
+} MixHelpersTests;
+
+#include "MixHelpersTest.moc"
@@ -0,0 +1,121 @@
+/*
+ * VoicePackTest.cpp - the voice packs against the oscillators
+ *
+ * Copyright (c) 2020 gi0e5b06 (on github.com)
+ *
+ * This file is part of LSMM -
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include "AutomatableModel.h"
+#include "VoicePack.h"
+
+class VoicePackTest : QTestSuite
+{
+	Q_OBJECT
+private:
+	static const int OSCS = 3;
+	static const int FRAMES = 256;
+	static const int PERIODS = 3;
+
+	frequency_t m_freq;
+	real_t m_detuning[OSCS][2];
+	real_t m_phaseOffset[OSCS][2];
+	volume_t m_volume[OSCS][2];
+
+	// renders the same chain of three oscillators with Oscillator and
+	// with VoicePack, left and right
+	void compare(int _wave, int _algo)
+	{
+		IntModel waveModel(_wave, 0, Oscillator::NumWaveShapes - 1);
+		IntModel algoModel(_algo, 0, Oscillator::NumModulationAlgos - 1);
+
+		m_freq = 440.;
+		for(int i = 0; i < OSCS; ++i)
+			for(int c = 0; c < 2; ++c)
+			{
+				m_detuning[i][c] = (1. + 0.01 * (i + c)) / 44100.;
+				m_phaseOffset[i][c] = 0.1 * i + 0.05 * c;
+				m_volume[i][c] = 0.5 + 0.1 * i - 0.05 * c;
+			}
+
+		Oscillator* oscs[2][OSCS];
+		VoicePack packs[OSCS];
+		for(int i = OSCS - 1; i >= 0; --i)
+		{
+			packs[i].setModels(&waveModel, &algoModel,
+				i == OSCS - 1 ? nullptr : &packs[i + 1]);
+			for(int c = 0; c < 2; ++c)
+			{
+				oscs[c][i] = new Oscillator(&waveModel, &algoModel, m_freq,
+					m_detuning[i][c], m_phaseOffset[i][c], m_volume[i][c],
+					i == OSCS - 1 ? nullptr : oscs[c][i + 1]);
+				QCOMPARE(packs[i].addVoice(m_freq, m_detuning[i][c],
+					m_phaseOffset[i][c], m_volume[i][c]), c);
+			}
+		}
+
+		sampleFrame expected[FRAMES];
+		sampleFrame actual[FRAMES];
+		for(int p = 0; p < PERIODS; ++p)
+		{
+			oscs[0][0]->update(expected, FRAMES, 0);
+			oscs[1][0]->update(expected, FRAMES, 1);
+			packs[0].update(actual[0], FRAMES);
+
+			for(int f = 0; f < FRAMES; ++f)
+				for(int c = 0; c < 2; ++c)
+					QVERIFY2(qAbs(expected[f][c] - actual[f][c]) < 1.E-9,
+						qPrintable(QString("wave=%1 algo=%2 frame=%3")
+							.arg(_wave).arg(_algo).arg(p * FRAMES + f)));
+		}
+
+		// the oscillators delete their sub-oscillators
+		delete oscs[0][0];
+		delete oscs[1][0];
+	}
+
+private slots:
+	void LanesTests()
+	{
+		VoicePack pack;
+		for(int l = 0; l < VoicePack::LANES; ++l)
+			QCOMPARE(pack.addVoice(m_freq, m_detuning[0][0],
+				m_phaseOffset[0][0], m_volume[0][0]), l);
+		QCOMPARE(pack.addVoice(m_freq, m_detuning[0][0],
+			m_phaseOffset[0][0], m_volume[0][0]), -1);
+		QCOMPARE(pack.numVoices(), int(VoicePack::LANES));
+	}
+
+	void ModulationTests()
+	{
+		const int waves[] = { Oscillator::SineWave, Oscillator::TriangleWave,
+			Oscillator::SawWave, Oscillator::SquareWave,
+			Oscillator::MoogSawWave, Oscillator::ExponentialWave };
+		const int algos[] = { Oscillator::PhaseModulation,
+			Oscillator::AmplitudeModulation, Oscillator::SignalMix,
+			Oscillator::SynchronizedBySubOsc,
+			Oscillator::FrequencyModulation };
+
+		for(int w: waves)
+			for(int a: algos)
+				compare(w, a);
+	}
+} VoicePackTests;
+
+#include "VoicePackTest.moc"